@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+#include <chrono>
+#include <cstdio>
+
+namespace mloader::bench {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Case {
+        cstr name;
+        void (*run)();
+    };
+
+    inline vec<Case>& registry() {
+        static vec<Case> cases;
+        return cases;
+    }
+
+    struct Registrar {
+        Registrar(cstr name, void (*run)()) {
+            registry().push_back(Case{name, run});
+        }
+    };
+
+    /// Runs `body` `iterations` times and returns the mean cost in nanoseconds.
+    template<typename Body>
+    f64 measure(usize iterations, Body&& body) {
+        const auto start = Clock::now();
+        for (usize i = 0; i < iterations; ++i) {
+            body(i);
+        }
+        const auto elapsed = std::chrono::duration<f64, std::nano>(Clock::now() - start).count();
+        return iterations ? elapsed / static_cast<f64>(iterations) : 0.0;
+    }
+
+    /// Keeps the optimiser from discarding a computed value.
+    template<typename T>
+    inline void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+} // namespace mloader::bench
+
+#define MLOADER_BENCH(name)                                                                \
+    static void mloader_bench_##name();                                                    \
+    static ::mloader::bench::Registrar mloader_bench_registrar_##name(#name, &mloader_bench_##name); \
+    static void mloader_bench_##name()
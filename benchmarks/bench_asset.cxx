@@ -0,0 +1,32 @@
+#include "bench.hxx"
+
+#include "mloader/asset.hxx"
+#include "mloader/database/memory.hxx"
+
+using mloader::InMemoryDatabase;
+using mloader::TextAsset;
+
+MLOADER_BENCH(asset_payload_access) {
+    std::printf("%10s %14s\n", "assets", "text() ns/op");
+
+    for (usize count : {1, 1000, 100000}) {
+        InMemoryDatabase db;
+        vec<TextAsset> assets;
+        assets.reserve(count);
+        for (usize i = 0; i < count; ++i) {
+            const str rel = "text" + std::to_string(i) + ".txt";
+            db.insert(InMemoryDatabase::PurePath(rel), "payload " + std::to_string(i));
+        }
+        db.load();
+        for (usize i = 0; i < count; ++i) {
+            assets.emplace_back(db, InMemoryDatabase::PurePath("text" + std::to_string(i) + ".txt"));
+            assets.back().touch();
+        }
+
+        constexpr usize iterations = 2000000;
+        const f64 cost = mloader::bench::measure(iterations, [&](usize i) {
+            mloader::bench::keep(assets[i % count].text().size());
+        });
+        std::printf("%10zu %14.1f\n", count, cost);
+    }
+}
@@ -0,0 +1,82 @@
+#include "bench.hxx"
+
+#include "mloader/database/file.hxx"
+
+#include "mtl/fs/tmp.hxx"
+
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <random>
+
+using mloader::FilesystemDatabase;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    /// Creates `count` small files spread over 100 directories.
+    vec<FilesystemDatabase::PurePath> populate(const Path& root, usize count) {
+        vec<FilesystemDatabase::PurePath> files;
+        files.reserve(count);
+        for (usize i = 0; i < count; ++i) {
+            const str dir = "dir" + std::to_string(i % 100);
+            const str rel = dir + "/file" + std::to_string(i) + ".yml";
+            std::filesystem::create_directories(std::filesystem::path(root.string()) / dir);
+            std::ofstream stream((std::filesystem::path(root.string()) / rel).string(), std::ios::binary | std::ios::out);
+            stream << "x: " << i << '\n';
+            files.emplace_back(rel);
+        }
+        return files;
+    }
+
+} // namespace
+
+MLOADER_BENCH(filesystem_db_lookup) {
+    std::printf("%10s %14s %14s\n", "entries", "exists ns/op", "missing ns/op");
+
+    for (usize count : {1000, 10000, 50000}) {
+        directory temp_dir;
+        auto files = populate(temp_dir.path(), count);
+
+        FilesystemDatabase db(temp_dir.path());
+        db.load();
+
+        std::mt19937 rng(1234);
+        std::shuffle(files.begin(), files.end(), rng);
+        const FilesystemDatabase::PurePath missing("dir0/missing.yml");
+
+        constexpr usize iterations = 200000;
+        const f64 hit = mloader::bench::measure(iterations, [&](usize i) {
+            mloader::bench::keep(db.exists(files[i % files.size()]));
+        });
+        const f64 miss = mloader::bench::measure(iterations, [&](usize) {
+            mloader::bench::keep(db.exists(missing));
+        });
+
+        std::printf("%10zu %14.1f %14.1f\n", count, hit, miss);
+    }
+}
+
+MLOADER_BENCH(filesystem_db_batch_resolve) {
+    std::printf("%10s %14s %14s\n", "files", "serial us", "batch us");
+
+    for (usize count : {1000, 5000}) {
+        directory temp_dir;
+        auto files = populate(temp_dir.path(), count);
+
+        FilesystemDatabase db(temp_dir.path());
+        db.load();
+
+        const f64 serial = mloader::bench::measure(1, [&](usize) {
+            for (const auto& file : files) {
+                mloader::bench::keep(db.resolve(file));
+            }
+        });
+        const f64 batch = mloader::bench::measure(1, [&](usize) {
+            mloader::bench::keep(db.resolve(files));
+        });
+
+        std::printf("%10zu %14.1f %14.1f\n", count, serial / 1000.0, batch / 1000.0);
+    }
+}
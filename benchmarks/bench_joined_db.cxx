@@ -0,0 +1,44 @@
+#include "bench.hxx"
+
+#include "mloader/database/file.hxx"
+#include "mloader/database/joined.hxx"
+
+#include "mtl/fs/tmp.hxx"
+
+#include <filesystem>
+#include <fstream>
+
+using mloader::FilesystemDatabase;
+using mloader::JoinedDatabase;
+using mtl::fs::tmp::directory;
+
+MLOADER_BENCH(joined_db_exists) {
+    std::printf("%10s %14s\n", "mounts", "exists ns/op");
+
+    for (usize mounts : {1, 16, 128}) {
+        directory temp_dir;
+        vec<uptr<FilesystemDatabase>> databases;
+        vec<mloader::Database::PurePath> paths;
+        for (usize m = 0; m < mounts; ++m) {
+            const auto dir = temp_dir.path() / ("mod" + std::to_string(m));
+            std::filesystem::create_directories(dir.string());
+            for (usize f = 0; f < 8; ++f) {
+                const str name = "mod" + std::to_string(m) + "_" + std::to_string(f) + ".txt";
+                std::ofstream((dir / name).string()) << name;
+                paths.emplace_back(name);
+            }
+            databases.emplace_back(make_uptr<FilesystemDatabase>(dir));
+        }
+
+        JoinedDatabase joined;
+        for (auto& db : databases) {
+            joined.mount(*db);
+        }
+        joined.load();
+
+        const f64 exists = mloader::bench::measure(1000000, [&](usize i) {
+            mloader::bench::keep(joined.exists(paths[i % paths.size()]));
+        });
+        std::printf("%10zu %14.1f\n", mounts, exists);
+    }
+}
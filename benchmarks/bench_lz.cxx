@@ -0,0 +1,88 @@
+#include "bench.hxx"
+
+#include <cstring>
+
+#include "mloader/database/binary.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/extension/archive/writer.hxx"
+#include "mloader/hash.hxx"
+#include "mloader/lz.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+
+using mloader::BinaryDatabase;
+using mloader::extension::ArchiveEncoder;
+using mloader::extension::ArchiveWriter;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    /// Resolves `rel` and hashes every byte, as a consumer reading the entry would.
+    u64 read_entry(BinaryDatabase& db, const BinaryDatabase::PurePath& rel) {
+        auto handle = db.resolve(rel);
+        return mloader::hash64(handle->data(), handle->size());
+    }
+
+} // namespace
+
+MLOADER_BENCH(lz_decompress) {
+    // Definition-like text: short keys and values with plenty of repetition.
+    str text;
+    for (usize i = 0; text.size() < (4u << 20); ++i) {
+        text += "entry_" + std::to_string(i % 977) + ":\n  parent: base_" + std::to_string(i % 31) +
+                "\n  value: " + std::to_string(i * 7 % 1013) + "\n";
+    }
+    const std::span<const byte> input(reinterpret_cast<const byte*>(text.data()), text.size());
+    const vec<byte> packed = mloader::compress_lz(input);
+    vec<byte> output(text.size());
+
+    const f64 compress = mloader::bench::measure(4, [&](usize) {
+        mloader::bench::keep(mloader::compress_lz(input));
+    });
+    const f64 decompress = mloader::bench::measure(32, [&](usize) {
+        mloader::decompress_lz(packed, output);
+        mloader::bench::keep(output);
+    });
+    if (std::memcmp(output.data(), text.data(), text.size()) != 0) {
+        throw RuntimeError("lz_decompress: round trip mismatch.");
+    }
+
+    std::printf("%12s %12s %10s %16s %16s\n", "bytes", "packed", "ratio", "compress MB/s", "decompress MB/s");
+    std::printf("%12zu %12zu %10.2f %16.0f %16.0f\n", text.size(), packed.size(),
+                static_cast<f64>(text.size()) / static_cast<f64>(packed.size()),
+                static_cast<f64>(text.size()) * 1e3 / compress, static_cast<f64>(text.size()) * 1e3 / decompress);
+
+    // The same entry read back through BinaryDatabase, stored as is and compressed.
+    directory temp_dir;
+    const u64 hash = mloader::hash64(input.data(), input.size());
+    ArchiveEncoder header{};
+    header.extension.name = "bench.lz";
+    {
+        ArchiveWriter writer(temp_dir.path() / "stored.mlda", header);
+        writer.add_file("defs.yml", input.data(), input.size(), hash);
+        writer.finish();
+    }
+    {
+        ArchiveWriter writer(temp_dir.path() / "packed.mlda", header);
+        writer.add_compressed("defs.yml", packed.data(), packed.size(), input.size(), hash);
+        writer.finish();
+    }
+    BinaryDatabase stored(temp_dir.path() / "stored.mlda", BinaryDatabase::Verification::off);
+    BinaryDatabase compressed(temp_dir.path() / "packed.mlda", BinaryDatabase::Verification::off);
+    const BinaryDatabase::PurePath rel("defs.yml");
+    if (read_entry(stored, rel) != hash || read_entry(compressed, rel) != hash) {
+        throw RuntimeError("lz_decompress: archive entry does not match its source.");
+    }
+
+    const f64 stored_read = mloader::bench::measure(32, [&](usize) {
+        mloader::bench::keep(read_entry(stored, rel));
+    });
+    const f64 packed_read = mloader::bench::measure(32, [&](usize) {
+        mloader::bench::keep(read_entry(compressed, rel));
+    });
+    std::printf("%12s %16s %16s\n", "archive", "stored MB/s", "packed MB/s");
+    std::printf("%12s %16.0f %16.0f\n", "read+hash", static_cast<f64>(text.size()) * 1e3 / stored_read,
+                static_cast<f64>(text.size()) * 1e3 / packed_read);
+}
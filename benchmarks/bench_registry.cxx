@@ -0,0 +1,72 @@
+#include "bench.hxx"
+
+#include "mloader/defs/registry.hxx"
+
+#include "mtl/fs/tmp.hxx"
+#include "mtl/serial.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string_view>
+
+using mloader::DefinitionRegistry;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    struct Entry : mloader::Definition {
+        str id;
+
+        VISIT() override {
+            VIEW(id);
+        }
+
+        use const str& identifier() cx override {
+            return id;
+        }
+    };
+
+} // namespace
+
+MLOADER_BENCH(registry_find) {
+    std::printf("%10s %14s %14s\n", "entries", "view ns/op", "symbol ns/op");
+
+    for (usize count : {1000, 100000}) {
+        directory temp_dir;
+        const auto file = temp_dir.path() / "entries.yml";
+        vec<str> ids;
+        {
+            std::ofstream stream(file.string(), std::ios::binary | std::ios::out);
+            for (usize i = 0; i < count; ++i) {
+                ids.emplace_back("entry" + std::to_string(i));
+                stream << "- type: Entry\n  id: " << ids.back() << '\n';
+            }
+        }
+
+        DefinitionRegistry registry;
+        registry.register_type("Entry", [] {
+            return make_uptr<Entry>();
+        });
+        registry.ingest(file);
+
+        std::mt19937 rng(1234);
+        std::shuffle(ids.begin(), ids.end(), rng);
+        vec<DefinitionRegistry::Symbol> symbols;
+        symbols.reserve(ids.size());
+        for (const auto& id : ids) {
+            symbols.emplace_back(registry.id_symbol(id));
+        }
+        const auto type = registry.type_symbol("Entry");
+
+        constexpr usize iterations = 1000000;
+        const f64 view = mloader::bench::measure(iterations, [&](usize i) {
+            mloader::bench::keep(registry.find("Entry", std::string_view(ids[i % ids.size()])));
+        });
+        const f64 symbol = mloader::bench::measure(iterations, [&](usize i) {
+            mloader::bench::keep(registry.find(type, symbols[i % symbols.size()]));
+        });
+
+        std::printf("%10zu %14.1f %14.1f\n", count, view, symbol);
+    }
+}
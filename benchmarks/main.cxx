@@ -0,0 +1,14 @@
+#include "bench.hxx"
+
+#include <cstring>
+
+int main(int argc, char** argv) {
+    for (const auto& bench : mloader::bench::registry()) {
+        if (argc > 1 && std::strstr(bench.name, argv[1]) == nullptr) {
+            continue;
+        }
+        std::printf("== %s\n", bench.name);
+        bench.run();
+    }
+    return 0;
+}
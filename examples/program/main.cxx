@@ -42,16 +42,13 @@ int main() {
     vec<ResourceHandle> handles = database.resolve(scanner.configs());
 
     DefinitionRegistry registry;
-    registry.register_type("House", [] {
-        return make_uptr<House>();
-    });
+    registry.register_type<House>("House");
 
-    registry.ingest(handles);
+    registry.ingest(handles, WorkerPool::shared());
 
-    auto houses = registry.definitions("House");
-    std::cout << "Loaded " << houses.size() << " house definitions\n";
+    std::cout << "Loaded " << registry.each<House>().size() << " house definitions\n";
 
-    if (const auto* house = dynamic_cast<const House*>(registry.find("House", "starter_home"))) {
+    if (const House* house = registry.find<House>("starter_home")) {
         std::cout << "Starter home at " << house->address << " has "
                   << house->bedrooms << " bedrooms and "
                   << (house->has_garage ? "a garage" : "no garage")
@@ -6,12 +6,17 @@
 
 #include "mloader/database/base.hxx"
 #include "mloader/database/registry.hxx"
+#include "mloader/residency.hxx"
 #include "mloader/resource.hxx"
+#include "mloader/worker.hxx"
 
-#include <any>
+#include <chrono>
+#include <exception>
 #include <functional>
+#include <future>
 #include <mutex>
-#include <optional>
+#include <span>
+#include <string_view>
 
 namespace mloader {
 
@@ -25,10 +30,14 @@ namespace mloader {
         text,
     };
 
+    static_assert(static_cast<usize>(AssetType::text) < ASSET_SLOT_COUNT, "every AssetType needs a Resource payload slot");
+
     enum class AssetState : u8 {
         unloaded = 0,
         unparsed = 1,
         parsed = 2,
+        /// request() queued a background load that touch() has not collected yet.
+        pending = 3,
     };
 
     class Asset {
@@ -53,37 +62,119 @@ namespace mloader {
         void bind(Database& database, const Database::PurePath& path);
         void set_path(const Database::PurePath& path);
 
+        /**
+         * Invoked on the worker thread once a requested load finishes and
+         * ready() reports it; `error` is null on success. Requests for an
+         * asset that is already parsed, or whose load already finished, run
+         * it right away on the calling thread.
+         */
+        using Completion = function<void(std::exception_ptr error)>;
+
         void unload() const;
-        void touch() const;
+
+        /**
+         * Resolves and parses the asset on `pool` and returns immediately.
+         * The parsed payload lands in the resource cache, so later accessors
+         * do not parse again. Repeated requests while a load is in flight
+         * share it, and each `done` runs when it finishes.
+         */
+        void request(Completion done = {}) const;
+        void request(WorkerPool& pool, Completion done = {}) const;
+
+        /// @return True once the asset is loaded or its requested load has finished.
+        use bool ready() const;
+
+        /// Blocks until the asset is loaded and parsed; rethrows load failures.
+        const Asset& touch() const;
 
         ResourceHandle handle() const;
 
+        /// Keeps the parsed payload resident through residency trims while the pin lives.
+        use ResidencyPin pin() const;
+
+        /// @return Raw resource bytes, valid while the asset keeps its handle.
+        use std::span<const byte> bytes() const;
+        /// @return Owning copy of the raw resource bytes.
+        use vec<byte> copy() const;
+
     protected:
         Database& ensure_database() const;
         Resource& ensure_resource() const;
 
+        /// Parsed payload of type `Payload`, stored in a Resource slot.
+        template<typename Payload>
+        struct Parsed final : AssetPayload {
+            explicit Parsed(Payload parsed)
+                : value(std::move(parsed)) { tag = type_tag(); }
+
+            static const void* type_tag() noexcept {
+                static const char key = 0;
+                return &key;
+            }
+
+            Payload value;
+        };
+
+        /// Downcasts `parsed`; throws if it holds another payload type.
+        template<typename Payload>
+        static const Payload& value_of(const AssetPayload& parsed);
+
+        template<typename Payload>
+        static uptr<AssetPayload> make_parsed(Payload value) {
+            return make_uptr<Parsed<Payload>>(std::move(value));
+        }
+
+        /**
+         * `Payload` must be the type this asset's parser produces; a mismatch
+         * throws. The reference is valid until the next ResidencyManager::trim()
+         * unless a ResidencyPin from pin() keeps the payload resident.
+         */
         template<typename Payload>
         const Payload& payload() const;
 
-        virtual std::any parse_resource(Resource& resource) const = 0;
+        /**
+         * Parsers are plain functions of the resource rather than virtual
+         * members, so background loads never touch the Asset object, which
+         * may be moved or destroyed while the work is in flight.
+         */
+        using Parser = uptr<AssetPayload> (*)(Resource& resource);
+
+        virtual Parser parser() const = 0;
 
         prop AssetType type() const noexcept { return m_type; }
 
     private:
-        int cache_key() const noexcept;
-        std::optional<std::reference_wrapper<const std::any>> try_cached(Resource& resource) const;
-        const std::any& cache(Resource& resource, std::any value) const;
+        usize slot() const noexcept;
+        static const AssetPayload& parsed(Resource& resource, usize slot, Parser parse);
+        /// Slow path of parsed(): parses under the resource's parse lock and publishes the slot.
+        static const AssetPayload& parse_once(Resource& resource, usize slot, Parser parse);
+        /// @return Heap bytes owned by a parsed payload, charged to the residency budget.
+        static u64 footprint(usize slot, const AssetPayload& payload);
+        void collect() const;
+
+        /// Completions of one requested load; drained by the worker once the result is set.
+        struct Waiters {
+            std::mutex mutex;
+            vec<Completion> callbacks;
+            bool finished = false;
+            std::exception_ptr error;
+        };
 
         mutable Database* m_database = nullptr;
         Database::PurePath m_path;
         mutable ResourceHandle m_handle;
+        mutable std::shared_future<ResourceHandle> m_pending;
+        mutable sptr<Waiters> m_waiters;
         AssetType m_type = AssetType::invalid;
+        /// Resource generation seen on resolve; a newer one means the payloads were evicted.
+        mutable u32 m_generation = 0;
         mutable AssetState m_state = AssetState::unloaded;
     };
 
     class BinaryAsset : public Asset {
     public:
-        using Data = vec<byte>;
+        /// Borrowed from the resource; use copy() for an owning buffer.
+        using Data = std::span<const byte>;
 
         BinaryAsset();
         explicit BinaryAsset(const char* path);
@@ -93,13 +184,26 @@ namespace mloader {
         const Data& data() const;
 
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     class ImageAsset : public Asset {
     public:
+        /**
+         * Decoded image. JPEG goes through libjpeg-turbo and PNG through
+         * libspng when they are built in, with stb_image as the fallback for
+         * those and every other format. The encoded file stays available via
+         * bytes().
+         */
         struct Image {
             str format;
+            u32 width = 0;
+            u32 height = 0;
+            u32 channels = 0;
+            /// Bytes per row of `pixels`.
+            usize stride = 0;
+            /// 8-bit samples, rows top to bottom, `channels` interleaved per pixel.
             vec<byte> pixels;
         };
 
@@ -110,8 +214,12 @@ namespace mloader {
 
         const Image& image() const;
 
+        /// @return True if this build has a decoder for the detected format name.
+        use static bool supports(std::string_view format) noexcept;
+
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     class ShaderAsset : public Asset {
@@ -124,14 +232,16 @@ namespace mloader {
         const str& source() const;
 
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     class SoundAsset : public Asset {
     public:
         struct Sound {
             str format;
-            vec<byte> samples;
+            /// Encoded audio bytes, borrowed from the resource.
+            std::span<const byte> samples;
         };
 
         SoundAsset();
@@ -142,14 +252,16 @@ namespace mloader {
         const Sound& sound() const;
 
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     class FontAsset : public Asset {
     public:
         struct Font {
             str format;
-            vec<byte> payload;
+            /// Font file bytes, borrowed from the resource.
+            std::span<const byte> payload;
         };
 
         FontAsset();
@@ -160,7 +272,8 @@ namespace mloader {
         const Font& font() const;
 
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     class TextAsset : public Asset {
@@ -173,7 +286,8 @@ namespace mloader {
         const str& text() const;
 
     protected:
-        std::any parse_resource(Resource& resource) const override;
+        Parser parser() const override;
+        static uptr<AssetPayload> parse(Resource& resource);
     };
 
     inline Asset::Asset()
@@ -211,12 +325,92 @@ namespace mloader {
     }
 
     inline void Asset::unload() const {
+        m_pending = {};
+        m_waiters.reset();
         m_handle = ResourceHandle();
         m_state = AssetState::unloaded;
     }
 
-    inline void Asset::touch() const {
-        ensure_resource();
+    inline void Asset::request(Completion done) const {
+        request(WorkerPool::shared(), std::move(done));
+    }
+
+    inline void Asset::request(WorkerPool& pool, Completion done) const {
+        if (m_pending.valid()) {
+            if (!done) {
+                return;
+            }
+            std::unique_lock lock(m_waiters->mutex);
+            if (!m_waiters->finished) {
+                m_waiters->callbacks.emplace_back(std::move(done));
+                return;
+            }
+            const std::exception_ptr error = m_waiters->error;
+            lock.unlock();
+            done(error);
+            return;
+        }
+        if (m_state == AssetState::parsed) {
+            if (done) {
+                done(nullptr);
+            }
+            return;
+        }
+
+        // Loading mutates the database, so it stays on the calling thread;
+        // resolve() on a loaded database only reads shared state.
+        Database& db = ensure_database();
+        if (!db.is_loaded()) {
+            db.load();
+        }
+
+        // The promise is fulfilled before `done` runs, so ready() and touch()
+        // already see the result from inside the completion callback.
+        auto result = make_sptr<std::promise<ResourceHandle>>();
+        auto waiters = make_sptr<Waiters>();
+        if (done) {
+            waiters->callbacks.emplace_back(std::move(done));
+        }
+        m_pending = result->get_future().share();
+        m_waiters = waiters;
+        pool.submit([&db, path = m_path, handle = m_handle, slot = slot(), parse = parser(), result, waiters] {
+            std::exception_ptr error;
+            try {
+                ResourceHandle resolved = handle.valid() ? handle : db.resolve(path);
+                parsed(*resolved, slot, parse);
+                result->set_value(std::move(resolved));
+            } catch (...) {
+                error = std::current_exception();
+                result->set_exception(error);
+            }
+            vec<Completion> callbacks;
+            {
+                std::lock_guard lock(waiters->mutex);
+                waiters->finished = true;
+                waiters->error = error;
+                callbacks.swap(waiters->callbacks);
+            }
+            for (auto& callback : callbacks) {
+                callback(error);
+            }
+        });
+        m_state = AssetState::pending;
+    }
+
+    inline bool Asset::ready() const {
+        if (m_pending.valid()) {
+            return m_pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+        return m_state == AssetState::parsed;
+    }
+
+    inline const Asset& Asset::touch() const {
+        Resource& resource = ensure_resource();
+        if (m_state != AssetState::parsed) {
+            parsed(resource, slot(), parser());
+            m_state = AssetState::parsed;
+        }
+        return *this;
     }
 
     inline ResourceHandle Asset::handle() const {
@@ -224,6 +418,20 @@ namespace mloader {
         return m_handle;
     }
 
+    inline ResidencyPin Asset::pin() const {
+        return ResidencyPin(handle());
+    }
+
+    inline std::span<const byte> Asset::bytes() const {
+        const Resource& resource = ensure_resource();
+        return {static_cast<const byte*>(resource.data()), static_cast<usize>(resource.size())};
+    }
+
+    inline vec<byte> Asset::copy() const {
+        const auto view = bytes();
+        return vec<byte>(view.begin(), view.end());
+    }
+
     inline Database& Asset::ensure_database() const {
         if (m_database) {
             return *m_database;
@@ -236,49 +444,73 @@ namespace mloader {
         return *m_database;
     }
 
+    inline void Asset::collect() const {
+        auto pending = std::move(m_pending);
+        m_pending = {};
+        m_waiters.reset();
+        try {
+            m_handle = pending.get();
+        } catch (...) {
+            m_state = AssetState::unloaded;
+            throw;
+        }
+        m_generation = m_handle->generation();
+        m_state = AssetState::parsed;
+    }
+
     inline Resource& Asset::ensure_resource() const {
+        if (m_pending.valid()) {
+            collect();
+        }
+        if (m_handle.valid() && (m_handle->stale() || m_handle->generation() != m_generation)) {
+            // The file changed on disk or the residency manager evicted the
+            // parsed payload; dropping the handle re-resolves and re-parses,
+            // and lets the old bytes go once no other asset holds them.
+            m_handle = ResourceHandle();
+            m_state = AssetState::unloaded;
+        }
         if (!m_handle.valid()) {
             Database& db = ensure_database();
             if (!db.is_loaded()) {
                 db.load();
             }
             m_handle = db.resolve(m_path);
+            m_generation = m_handle->generation();
             m_state = AssetState::unparsed;
         }
         return *m_handle;
     }
 
-    inline int Asset::cache_key() const noexcept {
-        return static_cast<int>(m_type);
+    inline usize Asset::slot() const noexcept {
+        return static_cast<usize>(m_type);
     }
 
-    inline std::optional<std::reference_wrapper<const std::any>> Asset::try_cached(Resource& resource) const {
-        std::lock_guard lock(resource.m_asset_mutex);
-        auto it = resource.m_asset_cache.find(cache_key());
-        if (it == resource.m_asset_cache.end()) {
-            return std::nullopt;
+    inline const AssetPayload& Asset::parsed(Resource& resource, usize slot, Parser parse) {
+        // Slots are published once with release semantics, so an acquire load
+        // is all the already-parsed path needs.
+        if (const AssetPayload* payload = resource.m_payloads[slot].load(std::memory_order_acquire)) {
+            if (const auto* residency = resource.m_residency.load(std::memory_order_relaxed)) {
+                residency->touch(resource);
+            }
+            return *payload;
         }
-        return std::cref(it->second);
-    }
-
-    inline const std::any& Asset::cache(Resource& resource, std::any value) const {
-        std::lock_guard lock(resource.m_asset_mutex);
-        auto& slot = resource.m_asset_cache[cache_key()];
-        slot = std::move(value);
-        return slot;
+        return parse_once(resource, slot, parse);
     }
 
     template<typename Payload>
     inline const Payload& Asset::payload() const {
         Resource& resource = ensure_resource();
-        if (auto cached = try_cached(resource)) {
-            m_state = AssetState::parsed;
-            return std::any_cast<const Payload&>(cached->get());
-        }
-        std::any parsed = parse_resource(resource);
-        const std::any& slot = cache(resource, std::move(parsed));
+        const AssetPayload& parsed_payload = parsed(resource, slot(), parser());
         m_state = AssetState::parsed;
-        return std::any_cast<const Payload&>(slot);
+        return value_of<Payload>(parsed_payload);
+    }
+
+    template<typename Payload>
+    inline const Payload& Asset::value_of(const AssetPayload& parsed) {
+        if (parsed.tag != Parsed<Payload>::type_tag()) [[unlikely]] {
+            throw RuntimeError("Asset payload does not have the type its accessor expects.");
+        }
+        return static_cast<const Parsed<Payload>&>(parsed).value;
     }
 
     inline BinaryAsset::BinaryAsset()
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+
+#include "mtl/common.hxx"
+
+namespace mloader {
+
+    /**
+     * CRC-32C (Castagnoli). Uses the SSE4.2 or ARMv8 CRC instructions when
+     * the CPU has them and a slicing-by-8 table otherwise. Pass a previous
+     * result as `crc` to continue over more bytes.
+     */
+    use u32 crc32c(const void* data, usize size, u32 crc = 0) noexcept;
+
+    /// @return crc32c() of A followed by B, from the checksums of A and B and the size of B.
+    use u32 crc32c_combine(u32 first, u32 second, u64 second_size) noexcept;
+
+    /// @return Implementation crc32c() dispatches to: "sse4.2", "armv8" or "portable".
+    use cstr crc32c_backend() noexcept;
+
+    using Sha256Digest = std::array<byte, 32>;
+
+    /// Incremental SHA-256 (FIPS 180-4).
+    struct Sha256 {
+        Sha256() noexcept;
+
+        void update(const void* data, usize size) noexcept;
+        /// Pads and returns the digest; the object must be reset before reuse.
+        use Sha256Digest finish() noexcept;
+        void reset() noexcept;
+
+        use static Sha256Digest digest(const void* data, usize size) noexcept;
+
+    protected:
+        void compress(const byte* block) noexcept;
+
+        std::array<u32, 8> m_state{};
+        std::array<byte, 64> m_block{};
+        usize m_used = 0;
+        u64 m_length = 0;
+    };
+
+} // namespace mloader
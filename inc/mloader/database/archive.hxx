@@ -0,0 +1,99 @@
+#pragma once
+
+#include <mutex>
+#include <string_view>
+
+#include "mtl/common.hxx"
+#include "mtl/fs/path/path.hxx"
+
+#include "base.hxx"
+#include "cache.hxx"
+#include "index.hxx"
+#include "mloader/mapping.hxx"
+
+namespace mloader {
+
+    /**
+     * Database over a zip or tar file as shipped by modders, read in place
+     * without extracting it. The archive is memory mapped on load and its
+     * zip central directory (zip64 included) or tar headers (ustar, pax and
+     * GNU long names) are indexed into a PathIndex. Stored members resolve as
+     * views into the mapping; deflated zip members are inflated on demand and
+     * shared while they have handles. Batch resolves inflate in parallel on
+     * the shared WorkerPool.
+     */
+    struct ArchiveFileDatabase : Database {
+        using Database::Entry;
+        using PurePath = Database::PurePath;
+        using Path = mtl::fs::Path;
+
+        enum class Format : u8 {
+            unknown = 0,
+            zip,
+            tar,
+        };
+
+        /// Location of one member inside the mapping.
+        struct Member {
+            Entry::Kind kind = Entry::Kind::file;
+            /// Zip: method from the central directory (0 stored, 8 deflated). Tar: always 0.
+            u16 method = 0;
+            /// Zip: general purpose flags; bit 0 marks an encrypted member.
+            u16 flags = 0;
+            /// Zip: offset of the local header. Tar: offset of the data.
+            u64 offset = 0;
+            u64 packed_size = 0;
+            u64 size = 0;
+            i64 mtime = 0;
+        };
+
+        ctor ArchiveFileDatabase() = default;
+        ctor ArchiveFileDatabase(const Path& file) { set_file(file); }
+        ~ArchiveFileDatabase() override = default;
+
+        prop bool is_loaded() const noexcept override;
+        ArchiveFileDatabase& load() override;
+        /// Throws while any resolved resource is still referenced.
+        ArchiveFileDatabase& unload() override;
+
+        vec<Entry> list() override;
+        vec<Entry> list(const PurePath& rel) override;
+        void each(const PurePath& rel, const Visitor& visitor) override;
+        void children(const PurePath& rel, const Visitor& visitor) override;
+        ResourceHandle resolve(const PurePath& rel) override;
+        /// Resolves in archive order on the shared WorkerPool; handles come back in input order.
+        vec<ResourceHandle> resolve(const vec<PurePath>& rels) override;
+
+        use bool exists(const PurePath& rel) const override;
+        use bool is_file(const PurePath& rel) const override;
+        use bool is_dir(const PurePath& rel) const override;
+
+        void set_file(const Path& file);
+        prop const Path& file() const;
+        /// @return Container format detected on load.
+        prop Format format() const;
+
+    protected:
+        void ensure_loaded() const;
+        use u32 file_slot(const PurePath& rel) const;
+        use u32 find_slot(const PurePath& rel) const;
+        ResourceHandle read_slot(u32 slot);
+        /// @return Compressed bytes of a member, bounds checked against the mapping.
+        use std::span<const byte> packed(const Member& member) const;
+
+        Path m_file;
+        MappedFile m_mapping;
+        Format m_format = Format::unknown;
+        /// Sorted by path, aligned with m_index slots.
+        vec<Entry> m_entries;
+        vec<Member> m_members;
+        PathIndex m_index;
+        /// Views of stored members, created on first resolve and reused.
+        vec<uptr<Resource>> m_stored;
+        /// Inflated members that still have handles; cleared by the resource itself.
+        sptr<LiveResourceCache> m_inflated;
+        std::mutex m_mutex;
+        bool m_loaded = false;
+    };
+
+} // namespace mloader
@@ -37,42 +37,78 @@ namespace mloader {
             return DatabaseRegistry::get().deactivate(*this);
         }
 
+        /**
+         * Residency budget that parsed payloads of this database's resources
+         * are charged to; ResidencyManager::shared() unless set. Change it
+         * before resolving anything.
+         */
+        void set_residency(ResidencyManager& manager) noexcept;
+        prop ResidencyManager& residency() const noexcept;
+
         /**
          * Logical entry describing a path inside the database. Entries carry a
          * back-reference to their owning Database so convenience queries can be
-         * issued without requiring clients to hold additional state.
+         * issued without requiring clients to hold additional state. Backends
+         * that know an entry's kind and metadata while listing fill them in, so
+         * those queries are answered without asking the backend again.
          */
         struct Entry {
+            enum class Kind : u8 {
+                unknown = 0,
+                file,
+                dir,
+            };
+
             PurePath path;
             Database* db = nullptr;
+            Kind kind = Kind::unknown;
+            /// Payload size in bytes; zero for directories or when unknown.
+            u64 size = 0;
+            /// Last modification in nanoseconds on the backend's clock; zero when unknown.
+            i64 mtime = 0;
 
             use bool exists() const {
-                return db && db->exists(path);
+                return kind != Kind::unknown || (db && db->exists(path));
             }
 
             use bool is_file() const {
+                if (kind != Kind::unknown) {
+                    return kind == Kind::file;
+                }
                 return db && db->is_file(path);
             }
 
             use bool is_dir() const {
+                if (kind != Kind::unknown) {
+                    return kind == Kind::dir;
+                }
                 return db && db->is_dir(path);
             }
         };
 
+        using Visitor = function<void(const Entry&)>;
+
         /// Lists entries at the root of the database.
         virt vec<Entry> list() = 0;
         /// Lists entries under the given relative path.
         virt vec<Entry> list(const PurePath& rel) = 0;
+
+        /**
+         * Visits the same entries list(rel) would return, in the same order,
+         * without collecting them. Indexed backends visit their stored entries
+         * directly; the default falls back to list().
+         */
+        virt void each(const PurePath& rel, const Visitor& visitor);
+        /// Visits only the direct children of a directory (the root for an empty path).
+        virt void children(const PurePath& rel, const Visitor& visitor);
         /// Resolves the given entry to a managed resource handle.
         virt ResourceHandle resolve(const PurePath& rel) = 0;
-        vec<ResourceHandle> resolve(const vec<PurePath>& rels) {
-            vec<ResourceHandle> handles;
-            handles.reserve(rels.size());
-            for (const auto& rel : rels) {
-                handles.emplace_back(resolve(rel));
-            }
-            return handles;
-        }
+        /**
+         * Resolves a batch of paths; handles are returned in input order. The
+         * default resolves one path at a time, backends with real I/O override
+         * it to schedule the reads together.
+         */
+        virt vec<ResourceHandle> resolve(const vec<PurePath>& rels);
 
         /// Checks whether a logical path exists within the archive.
         virt bool exists(const PurePath& rel) const = 0;
@@ -80,6 +116,13 @@ namespace mloader {
         virt bool is_file(const PurePath& rel) const = 0;
         /// Checks whether the path refers to a directory-like entry.
         virt bool is_dir(const PurePath& rel) const = 0;
+
+    protected:
+        /// Canonicalises a logical path (strips "./" and stray separators); rejects absolute paths.
+        use PurePath normalise(const PurePath& rel) const;
+
+    private:
+        ResidencyManager* m_residency = nullptr;
     };
 
 } // namespace mloader
@@ -1 +1,132 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string_view>
+
+#include "mtl/common.hxx"
+#include "mtl/fs/path/path.hxx"
+
+#include "base.hxx"
+#include "cache.hxx"
+#include "index.hxx"
+#include "mloader/mapping.hxx"
+#include "mloader/extension/archive/decoder.hxx"
+#include "mloader/extension/archive/index.hxx"
+
+namespace mloader {
+
+    /**
+     * Database backed by a single packed archive (see mpacker) that is memory
+     * mapped on load. The sorted path index is decoded once into a PathIndex;
+     * resolved resources point straight into the mapping, so payloads are
+     * never copied. Compressed entries are decoded on resolve into buffers
+     * recycled through a small pool and shared while they have handles.
+     * Integrity is checked according to the Verification mode.
+     */
+    struct BinaryDatabase : Database {
+        using Database::Entry;
+        using PurePath = Database::PurePath;
+        using Path = mtl::fs::Path;
+        using Record = extension::ArchiveRecord;
+
+        enum class Verification : u8 {
+            /// Trust the archive; resolves stay zero-copy views that page in on demand.
+            off = 0,
+            /**
+             * Check each entry against the xxHash64 stored in its record on
+             * its first resolve, reading all of its bytes. CRC-32C and
+             * SHA-256 only cover the whole archive.
+             */
+            lazy,
+            /// Check the whole-archive CRC-32C and SHA-256 on load, hashing chunks in parallel.
+            eager,
+        };
+
+        ctor BinaryDatabase() = default;
+        ctor BinaryDatabase(const Path& file, Verification verification = Verification::off)
+            : m_verification(verification) { set_file(file); }
+        ~BinaryDatabase() override = default;
+
+        prop bool is_loaded() const noexcept override;
+        BinaryDatabase& load() override;
+        BinaryDatabase& unload() override;
+
+        vec<Entry> list() override;
+        vec<Entry> list(const PurePath& rel) override;
+        void each(const PurePath& rel, const Visitor& visitor) override;
+        void children(const PurePath& rel, const Visitor& visitor) override;
+        ResourceHandle resolve(const PurePath& rel) override;
+        /// Decodes compressed entries in parallel on the shared WorkerPool; handles come back in input order.
+        vec<ResourceHandle> resolve(const vec<PurePath>& rels) override;
+
+        use bool exists(const PurePath& rel) const override;
+        use bool is_file(const PurePath& rel) const override;
+        use bool is_dir(const PurePath& rel) const override;
+
+        void set_file(const Path& file);
+        prop const Path& file() const;
+
+        /// Extension metadata stored in the archive header.
+        prop const extension::Extension& extension() const;
+
+        /// Switching to or from `eager` takes effect on the next load.
+        void set_verification(Verification verification) noexcept;
+        prop Verification verification() const noexcept;
+        /**
+         * Checks the whole-archive checksums now, whatever the mode. Throws
+         * when they do not match or the archive carries none.
+         */
+        void verify();
+
+        /// Decoded entry; returns its buffer to the pool when released.
+        struct DecodedResource;
+
+    protected:
+        /// Decode target, reused across entries of similar size.
+        struct Buffer {
+            uptr<byte[]> data;
+            u64 capacity = 0;
+        };
+
+        /**
+         * Decoded entries that still have handles, plus the spare buffers they
+         * hand back on release. Each entry shares ownership, so a handle that
+         * outlives the database still returns its buffer safely.
+         */
+        struct DecodeCache : LiveResourceCache {
+            using LiveResourceCache::LiveResourceCache;
+
+            /// @return Smallest pooled buffer of at least `size` bytes, or a new one. Requires `mutex`.
+            use Buffer acquire(u64 size);
+            /// Keeps `buffer` for reuse unless the pool is full. Requires `mutex`.
+            void release(Buffer buffer);
+
+            vec<Buffer> buffers;
+            u64 buffer_bytes = 0;
+        };
+
+        void ensure_loaded() const;
+        use std::string_view path(const Record& record) const;
+        use const Record* find_record(const PurePath& rel) const;
+        use u32 file_slot(const PurePath& rel) const;
+        use Entry make_entry(const Record& record);
+        ResourceHandle read_slot(u32 slot);
+        /// Lazy mode: compares the xxHash64 of `data` with the record's hash unless already checked.
+        void check_entry(u32 slot, const byte* data);
+
+        Path m_file;
+        MappedFile m_mapping;
+        extension::ArchiveDecoder m_header;
+        extension::ArchiveIndexDecoder m_index;
+        PathIndex m_paths;
+        vec<uptr<Resource>> m_payloads;
+        sptr<DecodeCache> m_decoded;
+        Verification m_verification = Verification::off;
+        /// Entries whose content already matched their hash.
+        vec<std::atomic<bool>> m_verified;
+        std::mutex m_mutex;
+        bool m_loaded = false;
+    };
+
+} // namespace mloader
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <mutex>
+
+#include "mtl/common.hxx"
+
+#include "mloader/resource.hxx"
+
+namespace mloader {
+
+    struct LiveResourceCache;
+
+    /**
+     * Resource owning bytes its database read or decoded on resolve. It stays
+     * in a LiveResourceCache slot while it has handles, so concurrent resolves
+     * share one copy, and takes itself out when the last handle goes.
+     */
+    struct CachedResource : Resource {
+        CachedResource(Database& owner, sptr<LiveResourceCache> cache, u32 slot)
+            : Resource(owner), m_cache(std::move(cache)), m_slot(slot) {}
+
+    protected:
+        /// Runs under the cache mutex right before deletion, also for a copy that lost a publish race.
+        virt void release() {}
+
+        void destroy_self() override;
+
+    private:
+        friend struct LiveResourceCache;
+
+        /// Keeps the slot table alive after the database unloads.
+        sptr<LiveResourceCache> m_cache;
+        /// Guarded by the cache mutex; npos once detached.
+        u32 m_slot;
+    };
+
+    /**
+     * Non-owning slot -> live resource table shared by a database and its
+     * CachedResources. Every member except the constructor requires `mutex`.
+     */
+    struct LiveResourceCache {
+        static constexpr u32 npos = ~u32(0);
+
+        std::mutex mutex;
+
+        explicit LiveResourceCache(usize count = 0)
+            : m_live(count, nullptr) {}
+
+        /// @return Handle to the slot's resource, or an invalid one if it has none or its last handle is going.
+        use ResourceHandle find(u32 slot);
+        /**
+         * Stores `resource` in its slot. If another thread published a live
+         * copy meanwhile, that one is returned and `resource` is released and
+         * deleted instead.
+         */
+        use ResourceHandle publish(CachedResource* resource);
+
+        /// Marks the slot's resource stale and detaches it, so the next resolve reads afresh.
+        void invalidate(u32 slot);
+        /// Moves each live resource to `to[slot]` in a table of `count` slots; npos detaches it.
+        void remap(const vec<u32>& to, usize count);
+
+        /// @return True while any slot holds a resource.
+        use bool referenced() const noexcept;
+
+    private:
+        friend struct CachedResource;
+
+        vec<CachedResource*> m_live;
+    };
+
+} // namespace mloader
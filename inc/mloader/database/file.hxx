@@ -5,6 +5,8 @@
 #include "mtl/fs/path/pure.hxx"
 
 #include "base.hxx"
+#include "cache.hxx"
+#include "index.hxx"
 
 namespace mloader {
 
@@ -13,6 +15,25 @@ namespace mloader {
         using PurePath = Database::PurePath;
         using Path = mtl::fs::Path;
 
+        /// inotify descriptor and watched directories.
+        struct Watcher;
+
+        /// An entry that appeared, changed on disk or went away.
+        struct Change {
+            enum class Kind : u8 {
+                added,
+                modified,
+                removed,
+            };
+
+            PurePath path;
+            Kind kind = Kind::modified;
+            Entry::Kind entry = Entry::Kind::file;
+        };
+
+        /// Called after the index has been patched, with changes sorted by path.
+        using Subscriber = function<void(const vec<Change>& changes)>;
+
         ctor FilesystemDatabase() = default;
         ctor FilesystemDatabase(const Path& root) { set_root(root); }
         ~FilesystemDatabase() override = default;
@@ -23,8 +44,12 @@ namespace mloader {
 
         vec<Entry> list() override;
         vec<Entry> list(const PurePath& rel) override;
+        void each(const PurePath& rel, const Visitor& visitor) override;
+        void children(const PurePath& rel, const Visitor& visitor) override;
+        /// Returns the live resource for the path if one exists, otherwise reads the file.
         ResourceHandle resolve(const PurePath& rel) override;
-        using Database::resolve;
+        /// Reads the batch in parallel on the shared WorkerPool, issued in inode order.
+        vec<ResourceHandle> resolve(const vec<PurePath>& rels) override;
 
         use bool exists(const PurePath& rel) const override;
         use bool is_file(const PurePath& rel) const override;
@@ -33,18 +58,55 @@ namespace mloader {
         void set_root(const Path& root);
         prop const Path& root() const;
 
+        /**
+         * Re-stats `paths` and patches the index to match the disk without
+         * walking the rest of the tree; directories are reconciled with their
+         * whole subtree, and the empty path rescans everything. Live resources
+         * of changed or removed files are marked stale and dropped from the
+         * cache, then subscribers are notified. Must not run concurrently with
+         * other queries on this database.
+         */
+        vec<Change> refresh(const vec<PurePath>& paths);
+
+        /**
+         * Watches every indexed directory with inotify (Linux only, throws
+         * elsewhere). Events queue in the kernel until poll() applies them on
+         * the caller's thread.
+         */
+        void watch();
+        void unwatch();
+        prop bool watching() const noexcept;
+        /// Drains queued watch events into refresh(). @return Number of changes applied.
+        usize poll();
+
+        /// @return Token for unsubscribe().
+        u64 subscribe(Subscriber subscriber);
+        void unsubscribe(u64 token);
+
     protected:
         void ensure_loaded() const;
-        use PurePath normalise(const PurePath& rel) const;
         Path make_absolute(const PurePath& rel) const;
 
+        /// Looks up an already normalised path in the hashed entry index.
         Entry* find_entry(const PurePath& rel);
         const Entry* find_entry(const PurePath& rel) const;
+        /// Validates a path for resolve(); @return Slot of the file entry.
+        use u32 file_slot(const PurePath& rel) const;
+        ResourceHandle read_slot(u32 slot);
         void collect_entries(const Path& resolved_root);
+        void add_watch(const str& key);
 
         Path m_root;
         Path m_resolved_root;
         vec<Entry> m_entries;
+        /// Inode per slot; batched reads are issued in this order to approximate disk layout.
+        vec<u64> m_inodes;
+        PathIndex m_index;
+        /// Files read on resolve; outlives unload() while resources reference it.
+        sptr<LiveResourceCache> m_cache;
+        sptr<Watcher> m_watcher;
+        vec<std::pair<u64, Subscriber>> m_subscribers;
+        u64 m_next_subscriber = 0;
         bool m_loaded = false;
     };
 
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "mtl/common.hxx"
+
+#include "mloader/table.hxx"
+
+namespace mloader {
+
+    /**
+     * Immutable lookup table from logical path strings to dense slots. Keys are
+     * copied into one contiguous pool and hashed into an open-addressing table,
+     * so a lookup is one hash, a short probe and one string compare, with no
+     * allocation. Slots follow the order of the keys passed to build(), which
+     * must be sorted and unique.
+     *
+     * The index also records the directory hierarchy: every slot knows its
+     * direct children, and because keys are sorted each subtree occupies one
+     * contiguous slot range.
+     */
+    struct PathIndex {
+        static constexpr u32 npos = ~u32(0);
+
+        /// Half-open slot range [first, last).
+        struct Range {
+            u32 first = 0;
+            u32 last = 0;
+        };
+
+        void build(const vec<std::string_view>& keys);
+        void clear() noexcept;
+
+        /// @return Slot of `key`, or npos when absent.
+        use u32 find(std::string_view key) const noexcept;
+
+        /// @return Slots strictly below `key`; the empty key covers every slot.
+        use Range descendants(std::string_view key) const noexcept;
+
+        /// @return Direct children of `slot`; npos addresses the root.
+        use std::span<const u32> children(u32 slot) const noexcept;
+
+        prop usize size() const noexcept { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+        prop bool empty() const noexcept { return size() == 0; }
+
+        /// @return Key stored at `slot`; views into the index pool.
+        use std::string_view key(u32 slot) const noexcept;
+
+    protected:
+        use u32 lower_bound(std::string_view base, char tail) const noexcept;
+        void link();
+
+        str m_pool;
+        vec<u32> m_offsets;
+        FlatTable m_table;
+        /// CSR layout: children of slot s are m_children[m_child_offsets[s] .. m_child_offsets[s + 1]];
+        /// the root uses the extra entry at index size().
+        vec<u32> m_child_offsets;
+        vec<u32> m_children;
+    };
+
+} // namespace mloader
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+#include "base.hxx"
+#include "index.hxx"
+
+namespace mloader {
+
+    /**
+     * Overlays other databases (base game, extensions, mods) under mount
+     * points. Where several mounts provide the same path the highest priority
+     * wins, and among equal priorities the latest mount. The merged tree is
+     * precomputed into a PathIndex on load, with the owning mount per slot,
+     * so routing a lookup is one hash probe regardless of how many databases
+     * are mounted. Mounted databases are not owned and must outlive the
+     * joined database.
+     */
+    struct JoinedDatabase : Database {
+        using Database::Entry;
+        using PurePath = Database::PurePath;
+
+        struct Mount {
+            Database* db = nullptr;
+            /// Mount point inside the joined tree; empty for the root.
+            PurePath at;
+            i32 priority = 0;
+        };
+
+        ctor JoinedDatabase() = default;
+        ~JoinedDatabase() override = default;
+
+        /**
+         * Mounts `db` under `at`. On a loaded database the merged index is
+         * rebuilt immediately; prefer mounting everything before load().
+         * Throws if `db` is this database or already mounts it, directly or
+         * through other joined databases.
+         */
+        JoinedDatabase& mount(Database& db, const PurePath& at = PurePath(), i32 priority = 0);
+        JoinedDatabase& unmount(Database& db);
+        /// @return True if `db` is mounted here, directly or inside a mounted JoinedDatabase.
+        use bool mounts_database(const Database& db) const;
+        /// @return Mounts in the order they were added.
+        prop const vec<Mount>& mounts() const noexcept { return m_mounts; }
+
+        prop bool is_loaded() const noexcept override;
+        /// Loads every mounted database that is not loaded yet and builds the merged index.
+        JoinedDatabase& load() override;
+        /// Drops the merged index; mounted databases stay loaded.
+        JoinedDatabase& unload() override;
+        /// Rebuilds the merged index after the contents of a mounted database changed.
+        JoinedDatabase& reindex();
+
+        vec<Entry> list() override;
+        vec<Entry> list(const PurePath& rel) override;
+        void each(const PurePath& rel, const Visitor& visitor) override;
+        void children(const PurePath& rel, const Visitor& visitor) override;
+        ResourceHandle resolve(const PurePath& rel) override;
+        /// Groups the batch by owning database so each one resolves its share in a single call.
+        vec<ResourceHandle> resolve(const vec<PurePath>& rels) override;
+
+        use bool exists(const PurePath& rel) const override;
+        use bool is_file(const PurePath& rel) const override;
+        use bool is_dir(const PurePath& rel) const override;
+
+        /// @return Mounted database that serves `rel`, or null when no mount provides it.
+        use Database* owner(const PurePath& rel) const;
+
+    protected:
+        void ensure_loaded() const;
+        void build();
+        /// @return Slot of a normalised key, or PathIndex::npos.
+        use u32 find_slot(const PurePath& rel) const;
+        use u32 file_slot(const PurePath& rel) const;
+        /// @return Path of `slot` inside its owning database.
+        use PurePath inner_path(u32 slot) const;
+
+        vec<Mount> m_mounts;
+        vec<Entry> m_entries;
+        /// Index into m_mounts per slot; npos for directories implied by a mount point.
+        vec<u32> m_owners;
+        PathIndex m_index;
+        bool m_loaded = false;
+    };
+
+} // namespace mloader
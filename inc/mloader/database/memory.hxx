@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <string_view>
+
+#include "mtl/common.hxx"
+
+#include "base.hxx"
+#include "index.hxx"
+
+namespace mloader {
+
+    /**
+     * Database whose files live in memory, for generated content, staging and
+     * tests. File bytes are copied once into a chunked bump arena and resolved
+     * resources point straight into it. Replaced or removed files keep their
+     * bytes until compact(), so handles taken earlier stay valid (and report
+     * stale()). Inserts and removals only mark the index dirty; it is rebuilt
+     * once on the next query, so bulk edits cost a single rebuild. Queries may
+     * run concurrently with each other, edits may not run alongside queries.
+     */
+    struct InMemoryDatabase : Database {
+        using Database::Entry;
+        using PurePath = Database::PurePath;
+
+        static constexpr usize DEFAULT_CHUNK_SIZE = usize{1} << 20;
+
+        ctor InMemoryDatabase(usize chunk_size = DEFAULT_CHUNK_SIZE) { m_arena.chunk_size = chunk_size; }
+        ~InMemoryDatabase() override = default;
+
+        InMemoryDatabase(const InMemoryDatabase&) = delete;
+        InMemoryDatabase& operator=(const InMemoryDatabase&) = delete;
+
+        prop bool is_loaded() const noexcept override;
+        /// Nothing to read; marks the database ready.
+        InMemoryDatabase& load() override;
+        /// Drops the lookup index; the stored files are kept.
+        InMemoryDatabase& unload() override;
+
+        /**
+         * Copies `data` into the arena as the file `rel`, replacing an
+         * existing file. Missing parent directories are created; a path that
+         * runs through an existing file, or names a directory, is rejected.
+         */
+        InMemoryDatabase& insert(const PurePath& rel, std::span<const byte> data);
+        InMemoryDatabase& insert(const PurePath& rel, std::string_view text);
+        InMemoryDatabase& insert(const vec<std::pair<PurePath, std::span<const byte>>>& files);
+        /// Creates an (empty) directory and its parents.
+        InMemoryDatabase& add_dir(const PurePath& rel);
+
+        /// Removes a file, or a directory with everything below it. @return Entries removed.
+        usize remove(const PurePath& rel);
+        usize remove(const vec<PurePath>& rels);
+        /// Removes every entry; the arena is released as well unless a resource is still referenced.
+        void clear();
+
+        /**
+         * Copies the live files into a fresh arena, releasing the space of
+         * replaced and removed ones. Throws while any resource is referenced.
+         */
+        void compact();
+
+        /// @return Bytes reserved by the arena.
+        prop usize arena_capacity() const noexcept;
+        /// @return Bytes of files currently stored.
+        prop usize live_bytes() const noexcept { return m_live_bytes; }
+
+        vec<Entry> list() override;
+        vec<Entry> list(const PurePath& rel) override;
+        void each(const PurePath& rel, const Visitor& visitor) override;
+        void children(const PurePath& rel, const Visitor& visitor) override;
+        ResourceHandle resolve(const PurePath& rel) override;
+        using Database::resolve;
+
+        use bool exists(const PurePath& rel) const override;
+        use bool is_file(const PurePath& rel) const override;
+        use bool is_dir(const PurePath& rel) const override;
+
+    protected:
+        /// Chunked bump allocator; allocations are never freed individually.
+        struct Arena {
+            usize chunk_size = DEFAULT_CHUNK_SIZE;
+            vec<uptr<byte[]>> chunks;
+            vec<usize> sizes;
+            usize used = 0;
+
+            use byte* allocate(usize size);
+            use usize capacity() const noexcept;
+            void clear() noexcept;
+        };
+
+        struct Node {
+            Entry entry;
+            std::span<const byte> data;
+            /// Created on first resolve and reused afterwards.
+            uptr<Resource> resource;
+        };
+
+        /// Loads and reindexes if needed; safe to call from concurrent queries.
+        void ensure_loaded() const;
+        /// Rebuilds the sorted entries and PathIndex after edits; the caller holds m_mutex.
+        void ensure_indexed() const;
+        use const Node* find_node(const PurePath& rel) const;
+        /// Creates `key`'s missing ancestors as directories.
+        void add_parents(const str& key);
+        /// Moves the node's resource to the retired list, marking it stale.
+        void retire(Node& node);
+        /// Erases `key`, and everything below it if it is a directory.
+        usize erase(const str& key);
+        /// @return True if any current or retired resource still has handles.
+        use bool referenced() const;
+
+        Arena m_arena;
+        umap<str, Node> m_nodes;
+        usize m_live_bytes = 0;
+        /// Resources of replaced or removed files; freed once nothing references them.
+        vec<uptr<Resource>> m_retired;
+
+        mutable vec<Node*> m_slots;
+        mutable PathIndex m_index;
+        /// Set by every edit and by unload(), so a clean index implies a loaded database.
+        mutable std::atomic<bool> m_dirty{true};
+        mutable std::mutex m_mutex;
+        bool m_loaded = false;
+    };
+
+} // namespace mloader
@@ -3,6 +3,7 @@
 #include "mtl/common.hxx"
 #include "mtl/fs/path/path.hxx"
 #include "mtl/serial.hxx"
+#include "mtl/binary/binary.hxx"
 
 namespace mloader {
 
@@ -11,6 +12,11 @@ namespace mloader {
 
         /// Returns the logical identifier for this definition (must be unique per type).
         use virt const str& identifier() cx = 0;
+
+        /// Writes the reflected fields for the registry's binary cache.
+        virt void encode(mtl::binary::EncodeStream& stream) cx { save_binary(stream); }
+        /// Restores the fields written by encode().
+        virt void decode(mtl::binary::DecodeStream& stream) { load_binary(stream); }
     };
 
 } // namespace mloader
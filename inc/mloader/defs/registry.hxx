@@ -1,10 +1,19 @@
 #pragma once
 
 #include "mtl/common.hxx"
+#include "mtl/error.hxx"
 #include "mtl/fs/path/path.hxx"
 
+#include <deque>
+#include <string_view>
+#include <type_traits>
+
+#include "mloader/database/base.hxx"
 #include "mloader/defs/definition.hxx"
+#include "mloader/defs/symbols.hxx"
 #include "mloader/resource.hxx"
+#include "mloader/table.hxx"
+#include "mloader/worker.hxx"
 
 namespace YAML {
     class Node;
@@ -12,30 +21,272 @@ namespace YAML {
 
 namespace mloader {
 
+    /// Type-erased per-type storage used by DefinitionRegistry::register_type<T>().
+    struct DefinitionArena {
+        virt ~DefinitionArena() = default;
+
+        /// Moves `source` (created by the type's own factory) into the arena. @return Its new address.
+        virt Definition* adopt(Definition& source) = 0;
+        /// Destroys the entries flagged in `drop` (indexed in insertion order). @return Survivors, in order.
+        virt vec<Definition*> erase(const vec<u8>& drop) = 0;
+        virt void clear() = 0;
+    };
+
+    /// Chunked storage for one definition type; element addresses never change.
+    template<typename T>
+    struct TypedArena : DefinitionArena {
+        std::deque<T> items;
+
+        Definition* adopt(Definition& source) override {
+            return &items.emplace_back(std::move(static_cast<T&>(source)));
+        }
+
+        vec<Definition*> erase(const vec<u8>& drop) override {
+            std::deque<T> kept;
+            for (usize i = 0; i < items.size(); ++i) {
+                if (!drop[i]) {
+                    kept.emplace_back(std::move(items[i]));
+                }
+            }
+            items.swap(kept);
+
+            vec<Definition*> survivors;
+            survivors.reserve(items.size());
+            for (auto& item : items) {
+                survivors.emplace_back(&item);
+            }
+            return survivors;
+        }
+
+        void clear() override {
+            items.clear();
+        }
+    };
+
+    /// Range over every definition of one registered type, in ingest order.
+    template<typename T>
+    struct DefinitionView {
+        using Iterator = typename std::deque<T>::const_iterator;
+
+        ctor DefinitionView(const std::deque<T>& items) : m_items(&items) {}
+
+        prop Iterator begin() const noexcept { return m_items->begin(); }
+        prop Iterator end() const noexcept { return m_items->end(); }
+        prop usize size() const noexcept { return m_items->size(); }
+        prop bool empty() const noexcept { return m_items->empty(); }
+
+    private:
+        const std::deque<T>* m_items;
+    };
+
+    /**
+     * Owns every ingested definition, keyed by type and identifier. Files are
+     * either a definition mapping with a `type` field, a sequence of those,
+     * or a mapping of identifiers to `{type, parent, data}` entries. Keyed
+     * entries inherit their parent's `data` (same type, possibly from another
+     * file); inheritance is resolved at the end of each ingest call.
+     */
     struct DefinitionRegistry {
         using DefinitionPtr = uptr<Definition>;
         using Factory = function<DefinitionPtr()>;
+        using Symbol = SymbolTable::Symbol;
+
+        DefinitionRegistry();
+        ~DefinitionRegistry();
 
         void register_type(const str& type_name, Factory factory);
 
+        /**
+         * Registers `T` with its own arena: definitions are moved into chunked
+         * per-type storage on insert, and each<T>() walks it without
+         * allocating or casting. `T` must be default- and move-constructible.
+         */
+        template<typename T>
+        void register_type(const str& type_name);
+
+        /// @return View over all definitions of a type registered through register_type<T>().
+        template<typename T>
+        use DefinitionView<T> each() const;
+        /// Keyed lookup in a type registered through register_type<T>(); null if `identifier` is unknown.
+        template<typename T>
+        use const T* find(std::string_view identifier) const;
+
         void ingest(const mtl::fs::Path& file_path);
         void ingest(const vec<mtl::fs::Path>& files);
         void ingest(const ResourceHandle& resource);
         void ingest(const vec<ResourceHandle>& resources);
 
+        /**
+         * Parallel variants: files are parsed and definitions constructed on
+         * `pool` into one staging batch per input, then merged in input order.
+         * Results and reported errors match the serial overloads for any
+         * thread count. Factories and Definition::load_yaml must be safe to
+         * call concurrently.
+         */
+        void ingest(const vec<mtl::fs::Path>& files, WorkerPool& pool);
+        void ingest(const vec<ResourceHandle>& resources, WorkerPool& pool);
+
+        /// Ingests database files labelled by their path, so reingest() can replace them later.
+        void ingest(Database& db, const vec<Database::PurePath>& paths);
+
+        /**
+         * Replaces what `paths` contributed: their definitions and keyed
+         * entries are dropped, the files that still exist are ingested again,
+         * and keyed entries elsewhere that inherit from a replaced entry are
+         * rebuilt. The new set is parsed, linked and checked for duplicates
+         * before anything is dropped, so any error leaves the registry
+         * unchanged. Definitions of the affected types may move. Meant to be
+         * driven by FilesystemDatabase::subscribe().
+         */
+        void reingest(Database& db, const vec<Database::PurePath>& paths);
+
         use vec<str> types() const;
-        use vec<const Definition*> definitions(const str& type_name) const;
-        use const Definition* find(const str& type_name, const str& identifier) const;
+        /// @return Definitions of a type in ingest order.
+        use vec<const Definition*> definitions(std::string_view type_name) const;
+        use const Definition* find(std::string_view type_name, std::string_view identifier) const noexcept;
+        /// Lookup by handles from type_symbol()/id_symbol(); a single probe of a flat table.
+        use const Definition* find(Symbol type, Symbol identifier) const noexcept;
+
+        /// @return Stable handle of a type or identifier, or SymbolTable::npos if none was ingested.
+        use Symbol type_symbol(std::string_view type_name) const noexcept;
+        use Symbol id_symbol(std::string_view identifier) const noexcept;
+
+        /**
+         * @return hash64 over the contents of `sources`, in order; keys the
+         * binary cache. Reads every source byte, so it costs about as much
+         * I/O as the cold ingest it guards.
+         */
+        use static u64 fingerprint(const vec<ResourceHandle>& sources);
+        /// @return hash64 over the path, size and mtime of `sources`; a stat-only key for warm starts.
+        use static u64 fingerprint(const vec<Database::Entry>& sources);
+
+        /**
+         * Serialises every ingested definition, in ingest order, into a compact
+         * blob tagged with `fingerprint`. Keyed entries are stored with their
+         * merged YAML so later ingests can still inherit from them; plain
+         * definitions are restored without touching YAML. load_cache()
+         * returns false if the blob was written for other sources or by an
+         * incompatible version, leaving the registry unchanged. Errors while
+         * decoding, or ids that clash with ingested ones, throw and likewise
+         * leave the registry unchanged.
+         */
+        use vec<byte> save_cache(u64 fingerprint) const;
+        void save_cache(const mtl::fs::Path& file_path, u64 fingerprint) const;
+        bool load_cache(const byte* data, usize size, u64 fingerprint);
+        /// Memory maps `file_path`; a missing file counts as a stale cache.
+        bool load_cache(const mtl::fs::Path& file_path, u64 fingerprint);
 
         void clear();
 
     protected:
+        /// Keyed entry awaiting (or holding) its merged, inherited data.
+        struct Template;
+
+        /// Definitions of one type: ownership in ingest order plus a flat id index.
+        struct TypeTable {
+            /// Every definition in ingest order; owned by `owned` or by the type's arena.
+            vec<Definition*> definitions;
+            /// Identifier and source label symbols per definition, parallel to `definitions`.
+            vec<Symbol> ids;
+            vec<Symbol> sources;
+            vec<DefinitionPtr> owned;
+            /// Maps identifier symbols to positions in `definitions`.
+            FlatTable index;
+
+            use Definition* find(Symbol id) const noexcept;
+            /// Indexes a stored definition; the caller checked that `id` is new.
+            void insert(Symbol id, Definition* definition, Symbol source);
+            use bool contains(Symbol id) const noexcept { return find(id) != nullptr; }
+        };
+
+        /// Definitions parsed from one source, not yet visible in the registry.
+        struct Batch {
+            str source_label;
+            vec<std::pair<str, DefinitionPtr>> definitions;
+            vec<Template> templates;
+        };
+
         void ingest_yaml(const str& contents, const str& source_label);
         void ingest_resource(const ResourceHandle& resource, const str& source_label);
         void ingest_node(const str& type_name, const YAML::Node& node, const str& source_label);
 
+        use Batch parse_file(const mtl::fs::Path& file_path) const;
+        use Batch parse_yaml(const str& contents, const str& source_label) const;
+        use Batch parse_resource(const ResourceHandle& resource, const str& source_label) const;
+        use DefinitionPtr build_node(const str& type_name, const YAML::Node& node, const str& source_label) const;
+        /// Merges staged batches in order; the first failure (parse error or duplicate) is rethrown.
+        void merge(vec<Batch>& batches, vec<std::exception_ptr>& errors);
+        /// Inserts a batch's definitions and stages its templates; link() finishes them.
+        void commit(Batch& batch);
+        void insert(const str& type_name, DefinitionPtr definition, const str& source_label);
+        /// Destroys the definitions of `type` flagged in `drop` and rebuilds its table from the rest.
+        void erase(Symbol type, const vec<u8>& drop);
+
+        /// Stages a keyed entry; rejects identifiers that are already taken.
+        Template& add_template(Template&& entry);
+        /// Merges and builds every staged template, parents first; on failure the unbuilt ones are dropped.
+        void link();
+        const YAML::Node& resolve_template(Template& entry);
+
         umap<str, Factory> m_factories;
-        umap<str, umap<str, DefinitionPtr>> m_definitions;
+        /// Interned names; handles stay valid across clear().
+        SymbolTable m_type_names;
+        SymbolTable m_ids;
+        SymbolTable m_sources;
+        /// Indexed by type symbol.
+        vec<TypeTable> m_tables;
+        /// Indexed by type symbol; set for types registered through register_type<T>().
+        vec<uptr<DefinitionArena>> m_arenas;
+        /// Type symbol per C++ type registered through register_type<T>().
+        umap<const void*, Symbol> m_typed;
+
+        template<typename T>
+        static const void* type_key() noexcept {
+            static const char key = 0;
+            return &key;
+        }
+        umap<str, umap<str, uptr<Template>>> m_templates;
+        vec<Template*> m_unlinked;
     };
 
+    template<typename T>
+    void DefinitionRegistry::register_type(const str& type_name) {
+        static_assert(std::is_base_of_v<Definition, T>, "T must derive from Definition");
+        static_assert(std::is_move_constructible_v<T>, "T must be move constructible");
+
+        register_type(type_name, [] {
+            return DefinitionPtr(make_uptr<T>());
+        });
+
+        const Symbol type = m_type_names.intern(type_name);
+        if (type >= m_arenas.size()) {
+            m_arenas.resize(type + 1);
+        }
+        m_arenas[type] = make_uptr<TypedArena<T>>();
+        m_typed[type_key<T>()] = type;
+    }
+
+    template<typename T>
+    DefinitionView<T> DefinitionRegistry::each() const {
+        auto it = m_typed.find(type_key<T>());
+        if (it == m_typed.end()) {
+            throw RuntimeError("Definition type was not registered through register_type<T>().");
+        }
+        return DefinitionView<T>(static_cast<const TypedArena<T>&>(*m_arenas[it->second]).items);
+    }
+
+    template<typename T>
+    const T* DefinitionRegistry::find(std::string_view identifier) const {
+        auto it = m_typed.find(type_key<T>());
+        if (it == m_typed.end()) {
+            throw RuntimeError("Definition type was not registered through register_type<T>().");
+        }
+        const Symbol id = m_ids.find(identifier);
+        if (id == SymbolTable::npos || it->second >= m_tables.size()) {
+            return nullptr;
+        }
+        // Arena types only ever store T, so the downcast needs no check.
+        return static_cast<const T*>(m_tables[it->second].find(id));
+    }
+
 } // namespace mloader
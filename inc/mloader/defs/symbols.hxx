@@ -0,0 +1,36 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+#include "mloader/table.hxx"
+
+#include <deque>
+#include <string_view>
+
+namespace mloader {
+
+    /**
+     * Interns strings into dense, stable integer handles. Lookups take a
+     * string_view and never allocate; the bucket array is flat, so a probe
+     * touches one cache line before the final string comparison.
+     */
+    struct SymbolTable {
+        using Symbol = u32;
+        static constexpr Symbol npos = ~Symbol{0};
+
+        /// @return Handle for `name`, adding it on first use.
+        Symbol intern(std::string_view name);
+        /// @return Handle for `name`, or npos if it was never interned.
+        use Symbol find(std::string_view name) const noexcept;
+        use std::string_view name(Symbol symbol) const;
+
+        prop usize size() const noexcept { return m_names.size(); }
+        void clear();
+
+    protected:
+        /// Deque storage keeps interned strings at stable addresses.
+        std::deque<str> m_names;
+        FlatTable m_table;
+    };
+
+} // namespace mloader
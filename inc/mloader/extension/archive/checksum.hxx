@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "mtl/common.hxx"
+
+#include "mloader/checksum.hxx"
+#include "mloader/extension/archive/constants.hxx"
+#include "mloader/worker.hxx"
+
+namespace mloader::extension {
+
+    /// Whole-archive checksums as stored in the header.
+    struct ArchiveChecksums {
+        u32 crc32 = 0;
+        Sha256Digest sha256{};
+
+        bool operator==(const ArchiveChecksums&) const = default;
+    };
+
+    /**
+     * Streaming form used while writing. The writer emits the checksum range
+     * as zeros, so bytes are fed exactly as written.
+     */
+    struct ArchiveChecksumBuilder {
+        void update(const byte* data, u64 size) {
+            m_crc = crc32c(data, static_cast<usize>(size), m_crc);
+            while (size > 0) {
+                const u64 take = std::min(size, ARCHIVE_CHECKSUM_CHUNK - m_chunk_used);
+                m_chunk.update(data, static_cast<usize>(take));
+                m_chunk_used += take;
+                data += take;
+                size -= take;
+                if (m_chunk_used == ARCHIVE_CHECKSUM_CHUNK) {
+                    flush();
+                }
+            }
+        }
+
+        use ArchiveChecksums finish() {
+            if (m_chunk_used > 0) {
+                flush();
+            }
+            ArchiveChecksums sums;
+            sums.crc32 = m_crc;
+            sums.sha256 = m_digests.finish();
+            return sums;
+        }
+
+    private:
+        void flush() {
+            const Sha256Digest digest = m_chunk.finish();
+            m_digests.update(digest.data(), digest.size());
+            m_chunk.reset();
+            m_chunk_used = 0;
+        }
+
+        u32 m_crc = 0;
+        Sha256 m_chunk;
+        u64 m_chunk_used = 0;
+        Sha256 m_digests;
+    };
+
+    /**
+     * Checksums of a complete archive in memory (usually a mapping). Chunks
+     * are hashed in parallel on `pool` and their CRCs combined in order.
+     */
+    inline ArchiveChecksums compute_checksums(const byte* data, u64 size, WorkerPool& pool = WorkerPool::shared()) {
+        const usize chunks = static_cast<usize>((size + ARCHIVE_CHECKSUM_CHUNK - 1) / ARCHIVE_CHECKSUM_CHUNK);
+        vec<u32> crcs(chunks);
+        vec<Sha256Digest> digests(chunks);
+
+        pool.parallel(chunks, [&](usize i) {
+            const u64 begin = static_cast<u64>(i) * ARCHIVE_CHECKSUM_CHUNK;
+            const u64 length = std::min(ARCHIVE_CHECKSUM_CHUNK, size - begin);
+            const byte* chunk = data + begin;
+
+            vec<byte> patched;
+            if (begin < ARCHIVE_CHECKSUM_OFFSET + ARCHIVE_CHECKSUM_SIZE) {
+                // The header chunk: read the checksum fields as zeros.
+                patched.assign(chunk, chunk + length);
+                const u64 end = std::min<u64>(ARCHIVE_CHECKSUM_OFFSET + ARCHIVE_CHECKSUM_SIZE, length);
+                if (ARCHIVE_CHECKSUM_OFFSET < end) {
+                    std::memset(patched.data() + ARCHIVE_CHECKSUM_OFFSET, 0, static_cast<usize>(end - ARCHIVE_CHECKSUM_OFFSET));
+                }
+                chunk = patched.data();
+            }
+            crcs[i] = crc32c(chunk, static_cast<usize>(length));
+            digests[i] = Sha256::digest(chunk, static_cast<usize>(length));
+        });
+
+        ArchiveChecksums sums;
+        Sha256 tree;
+        for (usize i = 0; i < chunks; ++i) {
+            const u64 length = std::min(ARCHIVE_CHECKSUM_CHUNK, size - static_cast<u64>(i) * ARCHIVE_CHECKSUM_CHUNK);
+            sums.crc32 = i == 0 ? crcs[i] : crc32c_combine(sums.crc32, crcs[i], length);
+            tree.update(digests[i].data(), digests[i].size());
+        }
+        sums.sha256 = tree.finish();
+        return sums;
+    }
+
+}
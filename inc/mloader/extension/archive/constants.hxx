@@ -5,5 +5,40 @@
 namespace mloader::extension {
     constexpr cstr ARCHIVE_MAGIC = "MLDA";
     constexpr u32 ARCHIVE_MAGIC_SIZE = 4;
-    constexpr u32 ARCHIVE_VERSION = 1;
+    constexpr u32 ARCHIVE_VERSION = 2;
+
+    /// First read of ArchiveDecoder::probe_header(); grown 16x while the header does not fit.
+    constexpr u64 ARCHIVE_PROBE_SIZE = 4096;
+    constexpr u64 ARCHIVE_PROBE_LIMIT = 1ull << 20;
+
+    /// Payload offsets are padded to this boundary so mapped data is SIMD/cache-line aligned.
+    constexpr u64 ARCHIVE_ALIGNMENT = 64;
+
+    /// Trailer stored in the last bytes of a pack: index offset, index size and magic.
+    constexpr cstr ARCHIVE_INDEX_MAGIC = "MLDI";
+    constexpr u32 ARCHIVE_TRAILER_SIZE = 8 + 8 + ARCHIVE_MAGIC_SIZE;
+
+    /// Encoded size of a single ArchiveRecord inside the index table.
+    constexpr u32 ARCHIVE_RECORD_SIZE = 4 + 4 + 4 + 8 + 8 + 8 + 8 + 8;
+
+    /// Header flag: `crc32` and `sha256` hold the checksums described below.
+    constexpr u32 ARCHIVE_FLAG_CHECKSUMS = 1u << 0;
+
+    /**
+     * Header bytes holding `crc32` and `sha256`. Checksums cover the whole
+     * file with this range read as zeros, so they can be patched in after
+     * the rest has been written.
+     */
+    constexpr u64 ARCHIVE_CHECKSUM_OFFSET = ARCHIVE_MAGIC_SIZE + 4;
+    constexpr u64 ARCHIVE_CHECKSUM_SIZE = 4 + 32;
+
+    /**
+     * `sha256` is the SHA-256 of the concatenated SHA-256 digests of
+     * consecutive chunks of this size, so verification can hash chunks in
+     * parallel. `crc32` is a plain CRC-32C of the file.
+     */
+    constexpr u64 ARCHIVE_CHECKSUM_CHUNK = 1ull << 20;
+
+    /// Record flag: the payload is a compress_lz() block of `packed_size` bytes.
+    constexpr u32 ARCHIVE_RECORD_LZ = 1u << 0;
 }
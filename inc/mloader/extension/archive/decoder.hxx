@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstring>
+#include <exception>
+#include <fstream>
 
+#include "mtl/error.hxx"
 #include "mtl/binary/binary.hxx"
+#include "mtl/fs/path/path.hxx"
 
 #include "mloader/extension/archive/constants.hxx"
 #include "mloader/extension/extension.hxx"
@@ -26,6 +30,40 @@ namespace mloader::extension {
             decode_header(buffer.data(), buffer.size());
         }
 
+        /**
+         * Decodes the header of `file` without mapping or reading the rest of
+         * it: ARCHIVE_PROBE_SIZE bytes are read first and more only when the
+         * extension metadata runs past them.
+         */
+        void probe_header(const mtl::fs::Path& file) {
+            std::ifstream stream(file.string(), std::ios::binary | std::ios::in);
+            if (!stream.is_open()) {
+                throw RuntimeError("Failed to open archive: " + file.string());
+            }
+
+            vec<byte> buffer;
+            for (u64 want = ARCHIVE_PROBE_SIZE;; want *= 16) {
+                const usize have = buffer.size();
+                buffer.resize(static_cast<usize>(want));
+                stream.read(reinterpret_cast<char*>(buffer.data() + have), static_cast<std::streamsize>(want - have));
+                buffer.resize(have + static_cast<usize>(stream.gcount()));
+
+                // A short read means the whole file is buffered; a foreign magic will not improve either.
+                const bool last = buffer.size() < want || want >= ARCHIVE_PROBE_LIMIT ||
+                                  buffer.size() < ARCHIVE_MAGIC_SIZE || std::memcmp(buffer.data(), ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) != 0;
+                if (last) {
+                    decode_header(buffer);
+                    return;
+                }
+                try {
+                    decode_header(buffer);
+                    return;
+                } catch (const std::exception&) {
+                    // The header runs past the prefix; read more.
+                }
+            }
+        }
+
     private:
         void decode_stream(DecodeStream& stream) {
             char magic[ARCHIVE_MAGIC_SIZE];
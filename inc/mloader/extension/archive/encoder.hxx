@@ -10,9 +10,10 @@ namespace mloader::extension {
     using mtl::binary::EncodeStream;
 
     struct ArchiveEncoder {
-        u32 crc32;
-        byte sha256[32];
-        u32 flags;
+        /// Filled in by ArchiveWriter::finish().
+        u32 crc32 = 0;
+        byte sha256[32]{};
+        u32 flags = 0;
 
         Extension extension;
 
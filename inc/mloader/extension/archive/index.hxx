@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include "mtl/common.hxx"
+#include "mtl/error.hxx"
+#include "mtl/binary/binary.hxx"
+
+#include "mloader/extension/archive/constants.hxx"
+
+namespace mloader::extension {
+    using mtl::binary::DecodeStream;
+    using mtl::binary::EncodeStream;
+
+    enum class ArchiveKind : u32 {
+        file = 0,
+        dir = 1,
+    };
+
+    /**
+     * Fixed-size entry of the archive index. Paths are not stored inline but
+     * reference a shared string pool that follows the record table, so the
+     * index of a mapped archive can be searched without copying any names.
+     * Records are sorted by path, which keeps every directory subtree in a
+     * contiguous range.
+     */
+    struct ArchiveRecord {
+        ArchiveKind kind = ArchiveKind::file;
+        /// ARCHIVE_RECORD_* bits.
+        u32 flags = 0;
+        u32 path_size = 0;
+        u64 path_offset = 0;
+        u64 offset = 0;
+        /// Bytes stored in the archive; equals `size` unless compressed.
+        u64 packed_size = 0;
+        u64 size = 0;
+        /// hash64() of the uncompressed payload; zero for directories.
+        u64 hash = 0;
+
+        use bool compressed() const noexcept { return (flags & ARCHIVE_RECORD_LZ) != 0; }
+    };
+
+    /**
+     * Footer written after the index. Packs are produced front to back, so the
+     * index location is only known at the end and recorded here.
+     */
+    struct ArchiveTrailer {
+        u64 index_offset = 0;
+        u64 index_size = 0;
+
+        vec<byte> encode() const {
+            EncodeStream stream;
+            stream.integer<u64>(index_offset);
+            stream.integer<u64>(index_size);
+            stream.write(ARCHIVE_INDEX_MAGIC, ARCHIVE_MAGIC_SIZE);
+            return stream.finish();
+        }
+
+        void decode(const byte* data, usize size) {
+            if (size < ARCHIVE_TRAILER_SIZE) {
+                throw RuntimeError("Archive is too small to contain an index trailer.");
+            }
+
+            DecodeStream stream(data + size - ARCHIVE_TRAILER_SIZE, ARCHIVE_TRAILER_SIZE);
+            index_offset = stream.integer<u64>();
+            index_size = stream.integer<u64>();
+
+            char magic[ARCHIVE_MAGIC_SIZE];
+            stream.read(magic, ARCHIVE_MAGIC_SIZE);
+            if (std::memcmp(magic, ARCHIVE_INDEX_MAGIC, ARCHIVE_MAGIC_SIZE) != 0) {
+                throw RuntimeError("Archive index trailer has an invalid magic.");
+            }
+
+            const u64 limit = static_cast<u64>(size) - ARCHIVE_TRAILER_SIZE;
+            if (index_offset > limit || index_size > limit - index_offset) {
+                throw RuntimeError("Archive index lies outside of the archive.");
+            }
+        }
+    };
+
+    struct ArchiveIndexEncoder {
+        vec<ArchiveRecord> records;
+        str pool;
+
+        void add(std::string_view path, ArchiveKind kind, u64 offset = 0, u64 size = 0, u64 hash = 0) {
+            add(path, kind, offset, size, size, hash, 0);
+        }
+
+        void add(std::string_view path, ArchiveKind kind, u64 offset, u64 packed_size, u64 size, u64 hash, u32 flags) {
+            ArchiveRecord record;
+            record.kind = kind;
+            record.flags = flags;
+            record.path_size = static_cast<u32>(path.size());
+            record.path_offset = static_cast<u64>(pool.size());
+            record.offset = offset;
+            record.packed_size = packed_size;
+            record.size = size;
+            record.hash = hash;
+            pool.append(path);
+            records.emplace_back(record);
+        }
+
+        /// Orders records by path; required before encoding.
+        void sort() {
+            std::sort(records.begin(), records.end(), [this](const ArchiveRecord& lhs, const ArchiveRecord& rhs) {
+                return path(lhs) < path(rhs);
+            });
+        }
+
+        use std::string_view path(const ArchiveRecord& record) const {
+            return std::string_view(pool).substr(static_cast<usize>(record.path_offset), record.path_size);
+        }
+
+        vec<byte> encode() const {
+            EncodeStream stream;
+            stream.integer<u64>(records.size());
+            for (const auto& record : records) {
+                stream.integer<u32>(static_cast<u32>(record.kind));
+                stream.integer<u32>(record.flags);
+                stream.integer<u32>(record.path_size);
+                stream.integer<u64>(record.path_offset);
+                stream.integer<u64>(record.offset);
+                stream.integer<u64>(record.packed_size);
+                stream.integer<u64>(record.size);
+                stream.integer<u64>(record.hash);
+            }
+            stream.integer<u64>(pool.size());
+            stream.write(pool.data(), pool.size());
+            return stream.finish();
+        }
+    };
+
+    /**
+     * Decodes an index section in place. Record fields are copied into
+     * `records`, while `pool` keeps pointing into the supplied buffer.
+     */
+    struct ArchiveIndexDecoder {
+        vec<ArchiveRecord> records;
+        std::string_view pool;
+
+        void decode(const byte* data, usize size) {
+            DecodeStream stream(data, size);
+            const auto count = stream.integer<u64>();
+            if (count > (size - sizeof(u64)) / ARCHIVE_RECORD_SIZE) {
+                throw RuntimeError("Archive index record count exceeds the index size.");
+            }
+
+            records.clear();
+            records.reserve(static_cast<usize>(count));
+            for (u64 i = 0; i < count; ++i) {
+                ArchiveRecord record;
+                record.kind = static_cast<ArchiveKind>(stream.integer<u32>());
+                record.flags = stream.integer<u32>();
+                record.path_size = stream.integer<u32>();
+                record.path_offset = stream.integer<u64>();
+                record.offset = stream.integer<u64>();
+                record.packed_size = stream.integer<u64>();
+                record.size = stream.integer<u64>();
+                record.hash = stream.integer<u64>();
+                records.emplace_back(record);
+            }
+
+            const auto pool_size = stream.integer<u64>();
+            const usize pool_begin = sizeof(u64) + static_cast<usize>(count) * ARCHIVE_RECORD_SIZE + sizeof(u64);
+            if (pool_begin > size || pool_size > size - pool_begin) {
+                throw RuntimeError("Archive index path pool exceeds the index size.");
+            }
+            pool = std::string_view(reinterpret_cast<const char*>(data + pool_begin), static_cast<usize>(pool_size));
+
+            for (const auto& record : records) {
+                if (record.path_offset > pool.size() || record.path_size > pool.size() - record.path_offset) {
+                    throw RuntimeError("Archive index record references a path outside of the pool.");
+                }
+            }
+        }
+
+        use std::string_view path(const ArchiveRecord& record) const {
+            return pool.substr(static_cast<usize>(record.path_offset), record.path_size);
+        }
+    };
+}
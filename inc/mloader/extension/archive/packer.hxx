@@ -0,0 +1,44 @@
+#pragma once
+
+#include "mtl/common.hxx"
+#include "mtl/fs/path/path.hxx"
+
+namespace mloader::extension {
+
+    struct PackOptions {
+        /// Directory to pack.
+        mtl::fs::Path source;
+        /// Archive to write; replaced only once the pack succeeded.
+        mtl::fs::Path output;
+        /// Extension config inside `source`; may be missing when `name` is set.
+        str config = "index.yml";
+        /// Override the config's name and version.
+        str name;
+        str version_text;
+        /// Worker threads; 0 uses the hardware concurrency.
+        usize jobs = 0;
+        /// Files read ahead of the writer; 0 means four per worker.
+        usize window = 0;
+        /// Compress entries that shrink with the built-in LZ codec.
+        bool compress = false;
+    };
+
+    struct PackSummary {
+        usize files = 0;
+        /// Archive records, directories included.
+        usize entries = 0;
+        u64 bytes = 0;
+        usize workers = 0;
+        usize compressed = 0;
+        /// Bytes saved by compressed entries.
+        u64 saved = 0;
+    };
+
+    /**
+     * Packs a content directory into an archive BinaryDatabase can map. Files
+     * are read, hashed and compressed on a worker pool and written in path
+     * order through ArchiveWriter, so a failure leaves no partial archive.
+     */
+    PackSummary pack_directory(const PackOptions& options);
+
+} // namespace mloader::extension
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include "mtl/common.hxx"
+#include "mtl/error.hxx"
+#include "mtl/fs/path/path.hxx"
+
+#include "mloader/extension/archive/checksum.hxx"
+#include "mloader/extension/archive/constants.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/extension/archive/index.hxx"
+
+namespace mloader::extension {
+
+    /**
+     * Streams a pack to disk front to back: header, aligned payloads, index and
+     * trailer. Only the index is kept in memory, so the archive size is not
+     * bounded by available RAM. Checksums are accumulated on the way and
+     * patched into the header by finish(). Bytes go to `<target>.partial`,
+     * which finish() renames over `target`; a writer destroyed before that
+     * removes it, so a failed pack never leaves a truncated archive behind.
+     */
+    struct ArchiveWriter {
+        ArchiveWriter(const mtl::fs::Path& target, const ArchiveEncoder& header)
+            : m_target(target.string()), m_partial(m_target + ".partial"), m_header(header) {
+            m_stream.open(m_partial, std::ios::binary | std::ios::trunc | std::ios::out);
+            if (!m_stream.is_open()) {
+                throw RuntimeError("Failed to open archive for writing: " + m_target);
+            }
+            m_header.crc32 = 0;
+            std::memset(m_header.sha256, 0, sizeof(m_header.sha256));
+            m_header.flags |= ARCHIVE_FLAG_CHECKSUMS;
+            write(m_header.encode_header());
+        }
+
+        ~ArchiveWriter() {
+            if (!m_finished) {
+                m_stream.close();
+                std::error_code ec;
+                std::filesystem::remove(m_partial, ec);
+            }
+        }
+
+        ArchiveWriter(const ArchiveWriter&) = delete;
+        ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+        void add_dir(std::string_view path) {
+            m_index.add(path, ArchiveKind::dir);
+        }
+
+        void add_file(std::string_view path, const byte* data, u64 size, u64 hash) {
+            pad();
+            m_index.add(path, ArchiveKind::file, m_offset, size, hash);
+            write(data, size);
+        }
+
+        /// Adds a payload already compressed with compress_lz(); `size` and `hash` describe the original bytes.
+        void add_compressed(std::string_view path, const byte* packed, u64 packed_size, u64 size, u64 hash) {
+            pad();
+            m_index.add(path, ArchiveKind::file, m_offset, packed_size, size, hash, ARCHIVE_RECORD_LZ);
+            write(packed, packed_size);
+        }
+
+        /// Writes the index and trailer, then moves the archive into place. @return Total archive size in bytes.
+        u64 finish() {
+            m_index.sort();
+
+            ArchiveTrailer trailer;
+            trailer.index_offset = m_offset;
+            const vec<byte> index = m_index.encode();
+            trailer.index_size = index.size();
+            write(index);
+            write(trailer.encode());
+
+            // The header has a fixed layout up to the checksums, so re-encoding
+            // it yields the same size and only the checksum bytes change.
+            const ArchiveChecksums sums = m_checksums.finish();
+            m_header.crc32 = sums.crc32;
+            std::memcpy(m_header.sha256, sums.sha256.data(), sizeof(m_header.sha256));
+            const vec<byte> header = m_header.encode_header();
+            m_stream.seekp(0);
+            m_stream.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+            m_stream.close();
+            if (m_stream.fail()) {
+                throw RuntimeError("Failed to finish archive: " + m_target);
+            }
+            std::error_code ec;
+            std::filesystem::rename(m_partial, m_target, ec);
+            if (ec) {
+                throw RuntimeError("Failed to move archive into place: " + m_target + ": " + ec.message());
+            }
+            m_finished = true;
+            return m_offset;
+        }
+
+        prop u64 offset() const noexcept { return m_offset; }
+        prop usize count() const noexcept { return m_index.records.size(); }
+
+    protected:
+        void pad() {
+            static constexpr byte zeros[ARCHIVE_ALIGNMENT]{};
+            const u64 rem = m_offset % ARCHIVE_ALIGNMENT;
+            if (rem != 0) {
+                write(zeros, ARCHIVE_ALIGNMENT - rem);
+            }
+        }
+
+        void write(const vec<byte>& data) {
+            write(data.data(), data.size());
+        }
+
+        void write(const byte* data, u64 size) {
+            if (size == 0) {
+                return;
+            }
+            m_stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!m_stream) {
+                throw RuntimeError("Failed to write archive: " + m_target);
+            }
+            m_checksums.update(data, size);
+            m_offset += size;
+        }
+
+        str m_target;
+        str m_partial;
+        ArchiveEncoder m_header;
+        ArchiveChecksumBuilder m_checksums;
+        std::ofstream m_stream;
+        ArchiveIndexEncoder m_index;
+        u64 m_offset = 0;
+        bool m_finished = false;
+    };
+}
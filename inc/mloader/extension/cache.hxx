@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string_view>
+
+#include "extension.hxx"
+
+namespace mloader::extension {
+
+    /**
+     * Persistent extension metadata keyed by source path, so a launcher can
+     * list hundreds of installed extensions without opening any of them.
+     * Entries are trusted only while the file's size and mtime are unchanged.
+     */
+    struct ExtensionCache {
+        ExtensionCache() = default;
+
+        /// @return Cached metadata for `path`, or null when unknown or stale.
+        use const Extension* find(std::string_view path, u64 size, i64 mtime) const;
+        void store(std::string_view path, u64 size, i64 mtime, const Extension& info);
+        /// Drops every entry whose path is not in `paths`.
+        void retain(const vec<str>& paths);
+        void clear() noexcept;
+
+        prop usize size() const noexcept { return m_entries.size(); }
+
+        use vec<byte> encode() const;
+        /// @return False, leaving the cache empty, for blobs of another format or version.
+        bool decode(const byte* data, usize size);
+
+        void save(const mtl::fs::Path& file) const;
+        /// A missing or unreadable file leaves the cache empty and returns false.
+        bool load(const mtl::fs::Path& file);
+
+    protected:
+        struct Entry {
+            u64 size = 0;
+            i64 mtime = 0;
+            Extension info;
+        };
+
+        umap<str, Entry> m_entries;
+    };
+
+}
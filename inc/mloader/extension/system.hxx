@@ -1,30 +1,87 @@
 #pragma once
 
+#include <string_view>
+
+#include "cache.hxx"
 #include "extension.hxx"
+#include "mloader/database/joined.hxx"
+#include "mloader/defs/registry.hxx"
+#include "mloader/worker.hxx"
 
 
 namespace mloader::extension {
     using mtl::fs::Path;
 
+    /// Config file that marks an unpacked extension directory (as read by mpacker).
+    constexpr cstr EXTENSION_CONFIG = "index.yml";
+    /// File suffix of packed extensions.
+    constexpr cstr EXTENSION_ARCHIVE_SUFFIX = ".mlda";
+
+    /**
+     * Discovers extensions in a set of locations and loads them in dependency
+     * order. Every location is searched one level deep for packed archives
+     * and for directories holding an EXTENSION_CONFIG. Extensions that do not
+     * depend on each other are loaded concurrently, one topological frontier
+     * at a time.
+     */
     struct ExtensionSystem {
-        ExtensionSystem(Path data_root) {
-            
-        }
+        /// A discovered extension and the database serving its files.
+        struct Installed {
+            Extension info;
+            Path source;
+            uptr<Database> db;
+        };
 
+        explicit ExtensionSystem(Path data_root);
+        ~ExtensionSystem();
 
-        void scan() {
-            // scan extension locations for extensions
-        }
+        /**
+         * Reads the header or config of every extension in the locations,
+         * in parallel, replacing the previous scan. Archives are only probed
+         * for their header, and files whose size and mtime match cache() are
+         * not opened at all. Throws RuntimeError listing every extension that
+         * could not be read.
+         */
+        void scan();
 
+        /**
+         * Orders the scanned extensions into frontiers: every extension comes
+         * after its dependencies and after installed optional dependencies,
+         * and the members of one frontier do not depend on each other.
+         * Throws RuntimeError listing every duplicate, missing dependency,
+         * incompatible pair and dependency cycle.
+         * @return Indices into extensions(), frontier by frontier, sorted by name within one.
+         */
+        use vec<vec<usize>> solve() const;
 
+        /**
+         * Loads the scanned extensions frontier by frontier on `pool`: their
+         * databases are loaded and the YAML files under `definitions` are
+         * resolved concurrently, then ingested into `registry` in frontier
+         * order. Finally every database is mounted into content() so that
+         * dependents override the files of their dependencies.
+         */
+        void load(DefinitionRegistry& registry, WorkerPool& pool = WorkerPool::shared());
 
         void add_location(const Path& location);
         void remove_location(const Path& location);
         const vec<Path>& locations();
 
+        prop const vec<uptr<Installed>>& extensions() const noexcept { return m_extensions; }
+        /// @return Scanned extension named `name`, or null.
+        use const Installed* find(std::string_view name) const;
+        /// Merged view over the files of every loaded extension.
+        prop JoinedDatabase& content() noexcept { return m_content; }
+        /// Metadata of the last scan; load() and save() it to skip probing across runs.
+        prop ExtensionCache& cache() noexcept { return m_cache; }
+
     protected:
-        vec<uptr<Extension>> m_extensions;
+        void unmount_all();
+
+        vec<uptr<Installed>> m_extensions;
         vec<Path> m_locations;
+        ExtensionCache m_cache;
+        JoinedDatabase m_content;
     };
 
-}
\ No newline at end of file
+}
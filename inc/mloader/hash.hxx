@@ -0,0 +1,10 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+namespace mloader {
+
+    /// 64-bit content hash (xxHash64). Stable across platforms and releases.
+    use u64 hash64(const void* data, usize size, u64 seed = 0) noexcept;
+
+} // namespace mloader
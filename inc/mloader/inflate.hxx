@@ -0,0 +1,20 @@
+#pragma once
+
+#include <span>
+
+#include "mtl/common.hxx"
+
+namespace mloader {
+
+    /**
+     * Decodes a raw DEFLATE stream (RFC 1951, no zlib or gzip framing) into
+     * `output`, which must be exactly the decompressed size recorded by the
+     * container. Throws RuntimeError on corrupt or truncated input and when
+     * the stream does not produce exactly `output.size()` bytes.
+     */
+    void inflate(std::span<const byte> input, std::span<byte> output);
+
+    /// @return Decompressed bytes of a raw DEFLATE stream with a known size.
+    use vec<byte> inflate(std::span<const byte> input, usize size);
+
+} // namespace mloader
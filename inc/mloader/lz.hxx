@@ -0,0 +1,25 @@
+#pragma once
+
+#include <span>
+
+#include "mtl/common.hxx"
+
+namespace mloader {
+
+    /**
+     * Compresses `input` with the built-in LZ codec used for archive entries:
+     * byte-aligned LZ77 sequences (literal run, 16-bit back distance, match
+     * length) in the layout of the LZ4 block format, tuned for decoding
+     * speed rather than ratio.
+     * @return Compressed bytes, or empty when they would not be smaller than the input.
+     */
+    use vec<byte> compress_lz(std::span<const byte> input);
+
+    /**
+     * Decodes a compress_lz() block into `output`, which must be exactly the
+     * uncompressed size. Throws RuntimeError on corrupt or truncated input
+     * and when the block does not produce exactly `output.size()` bytes.
+     */
+    void decompress_lz(std::span<const byte> input, std::span<byte> output);
+
+} // namespace mloader
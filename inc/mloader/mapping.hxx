@@ -0,0 +1,40 @@
+#pragma once
+
+#include "mtl/common.hxx"
+#include "mtl/fs/path/path.hxx"
+
+namespace mloader {
+
+    /**
+     * Read-only memory mapping of a whole file. The mapping stays valid until
+     * close() or destruction; pointers into it must not outlive the owner.
+     */
+    struct MappedFile {
+        ctor MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /// Maps the given file, replacing any previous mapping. Throws on failure.
+        void open(const mtl::fs::Path& path);
+        /// Releases the mapping.
+        void close() noexcept;
+
+        prop bool is_open() const noexcept { return m_open; }
+        prop const byte* data() const noexcept { return m_data; }
+        prop usize size() const noexcept { return m_size; }
+
+    private:
+        const byte* m_data = nullptr;
+        usize m_size = 0;
+        bool m_open = false;
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+
+} // namespace mloader
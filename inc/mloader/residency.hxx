@@ -0,0 +1,88 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+#include "mloader/resource.hxx"
+
+#include <atomic>
+#include <mutex>
+
+namespace mloader {
+
+    /**
+     * Byte budget over resolved resources and the payloads parsed from them.
+     * Every resource that gets a parsed payload is charged its own size plus
+     * the payload's footprint; payloads that borrow the resource bytes add
+     * nothing on top. trim() evicts the payloads of the least recently used
+     * unpinned resources until the total fits the budget and releases their
+     * whole charge: assets re-resolve on their next access and parse again,
+     * so the old bytes go once no handle is left.
+     *
+     * Eviction only happens inside trim(), so references returned by asset
+     * accessors stay valid until the application calls it at a safe point
+     * (between frames or loading stages). Hold a ResidencyPin to keep a
+     * payload across trims.
+     */
+    struct ResidencyManager {
+        /// @param budget Resident bytes trim() aims for; 0 disables eviction.
+        explicit ResidencyManager(u64 budget = 0);
+        ~ResidencyManager();
+
+        ResidencyManager(const ResidencyManager&) = delete;
+        ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+        void set_budget(u64 budget) noexcept;
+        prop u64 budget() const noexcept { return m_budget.load(std::memory_order_relaxed); }
+        /// @return Bytes currently charged to tracked resources and payloads.
+        use u64 resident() const;
+        /// @return Number of live resources being tracked.
+        use usize tracked() const;
+
+        /**
+         * Runs `insert` under the manager's lock and charges the payload bytes
+         * it returns to `resource`, attaching the resource on first use.
+         * Serialising insertion with trim() keeps the accounting exact.
+         */
+        void track(Resource& resource, const function<u64()>& insert);
+        /// Marks the resource as used now; lock-free, called on every payload access.
+        void touch(Resource& resource) const noexcept;
+        /// Stops tracking a resource that is being destroyed.
+        void forget(Resource& resource) noexcept;
+
+        /// Evicts down to budget(); returns the number of resources whose payloads were dropped.
+        usize trim();
+        usize trim(u64 target);
+
+        /// Process-wide manager used by databases without their own; unlimited by default.
+        static ResidencyManager& shared();
+
+    protected:
+        mutable std::mutex m_mutex;
+        vec<Resource*> m_resources;
+        u64 m_resident = 0;
+        std::atomic<u64> m_budget{0};
+        /// Coarse use clock; advances on every track() and trim().
+        std::atomic<u64> m_clock{1};
+    };
+
+    /**
+     * Keeps a resource's parsed payloads out of ResidencyManager::trim() while
+     * alive. Take the pin before reading the payload it protects.
+     */
+    struct ResidencyPin {
+        ResidencyPin() = default;
+        explicit ResidencyPin(ResourceHandle handle);
+        ~ResidencyPin();
+
+        ResidencyPin(const ResidencyPin&) = delete;
+        ResidencyPin& operator=(const ResidencyPin&) = delete;
+        ResidencyPin(ResidencyPin&& other) noexcept = default;
+        ResidencyPin& operator=(ResidencyPin&& other) noexcept;
+
+        use bool valid() const { return m_handle.valid(); }
+
+    private:
+        ResourceHandle m_handle;
+    };
+
+} // namespace mloader
@@ -2,10 +2,9 @@
 
 #include "mtl/common.hxx"
 
+#include <array>
 #include <atomic>
-#include <any>
 #include <mutex>
-#include <unordered_map>
 
 namespace mloader {
 
@@ -13,6 +12,18 @@ namespace mloader {
     struct Asset;
 
     struct Database;
+    struct ResidencyManager;
+
+    /// Upper bound on AssetType values; one payload slot per type on every Resource.
+    constexpr usize ASSET_SLOT_COUNT = 8;
+
+    /// Parsed asset payload owned by a Resource slot.
+    struct AssetPayload {
+        virt ~AssetPayload() = default;
+
+        /// Identifies the concrete payload type; checked before every downcast.
+        const void* tag = nullptr;
+    };
 
     /**
      * Base class representing a contiguous data payload owned by a Database.
@@ -21,7 +32,7 @@ namespace mloader {
      */
     struct Resource {
         explicit Resource(Database& owner);
-        virt ~Resource() = default;
+        virt ~Resource();
 
         /// @return Database that created and manages this resource instance.
         use Database& db() const;
@@ -37,6 +48,30 @@ namespace mloader {
         /// Decreases the external reference count and destroys at zero.
         void dec_ref();
 
+        /**
+         * Increases the reference count unless it already dropped to zero.
+         * Caches holding non-owning pointers use this so a resource that is
+         * being destroyed is never handed out again.
+         */
+        use bool try_ref() noexcept;
+
+        /// @return Number of live handles referencing this resource.
+        use u32 refcount() const noexcept;
+
+        /**
+         * True once the backing data changed or disappeared in the database.
+         * Existing handles keep the old bytes; Asset re-resolves on next access.
+         */
+        use bool stale() const noexcept;
+        void mark_stale() noexcept;
+
+        /// Exempts the parsed payloads from residency trims while the count is non-zero.
+        void pin();
+        void unpin();
+        use bool pinned() const noexcept;
+        /// Advances every time the residency manager evicts this resource's payloads.
+        use u32 generation() const noexcept;
+
     protected:
         /// Allows derived classes to customise destruction strategies.
         virt void destroy_self();
@@ -44,10 +79,23 @@ namespace mloader {
     private:
         Database* m_db;
         std::atomic<u32> m_refcount{0};
+        std::atomic<bool> m_stale{false};
+
+        friend struct ResidencyManager;
+        std::atomic<u32> m_pins{0};
+        std::atomic<u32> m_generation{0};
+        std::atomic<u64> m_last_use{0};
+        std::atomic<ResidencyManager*> m_residency{nullptr};
+        /// Charged bytes and slot in m_residency; guarded by its mutex.
+        u64 m_charge = 0;
+        usize m_residency_slot = 0;
 
         friend struct Asset;
-        mutable std::mutex m_asset_mutex;
-        mutable std::unordered_map<int, std::any> m_asset_cache;
+        /// Held while parsing so each slot is parsed once; published slots are read without it.
+        mutable std::mutex m_parse_mutex;
+        /// Orders pin changes against residency eviction.
+        mutable std::mutex m_pin_mutex;
+        mutable std::array<std::atomic<AssetPayload*>, ASSET_SLOT_COUNT> m_payloads{};
     };
 
     /**
@@ -58,6 +106,9 @@ namespace mloader {
     struct ResourceHandle {
         explicit ResourceHandle(Resource* res = nullptr);
 
+        /// Wraps a resource whose reference was already taken (e.g. by try_ref()).
+        static ResourceHandle adopt(Resource* res);
+
         ResourceHandle(const ResourceHandle& other);
         ResourceHandle(ResourceHandle&& other) noexcept;
         ~ResourceHandle();
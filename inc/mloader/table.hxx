@@ -0,0 +1,89 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+namespace mloader {
+
+    /**
+     * Flat open-addressing table from key hashes to dense u32 values, shared
+     * by PathIndex, SymbolTable and the registry's per-type indexes. The
+     * owner keeps the keys; each bucket holds the upper half of the key's
+     * hash as a tag next to the value, so a probe touches one cache line and
+     * the owner's key comparison only runs on a tag match. Linear probing
+     * from `hash & mask`; the load factor stays at or below one half.
+     */
+    struct FlatTable {
+        static constexpr u32 npos = ~u32(0);
+
+        /// Empties the table and sizes it for `count` values without growing.
+        void reserve(usize count);
+        void clear() noexcept;
+
+        prop usize size() const noexcept { return m_size; }
+        prop bool empty() const noexcept { return m_size == 0; }
+
+        /**
+         * @param equals Called with candidate values whose tag matches; returns
+         *        true when the value's key is the one looked up.
+         * @return The matching value, or npos.
+         */
+        template<typename Equals>
+        use u32 find(u64 hash, Equals&& equals) const noexcept;
+
+        /**
+         * Adds a value whose key the caller checked is absent.
+         * @param hash_of Returns the key hash of a stored value; used when growing.
+         */
+        template<typename HashOf>
+        void insert(u64 hash, u32 value, HashOf&& hash_of);
+
+    protected:
+        struct Bucket {
+            u32 tag = 0;
+            u32 value = npos;
+        };
+
+        void place(u64 hash, u32 value) noexcept;
+
+        vec<Bucket> m_buckets;
+        u64 m_mask = 0;
+        usize m_size = 0;
+    };
+
+    template<typename Equals>
+    u32 FlatTable::find(u64 hash, Equals&& equals) const noexcept {
+        if (m_buckets.empty()) {
+            return npos;
+        }
+
+        const auto tag = static_cast<u32>(hash >> 32);
+        for (u64 i = hash & m_mask;; i = (i + 1) & m_mask) {
+            const Bucket& bucket = m_buckets[static_cast<usize>(i)];
+            if (bucket.value == npos) {
+                return npos;
+            }
+            if (bucket.tag == tag && equals(bucket.value)) {
+                return bucket.value;
+            }
+        }
+    }
+
+    template<typename HashOf>
+    void FlatTable::insert(u64 hash, u32 value, HashOf&& hash_of) {
+        if ((m_size + 1) * 2 > m_buckets.size()) {
+            const vec<Bucket> previous = std::move(m_buckets);
+            const usize count = m_size;
+            // Sized for as many values as there were buckets: twice the capacity.
+            reserve(previous.size());
+            for (const Bucket& bucket : previous) {
+                if (bucket.value != npos) {
+                    place(hash_of(bucket.value), bucket.value);
+                }
+            }
+            m_size = count;
+        }
+        place(hash, value);
+        ++m_size;
+    }
+
+} // namespace mloader
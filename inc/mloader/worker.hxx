@@ -0,0 +1,59 @@
+#pragma once
+
+#include "mtl/common.hxx"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace mloader {
+
+    /**
+     * Fixed-size thread pool shared by the loaders. Tasks are executed in FIFO
+     * order; parallel() lets the calling thread take part in the work so that
+     * nested use from inside a task cannot starve the pool.
+     */
+    struct WorkerPool {
+        /// @param threads Worker count; 0 selects the hardware concurrency.
+        explicit WorkerPool(usize threads = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /// Queues a task and returns a future for its result.
+        template<typename Fn>
+        auto submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>>;
+
+        /// Runs body(i) for every i in [0, count) and waits; rethrows the first failure.
+        void parallel(usize count, const function<void(usize)>& body);
+
+        prop usize size() const noexcept { return m_threads.size(); }
+
+        /// Process-wide pool sized to the hardware concurrency.
+        static WorkerPool& shared();
+
+    protected:
+        void post(function<void()> task);
+        void run();
+
+        vec<std::thread> m_threads;
+        std::deque<function<void()>> m_queue;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+
+    template<typename Fn>
+    auto WorkerPool::submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>> {
+        using Result = std::invoke_result_t<std::decay_t<Fn>>;
+        auto task = make_sptr<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+        auto future = task->get_future();
+        post([task] { (*task)(); });
+        return future;
+    }
+
+} // namespace mloader
@@ -1,7 +1,23 @@
 #include "mloader/asset.hxx"
 
-#include <algorithm>
 #include <cctype>
+#include <climits>
+#include <cstring>
+#include <span>
+
+#ifdef MLOADER_HAS_SPNG
+#include <spng.h>
+#endif
+
+#ifdef MLOADER_HAS_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef MLOADER_HAS_STB
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_STDIO
+#include <stb_image.h>
+#endif
 
 using namespace mloader;
 
@@ -47,6 +63,105 @@ namespace {
         return "unknown";
     }
 
+    using Image = ImageAsset::Image;
+
+    [[maybe_unused]] void allocate(Image& image, u32 width, u32 height, u32 channels) {
+        image.width = width;
+        image.height = height;
+        image.channels = channels;
+        image.stride = static_cast<usize>(width) * channels;
+        image.pixels.resize(image.stride * height);
+    }
+
+#ifdef MLOADER_HAS_SPNG
+    bool decode_png(std::span<const byte> encoded, Image& image) {
+        spng_ctx* ctx = spng_ctx_new(0);
+        if (!ctx) {
+            return false;
+        }
+
+        struct spng_ihdr ihdr {};
+        struct spng_trns trns {};
+        bool ok = spng_set_png_buffer(ctx, encoded.data(), encoded.size()) == 0 &&
+                  spng_get_ihdr(ctx, &ihdr) == 0;
+        if (ok) {
+            const bool alpha = ihdr.color_type == SPNG_COLOR_TYPE_TRUECOLOR_ALPHA ||
+                               ihdr.color_type == SPNG_COLOR_TYPE_GRAYSCALE_ALPHA ||
+                               spng_get_trns(ctx, &trns) == 0;
+            const int format = alpha ? SPNG_FMT_RGBA8 : SPNG_FMT_RGB8;
+            allocate(image, ihdr.width, ihdr.height, alpha ? 4 : 3);
+            ok = spng_decode_image(ctx, image.pixels.data(), image.pixels.size(), format, SPNG_DECODE_TRNS) == 0;
+        }
+        spng_ctx_free(ctx);
+        return ok;
+    }
+#endif
+
+#ifdef MLOADER_HAS_TURBOJPEG
+    bool decode_jpeg(std::span<const byte> encoded, Image& image) {
+        tjhandle handle = tjInitDecompress();
+        if (!handle) {
+            return false;
+        }
+
+        int width = 0;
+        int height = 0;
+        int subsampling = 0;
+        int colorspace = 0;
+        const auto size = static_cast<unsigned long>(encoded.size());
+        bool ok = tjDecompressHeader3(handle, encoded.data(), size, &width, &height, &subsampling, &colorspace) == 0;
+        if (ok) {
+            const bool gray = colorspace == TJCS_GRAY;
+            allocate(image, static_cast<u32>(width), static_cast<u32>(height), gray ? 1 : 3);
+            ok = tjDecompress2(handle, encoded.data(), size, image.pixels.data(), width,
+                               static_cast<int>(image.stride), height, gray ? TJPF_GRAY : TJPF_RGB, 0) == 0;
+        }
+        tjDestroy(handle);
+        return ok;
+    }
+#endif
+
+#ifdef MLOADER_HAS_STB
+    bool decode_stb(std::span<const byte> encoded, Image& image) {
+        if (encoded.size() > static_cast<usize>(INT_MAX)) {
+            return false;
+        }
+
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()),
+                                                &width, &height, &channels, 0);
+        if (!pixels) {
+            return false;
+        }
+        allocate(image, static_cast<u32>(width), static_cast<u32>(height), static_cast<u32>(channels));
+        std::memcpy(image.pixels.data(), pixels, image.pixels.size());
+        stbi_image_free(pixels);
+        return true;
+    }
+#endif
+
+    /// Tries the dedicated decoder for the format first, then stb.
+    bool decode_image([[maybe_unused]] std::span<const byte> encoded, [[maybe_unused]] Image& image) {
+#ifdef MLOADER_HAS_SPNG
+        if (image.format == "png" && decode_png(encoded, image)) {
+            return true;
+        }
+#endif
+#ifdef MLOADER_HAS_TURBOJPEG
+        if (image.format == "jpeg" && decode_jpeg(encoded, image)) {
+            return true;
+        }
+#endif
+#ifdef MLOADER_HAS_STB
+        if (decode_stb(encoded, image)) {
+            return true;
+        }
+#endif
+        return false;
+    }
+
     str detect_sound_format(const byte* data, usize size) {
         if (!data || size < 4) {
             return "unknown";
@@ -113,13 +228,8 @@ namespace {
         return "unknown";
     }
 
-    void copy_bytes(const void* source, usize size, vec<byte>& target) {
-        target.resize(size);
-        if (size == 0) {
-            return;
-        }
-        const auto* raw = static_cast<const byte*>(source);
-        std::copy(raw, raw + size, target.begin());
+    std::span<const byte> view(const Resource& resource) {
+        return {static_cast<const byte*>(resource.data()), static_cast<usize>(resource.size())};
     }
 
     str read_text(const void* source, usize size) {
@@ -143,22 +253,85 @@ namespace {
 
 } // namespace
 
-std::any BinaryAsset::parse_resource(Resource& resource) const {
-    Data data;
-    copy_bytes(resource.data(), static_cast<usize>(resource.size()), data);
-    return data;
+const AssetPayload& Asset::parse_once(Resource& resource, usize slot, Parser parse) {
+    // Late callers wait here and take the payload the first one published.
+    std::lock_guard lock(resource.m_parse_mutex);
+    if (const AssetPayload* payload = resource.m_payloads[slot].load(std::memory_order_acquire)) {
+        return *payload;
+    }
+
+    uptr<AssetPayload> payload = parse(resource);
+    const AssetPayload& published = *payload;
+    const u64 bytes = footprint(slot, published);
+    // Publishing under the residency lock keeps trim() from evicting a
+    // payload before it has been charged.
+    resource.db().residency().track(resource, [&]() -> u64 {
+        resource.m_payloads[slot].store(payload.release(), std::memory_order_release);
+        return bytes;
+    });
+    return published;
 }
 
-std::any ImageAsset::parse_resource(Resource& resource) const {
+u64 Asset::footprint(usize slot, const AssetPayload& payload) {
+    switch (static_cast<AssetType>(slot)) {
+    case AssetType::image: {
+        const auto& image = value_of<ImageAsset::Image>(payload);
+        return image.pixels.capacity() + image.format.capacity();
+    }
+    case AssetType::shader:
+    case AssetType::text:
+        return value_of<str>(payload).capacity();
+    default:
+        // Binary, sound and font payloads borrow the resource bytes, which
+        // are charged to the resource itself and released when it is evicted.
+        return 0;
+    }
+}
+
+Asset::Parser BinaryAsset::parser() const {
+    return &BinaryAsset::parse;
+}
+
+uptr<AssetPayload> BinaryAsset::parse(Resource& resource) {
+    return make_parsed(Data(view(resource)));
+}
+
+Asset::Parser ImageAsset::parser() const {
+    return &ImageAsset::parse;
+}
+
+bool ImageAsset::supports([[maybe_unused]] std::string_view format) noexcept {
+#ifdef MLOADER_HAS_STB
+    return format != "unknown";
+#else
+    bool supported = false;
+#ifdef MLOADER_HAS_SPNG
+    supported = supported || format == "png";
+#endif
+#ifdef MLOADER_HAS_TURBOJPEG
+    supported = supported || format == "jpeg";
+#endif
+    return supported;
+#endif
+}
+
+uptr<AssetPayload> ImageAsset::parse(Resource& resource) {
+    const auto encoded = view(resource);
     Image image;
-    const auto size = static_cast<usize>(resource.size());
-    const auto* raw = static_cast<const byte*>(resource.data());
-    image.format = detect_image_format(raw, size);
-    copy_bytes(raw, size, image.pixels);
-    return image;
+    image.format = detect_image_format(encoded.data(), encoded.size());
+    if (!decode_image(encoded, image)) {
+        throw RuntimeError(supports(image.format)
+                               ? "Failed to decode " + image.format + " image."
+                               : "No decoder available for image format: " + image.format);
+    }
+    return make_parsed(std::move(image));
+}
+
+Asset::Parser ShaderAsset::parser() const {
+    return &ShaderAsset::parse;
 }
 
-std::any ShaderAsset::parse_resource(Resource& resource) const {
+uptr<AssetPayload> ShaderAsset::parse(Resource& resource) {
     str shader = read_text(resource.data(), static_cast<usize>(resource.size()));
     // Normalise line endings to LF for predictable shader processing.
     str normalised;
@@ -176,28 +349,36 @@ std::any ShaderAsset::parse_resource(Resource& resource) const {
     if (normalised.empty()) {
         normalised = std::move(shader);
     }
-    return normalised;
+    return make_parsed(std::move(normalised));
 }
 
-std::any SoundAsset::parse_resource(Resource& resource) const {
+Asset::Parser SoundAsset::parser() const {
+    return &SoundAsset::parse;
+}
+
+uptr<AssetPayload> SoundAsset::parse(Resource& resource) {
     Sound sound;
-    const auto size = static_cast<usize>(resource.size());
-    const auto* raw = static_cast<const byte*>(resource.data());
-    sound.format = detect_sound_format(raw, size);
-    copy_bytes(raw, size, sound.samples);
-    return sound;
+    sound.samples = view(resource);
+    sound.format = detect_sound_format(sound.samples.data(), sound.samples.size());
+    return make_parsed(std::move(sound));
+}
+
+Asset::Parser FontAsset::parser() const {
+    return &FontAsset::parse;
 }
 
-std::any FontAsset::parse_resource(Resource& resource) const {
+uptr<AssetPayload> FontAsset::parse(Resource& resource) {
     Font font;
-    const auto size = static_cast<usize>(resource.size());
-    const auto* raw = static_cast<const byte*>(resource.data());
-    font.format = detect_font_format(raw, size);
-    copy_bytes(raw, size, font.payload);
-    return font;
+    font.payload = view(resource);
+    font.format = detect_font_format(font.payload.data(), font.payload.size());
+    return make_parsed(std::move(font));
+}
+
+Asset::Parser TextAsset::parser() const {
+    return &TextAsset::parse;
 }
 
-std::any TextAsset::parse_resource(Resource& resource) const {
-    return read_text(resource.data(), static_cast<usize>(resource.size()));
+uptr<AssetPayload> TextAsset::parse(Resource& resource) {
+    return make_parsed(read_text(resource.data(), static_cast<usize>(resource.size())));
 }
 
@@ -0,0 +1,296 @@
+#include "mloader/checksum.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define MLOADER_CRC32C_SSE42 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define MLOADER_CRC32C_ARMV8 1
+#endif
+
+using namespace mloader;
+
+namespace {
+
+    /// Reflected CRC-32C polynomial.
+    constexpr u32 CRC32C_POLY = 0x82F63B78u;
+
+    struct CrcTables {
+        u32 table[8][256];
+
+        constexpr CrcTables() : table{} {
+            for (u32 i = 0; i < 256; ++i) {
+                u32 crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+                }
+                table[0][i] = crc;
+            }
+            for (u32 i = 0; i < 256; ++i) {
+                for (usize t = 1; t < 8; ++t) {
+                    table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    constexpr CrcTables CRC_TABLES{};
+
+    u32 crc32c_portable(u32 crc, const byte* p, usize size) noexcept {
+        const auto& t = CRC_TABLES.table;
+        while (size >= 8) {
+            u64 word;
+            std::memcpy(&word, p, sizeof(word));
+            // Little-endian load; big-endian targets take the byte loop below.
+            if constexpr (std::endian::native == std::endian::little) {
+                word ^= crc;
+                crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+                      t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+                p += 8;
+                size -= 8;
+            } else {
+                break;
+            }
+        }
+        while (size--) {
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(MLOADER_CRC32C_SSE42)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("sse4.2")))
+#endif
+    u32 crc32c_sse42(u32 crc, const byte* p, usize size) noexcept {
+        u64 c = crc;
+        while (size >= 8) {
+            u64 word;
+            std::memcpy(&word, p, sizeof(word));
+            c = _mm_crc32_u64(c, word);
+            p += 8;
+            size -= 8;
+        }
+        auto c32 = static_cast<u32>(c);
+        while (size--) {
+            c32 = _mm_crc32_u8(c32, *p++);
+        }
+        return c32;
+    }
+
+    bool has_sse42() noexcept {
+#if defined(__SSE4_2__)
+        return true;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+#endif
+
+#if defined(MLOADER_CRC32C_ARMV8)
+    u32 crc32c_armv8(u32 crc, const byte* p, usize size) noexcept {
+        while (size >= 8) {
+            u64 word;
+            std::memcpy(&word, p, sizeof(word));
+            crc = __crc32cd(crc, word);
+            p += 8;
+            size -= 8;
+        }
+        while (size--) {
+            crc = __crc32cb(crc, *p++);
+        }
+        return crc;
+    }
+#endif
+
+    using CrcKernel = u32 (*)(u32, const byte*, usize) noexcept;
+
+    struct CrcBackend {
+        CrcKernel kernel = crc32c_portable;
+        cstr name = "portable";
+
+        CrcBackend() noexcept {
+#if defined(MLOADER_CRC32C_SSE42)
+            if (has_sse42()) {
+                kernel = crc32c_sse42;
+                name = "sse4.2";
+            }
+#elif defined(MLOADER_CRC32C_ARMV8)
+            kernel = crc32c_armv8;
+            name = "armv8";
+#endif
+        }
+    };
+
+    const CrcBackend& crc_backend() noexcept {
+        static const CrcBackend backend;
+        return backend;
+    }
+
+    /// a * b modulo the CRC polynomial, in reflected bit order.
+    u32 multiply_mod(u32 a, u32 b) noexcept {
+        u32 product = 0;
+        for (u32 mask = 1u << 31; mask != 0; mask >>= 1) {
+            if (a & mask) {
+                product ^= b;
+            }
+            b = b & 1 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+        }
+        return product;
+    }
+
+    /// x^(8 * bytes) modulo the polynomial, by repeated squaring.
+    u32 shift_factor(u64 bytes) noexcept {
+        u32 factor = 1u << 31;
+        u32 square = 1u << 23; // x^8: one byte
+        while (bytes != 0) {
+            if (bytes & 1) {
+                factor = multiply_mod(square, factor);
+            }
+            square = multiply_mod(square, square);
+            bytes >>= 1;
+        }
+        return factor;
+    }
+
+    constexpr u32 SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    constexpr u32 rotr(u32 value, int bits) noexcept {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+} // namespace
+
+u32 mloader::crc32c(const void* data, usize size, u32 crc) noexcept {
+    return ~crc_backend().kernel(~crc, static_cast<const byte*>(data), size);
+}
+
+u32 mloader::crc32c_combine(u32 first, u32 second, u64 second_size) noexcept {
+    return multiply_mod(shift_factor(second_size), first) ^ second;
+}
+
+cstr mloader::crc32c_backend() noexcept {
+    return crc_backend().name;
+}
+
+Sha256::Sha256() noexcept {
+    reset();
+}
+
+void Sha256::reset() noexcept {
+    m_state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    m_used = 0;
+    m_length = 0;
+}
+
+void Sha256::update(const void* data, usize size) noexcept {
+    const auto* p = static_cast<const byte*>(data);
+    m_length += size;
+
+    if (m_used != 0) {
+        const usize take = std::min(size, m_block.size() - m_used);
+        std::memcpy(m_block.data() + m_used, p, take);
+        m_used += take;
+        p += take;
+        size -= take;
+        if (m_used < m_block.size()) {
+            return;
+        }
+        compress(m_block.data());
+        m_used = 0;
+    }
+    while (size >= m_block.size()) {
+        compress(p);
+        p += m_block.size();
+        size -= m_block.size();
+    }
+    std::memcpy(m_block.data(), p, size);
+    m_used = size;
+}
+
+Sha256Digest Sha256::finish() noexcept {
+    const u64 bits = m_length * 8;
+    m_block[m_used++] = 0x80;
+    if (m_used > 56) {
+        std::memset(m_block.data() + m_used, 0, m_block.size() - m_used);
+        compress(m_block.data());
+        m_used = 0;
+    }
+    std::memset(m_block.data() + m_used, 0, 56 - m_used);
+    for (int i = 0; i < 8; ++i) {
+        m_block[56 + i] = static_cast<byte>(bits >> (56 - 8 * i));
+    }
+    compress(m_block.data());
+
+    Sha256Digest digest;
+    for (usize i = 0; i < m_state.size(); ++i) {
+        digest[4 * i] = static_cast<byte>(m_state[i] >> 24);
+        digest[4 * i + 1] = static_cast<byte>(m_state[i] >> 16);
+        digest[4 * i + 2] = static_cast<byte>(m_state[i] >> 8);
+        digest[4 * i + 3] = static_cast<byte>(m_state[i]);
+    }
+    return digest;
+}
+
+Sha256Digest Sha256::digest(const void* data, usize size) noexcept {
+    Sha256 sha;
+    sha.update(data, size);
+    return sha.finish();
+}
+
+void Sha256::compress(const byte* block) noexcept {
+    u32 w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = static_cast<u32>(block[4 * i]) << 24 | static_cast<u32>(block[4 * i + 1]) << 16 |
+               static_cast<u32>(block[4 * i + 2]) << 8 | static_cast<u32>(block[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        const u32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const u32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    u32 e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (int i = 0; i < 64; ++i) {
+        const u32 t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        const u32 t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
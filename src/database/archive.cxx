@@ -0,0 +1,680 @@
+#include "mloader/database/archive.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#include "mtl/error.hxx"
+
+#include "mloader/inflate.hxx"
+#include "mloader/worker.hxx"
+
+using namespace mloader;
+
+namespace {
+
+    using Member = ArchiveFileDatabase::Member;
+    using Kind = Database::Entry::Kind;
+
+    constexpr u32 ZIP_LOCAL_HEADER = 0x04034b50;
+    constexpr u32 ZIP_CENTRAL_HEADER = 0x02014b50;
+    constexpr u32 ZIP_END = 0x06054b50;
+    constexpr u32 ZIP64_END = 0x06064b50;
+    constexpr u32 ZIP64_LOCATOR = 0x07064b50;
+    constexpr usize ZIP_END_SIZE = 22;
+    constexpr u16 ZIP_STORED = 0;
+    constexpr u16 ZIP_DEFLATED = 8;
+    constexpr u16 ZIP_ENCRYPTED = 1;
+    constexpr usize TAR_BLOCK = 512;
+
+    u16 le16(const byte* p) noexcept {
+        return static_cast<u16>(p[0] | p[1] << 8);
+    }
+
+    u32 le32(const byte* p) noexcept {
+        return static_cast<u32>(p[0]) | static_cast<u32>(p[1]) << 8 | static_cast<u32>(p[2]) << 16 | static_cast<u32>(p[3]) << 24;
+    }
+
+    u64 le64(const byte* p) noexcept {
+        return static_cast<u64>(le32(p)) | static_cast<u64>(le32(p + 4)) << 32;
+    }
+
+    [[noreturn]] void malformed(const ArchiveFileDatabase::Path& file, const str& what) {
+        throw RuntimeError("Malformed archive '" + file.string() + "': " + what + ".");
+    }
+
+    /// Parses a whole decimal field of a pax header; anything else is malformed.
+    u64 pax_number(const ArchiveFileDatabase::Path& file, std::string_view text, const char* what) {
+        u64 value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (text.empty() || error != std::errc() || end != text.data() + text.size()) {
+            malformed(file, "pax " + str(what) + " '" + str(text) + "' is not a decimal number");
+        }
+        return value;
+    }
+
+    /// Days since 1970-01-01 of a proleptic Gregorian date.
+    i64 days_from_civil(i64 year, u32 month, u32 day) noexcept {
+        year -= month <= 2;
+        const i64 era = (year >= 0 ? year : year - 399) / 400;
+        const auto yoe = static_cast<u32>(year - era * 400);
+        const u32 doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const u32 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<i64>(doe) - 719468;
+    }
+
+    /// MS-DOS date and time (local time, two second resolution) as nanoseconds.
+    i64 dos_time(u16 date, u16 time) noexcept {
+        const i64 days = days_from_civil(1980 + (date >> 9), std::max<u32>((date >> 5) & 0xF, 1), std::max<u32>(date & 0x1F, 1));
+        const i64 seconds = days * 86400 + (time >> 11) * 3600 + ((time >> 5) & 0x3F) * 60 + (time & 0x1F) * 2;
+        return seconds * 1'000'000'000;
+    }
+
+    /// Tar numeric field: octal text, or base-256 when the high bit is set.
+    u64 tar_number(const byte* field, usize size) noexcept {
+        if (field[0] & 0x80) {
+            u64 value = field[0] & 0x7F;
+            for (usize i = 1; i < size; ++i) {
+                value = value << 8 | field[i];
+            }
+            return value;
+        }
+        u64 value = 0;
+        for (usize i = 0; i < size && field[i]; ++i) {
+            if (field[i] >= '0' && field[i] <= '7') {
+                value = value * 8 + (field[i] - '0');
+            }
+        }
+        return value;
+    }
+
+    str tar_string(const byte* field, usize size) {
+        const auto* text = reinterpret_cast<const char*>(field);
+        return str(text, ::strnlen(text, size));
+    }
+
+    bool tar_checksum_ok(const byte* header) noexcept {
+        u64 sum = 0;
+        for (usize i = 0; i < TAR_BLOCK; ++i) {
+            sum += (i >= 148 && i < 156) ? u8{' '} : header[i];
+        }
+        return sum == tar_number(header + 148, 8);
+    }
+
+    /**
+     * Turns a stored member name into an index key. Backslashes from Windows
+     * zip tools become separators and "." segments are dropped; absolute names
+     * and ".." segments are rejected so no member can escape the archive.
+     * @return Empty for the archive root.
+     */
+    str member_key(const ArchiveFileDatabase::Path& file, std::string_view name) {
+        str key;
+        usize start = 0;
+        str text(name);
+        std::replace(text.begin(), text.end(), '\\', '/');
+        if (!text.empty() && text.front() == '/') {
+            malformed(file, "member '" + text + "' has an absolute path");
+        }
+        while (start <= text.size()) {
+            const usize end = std::min(text.find('/', start), text.size());
+            const std::string_view segment(text.data() + start, end - start);
+            if (segment == "..") {
+                malformed(file, "member '" + text + "' escapes the archive root");
+            }
+            if (!segment.empty() && segment != ".") {
+                if (!key.empty()) {
+                    key += '/';
+                }
+                key += segment;
+            }
+            start = end + 1;
+        }
+        return key;
+    }
+
+    using Listing = umap<str, Member>;
+
+    void list_zip(const ArchiveFileDatabase::Path& file, const byte* base, usize size, Listing& members) {
+        if (size < ZIP_END_SIZE) {
+            malformed(file, "file is too short for a zip end of central directory");
+        }
+        // The end record sits in the last 64 KiB + 22 bytes, before an optional comment.
+        const usize floor = size > 0xFFFF + ZIP_END_SIZE ? size - 0xFFFF - ZIP_END_SIZE : 0;
+        usize end = size - ZIP_END_SIZE;
+        while (le32(base + end) != ZIP_END) {
+            if (end == floor) {
+                malformed(file, "zip end of central directory not found");
+            }
+            --end;
+        }
+
+        u64 count = le16(base + end + 10);
+        u64 directory_size = le32(base + end + 12);
+        u64 directory = le32(base + end + 16);
+        if ((count == 0xFFFF || directory_size == 0xFFFFFFFF || directory == 0xFFFFFFFF) && end >= 20 &&
+            le32(base + end - 20) == ZIP64_LOCATOR) {
+            const u64 record = le64(base + end - 20 + 8);
+            if (size < 56 || record > size - 56 || le32(base + record) != ZIP64_END) {
+                malformed(file, "zip64 end of central directory is invalid");
+            }
+            count = le64(base + record + 32);
+            directory_size = le64(base + record + 40);
+            directory = le64(base + record + 48);
+        }
+        if (directory > size || directory_size > size - directory) {
+            malformed(file, "central directory lies outside of the file");
+        }
+
+        const byte* at = base + directory;
+        const byte* limit = at + directory_size;
+        for (u64 i = 0; i < count; ++i) {
+            if (limit - at < 46 || le32(at) != ZIP_CENTRAL_HEADER) {
+                malformed(file, "central directory entry " + std::to_string(i) + " is invalid");
+            }
+            const u16 name_size = le16(at + 28);
+            const u16 extra_size = le16(at + 30);
+            const u16 comment_size = le16(at + 32);
+            const byte* name = at + 46;
+            const byte* extra = name + name_size;
+            const byte* next = extra + extra_size + comment_size;
+            if (next > limit) {
+                malformed(file, "central directory entry " + std::to_string(i) + " is truncated");
+            }
+
+            Member member;
+            member.flags = le16(at + 8);
+            member.method = le16(at + 10);
+            member.mtime = dos_time(le16(at + 14), le16(at + 12));
+            member.packed_size = le32(at + 20);
+            member.size = le32(at + 24);
+            member.offset = le32(at + 42);
+
+            // Zip64 extra fields replace, in order, exactly the fields saturated above.
+            for (const byte* field = extra; field + 4 <= extra + extra_size;) {
+                const u16 id = le16(field);
+                const u16 field_size = le16(field + 2);
+                const byte* value = field + 4;
+                const byte* value_end = value + field_size;
+                if (value_end > extra + extra_size) {
+                    break;
+                }
+                if (id == 0x0001) {
+                    for (u64* target : {&member.size, &member.packed_size, &member.offset}) {
+                        if (*target == 0xFFFFFFFF && value + 8 <= value_end) {
+                            *target = le64(value);
+                            value += 8;
+                        }
+                    }
+                }
+                field = value_end;
+            }
+
+            std::string_view text(reinterpret_cast<const char*>(name), name_size);
+            member.kind = !text.empty() && (text.back() == '/' || text.back() == '\\') ? Kind::dir : Kind::file;
+            str key = member_key(file, text);
+            if (!key.empty()) {
+                members.insert_or_assign(std::move(key), member);
+            }
+            at = next;
+        }
+    }
+
+    void list_tar(const ArchiveFileDatabase::Path& file, const byte* base, usize size, Listing& members) {
+        str long_name;
+        umap<str, str> pax;
+        for (usize at = 0; at + TAR_BLOCK <= size;) {
+            const byte* header = base + at;
+            if (std::all_of(header, header + TAR_BLOCK, [](byte b) { return b == 0; })) {
+                break;
+            }
+            if (!tar_checksum_ok(header)) {
+                malformed(file, "tar header checksum mismatch at offset " + std::to_string(at));
+            }
+
+            const u64 data = at + TAR_BLOCK;
+            const u64 length = tar_number(header + 124, 12);
+            if (data > size || length > size - data) {
+                malformed(file, "tar member at offset " + std::to_string(at) + " is truncated");
+            }
+            at = data + (length + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+
+            const char type = static_cast<char>(header[156]);
+            if (type == 'L') {
+                long_name = tar_string(base + data, length);
+                continue;
+            }
+            if (type == 'x') {
+                // Records are "<length> <key>=<value>\n".
+                const std::string_view records(reinterpret_cast<const char*>(base + data), length);
+                for (usize pos = 0; pos < records.size();) {
+                    const usize space = records.find(' ', pos);
+                    if (space == std::string_view::npos) {
+                        break;
+                    }
+                    // The length counts itself, the space and the trailing newline.
+                    const u64 record_size = pax_number(file, records.substr(pos, space - pos), "record length");
+                    if (record_size < space - pos + 2 || record_size > records.size() - pos) {
+                        malformed(file, "pax record at offset " + std::to_string(data + pos) + " is truncated");
+                    }
+                    const std::string_view record = records.substr(space + 1, pos + record_size - space - 2);
+                    const usize equals = record.find('=');
+                    if (equals != std::string_view::npos) {
+                        pax[str(record.substr(0, equals))] = str(record.substr(equals + 1));
+                    }
+                    pos += record_size;
+                }
+                continue;
+            }
+            if (type != '0' && type != '\0' && type != '7' && type != '5') {
+                // Links, devices, global headers and the like carry no payload we serve.
+                long_name.clear();
+                pax.clear();
+                continue;
+            }
+
+            str name;
+            if (auto path = pax.find("path"); path != pax.end()) {
+                name = path->second;
+            } else if (!long_name.empty()) {
+                name = long_name;
+            } else {
+                name = tar_string(header, 100);
+                const str prefix = std::memcmp(header + 257, "ustar", 5) == 0 ? tar_string(header + 345, 155) : str();
+                if (!prefix.empty()) {
+                    name = prefix + '/' + name;
+                }
+            }
+
+            Member member;
+            member.kind = type == '5' ? Kind::dir : Kind::file;
+            member.offset = data;
+            member.packed_size = length;
+            member.size = length;
+            member.mtime = static_cast<i64>(tar_number(header + 136, 12)) * 1'000'000'000;
+            if (auto pax_size = pax.find("size"); pax_size != pax.end()) {
+                member.size = member.packed_size = pax_number(file, pax_size->second, "size");
+            }
+            long_name.clear();
+            pax.clear();
+
+            str key = member_key(file, name);
+            if (!key.empty()) {
+                // Later copies of a path replace earlier ones, as tar extraction does.
+                members.insert_or_assign(std::move(key), member);
+            }
+        }
+    }
+
+    /**
+     * Resource viewing a stored member inside the mapping. Instances are owned
+     * by the database and reused for every resolve of the same member, so
+     * reaching a zero reference count does not free anything.
+     */
+    class StoredResource final : public Resource {
+    public:
+        StoredResource(Database& owner, std::span<const byte> data)
+            : Resource(owner), m_data(data) {}
+
+        const void* data() const override {
+            return m_data.data();
+        }
+
+        u64 size() const override {
+            return static_cast<u64>(m_data.size());
+        }
+
+    protected:
+        void destroy_self() override {}
+
+    private:
+        std::span<const byte> m_data;
+    };
+
+    /// Inflated member; shared through the database's LiveResourceCache while it has handles.
+    class InflatedResource final : public CachedResource {
+    public:
+        InflatedResource(Database& owner, sptr<LiveResourceCache> cache, u32 slot, vec<byte> data)
+            : CachedResource(owner, std::move(cache), slot), m_data(std::move(data)) {}
+
+        const void* data() const override {
+            return m_data.data();
+        }
+
+        u64 size() const override {
+            return static_cast<u64>(m_data.size());
+        }
+
+    private:
+        vec<byte> m_data;
+    };
+
+} // namespace
+
+void ArchiveFileDatabase::set_file(const Path& file) {
+    if (m_file == file) {
+        return;
+    }
+
+    if (m_loaded) {
+        unload();
+    }
+    m_file = file;
+}
+
+const ArchiveFileDatabase::Path& ArchiveFileDatabase::file() const {
+    return m_file;
+}
+
+ArchiveFileDatabase::Format ArchiveFileDatabase::format() const {
+    ensure_loaded();
+    return m_format;
+}
+
+bool ArchiveFileDatabase::is_loaded() const noexcept {
+    return m_loaded;
+}
+
+ArchiveFileDatabase& ArchiveFileDatabase::load() {
+    if (m_loaded) {
+        return *this;
+    }
+
+    if (m_file.empty()) {
+        throw RuntimeError("ArchiveFileDatabase archive path is empty.");
+    }
+    if (!m_file.exists() || !m_file.is_file()) {
+        throw RuntimeError("ArchiveFileDatabase archive does not exist: " + m_file.string());
+    }
+
+    MappedFile mapping;
+    mapping.open(m_file);
+    const byte* base = mapping.data();
+    const usize size = mapping.size();
+
+    Listing listing;
+    Format format = Format::unknown;
+    if (size >= 4 && (le32(base) == ZIP_LOCAL_HEADER || le32(base) == ZIP_END)) {
+        format = Format::zip;
+        list_zip(m_file, base, size, listing);
+    } else if (size >= TAR_BLOCK && tar_checksum_ok(base)) {
+        format = Format::tar;
+        list_tar(m_file, base, size, listing);
+    } else {
+        throw RuntimeError("ArchiveFileDatabase cannot read '" + m_file.string() + "': not a zip or tar archive.");
+    }
+
+    // Archives often omit directory members; every ancestor becomes one.
+    vec<str> keys;
+    keys.reserve(listing.size());
+    for (const auto& [key, _] : listing) {
+        keys.emplace_back(key);
+    }
+    for (usize i = 0, count = keys.size(); i < count; ++i) {
+        for (auto cut = keys[i].rfind('/'); cut != str::npos; cut = keys[i].rfind('/', cut - 1)) {
+            Member dir;
+            dir.kind = Kind::dir;
+            if (!listing.try_emplace(keys[i].substr(0, cut), dir).second || cut == 0) {
+                break;
+            }
+        }
+    }
+
+    keys.clear();
+    for (const auto& [key, member] : listing) {
+        keys.emplace_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    vec<std::string_view> views;
+    vec<Entry> entries;
+    vec<Member> members;
+    views.reserve(keys.size());
+    entries.reserve(keys.size());
+    members.reserve(keys.size());
+    for (const auto& key : keys) {
+        const Member& member = listing.at(key);
+        Entry entry;
+        entry.path = PurePath(key);
+        entry.db = this;
+        entry.kind = member.kind;
+        entry.size = member.kind == Kind::file ? member.size : 0;
+        entry.mtime = member.mtime;
+        entries.emplace_back(std::move(entry));
+        members.emplace_back(member);
+        views.emplace_back(key);
+    }
+
+    PathIndex index;
+    index.build(views);
+
+    m_mapping = std::move(mapping);
+    m_format = format;
+    m_entries = std::move(entries);
+    m_members = std::move(members);
+    m_index = std::move(index);
+    m_stored.clear();
+    m_stored.resize(m_members.size());
+    m_inflated = make_sptr<LiveResourceCache>(m_members.size());
+    m_loaded = true;
+    return *this;
+}
+
+ArchiveFileDatabase& ArchiveFileDatabase::unload() {
+    std::lock_guard lock(m_mutex);
+    const bool stored_live = std::any_of(m_stored.begin(), m_stored.end(), [](const uptr<Resource>& resource) {
+        return resource && resource->refcount() > 0;
+    });
+    bool inflated_live = false;
+    if (m_inflated) {
+        std::lock_guard inflated_lock(m_inflated->mutex);
+        inflated_live = m_inflated->referenced();
+    }
+    if (stored_live || inflated_live) {
+        throw RuntimeError("Cannot unload ArchiveFileDatabase while resources are still referenced: " + m_file.string());
+    }
+
+    m_stored.clear();
+    m_inflated.reset();
+    m_entries.clear();
+    m_members.clear();
+    m_index.clear();
+    m_mapping.close();
+    m_format = Format::unknown;
+    m_loaded = false;
+    return *this;
+}
+
+void ArchiveFileDatabase::ensure_loaded() const {
+    if (!m_loaded) {
+        const_cast<ArchiveFileDatabase*>(this)->load();
+    }
+}
+
+vec<Database::Entry> ArchiveFileDatabase::list() {
+    ensure_loaded();
+    return m_entries;
+}
+
+vec<Database::Entry> ArchiveFileDatabase::list(const PurePath& rel) {
+    vec<Entry> subset;
+    each(rel, [&](const Entry& entry) {
+        subset.emplace_back(entry);
+    });
+    return subset;
+}
+
+void ArchiveFileDatabase::each(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    if (!key.empty()) {
+        const u32 slot = m_index.find(key);
+        if (slot == PathIndex::npos) {
+            return;
+        }
+        visitor(m_entries[slot]);
+    }
+
+    const auto range = m_index.descendants(key);
+    for (u32 slot = range.first; slot < range.last; ++slot) {
+        visitor(m_entries[slot]);
+    }
+}
+
+void ArchiveFileDatabase::children(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    u32 parent = PathIndex::npos;
+    if (!key.empty()) {
+        parent = m_index.find(key);
+        if (parent == PathIndex::npos) {
+            return;
+        }
+    }
+
+    for (u32 slot : m_index.children(parent)) {
+        visitor(m_entries[slot]);
+    }
+}
+
+ResourceHandle ArchiveFileDatabase::resolve(const PurePath& rel) {
+    ensure_loaded();
+    return read_slot(file_slot(rel));
+}
+
+vec<ResourceHandle> ArchiveFileDatabase::resolve(const vec<PurePath>& rels) {
+    ensure_loaded();
+
+    vec<u32> slots;
+    slots.reserve(rels.size());
+    for (const auto& rel : rels) {
+        slots.emplace_back(file_slot(rel));
+    }
+
+    // parallel() hands out indices in ascending order, so members are read
+    // front to back through the mapping while inflating concurrently.
+    vec<usize> order(slots.size());
+    std::iota(order.begin(), order.end(), usize{0});
+    std::stable_sort(order.begin(), order.end(), [this, &slots](usize lhs, usize rhs) {
+        return m_members[slots[lhs]].offset < m_members[slots[rhs]].offset;
+    });
+
+    vec<ResourceHandle> handles(slots.size());
+    WorkerPool::shared().parallel(order.size(), [&](usize i) {
+        const usize at = order[i];
+        handles[at] = read_slot(slots[at]);
+    });
+    return handles;
+}
+
+bool ArchiveFileDatabase::exists(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    return find_slot(relative) != PathIndex::npos;
+}
+
+bool ArchiveFileDatabase::is_file(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return false;
+    }
+    const u32 slot = find_slot(relative);
+    return slot != PathIndex::npos && m_entries[slot].kind == Kind::file;
+}
+
+bool ArchiveFileDatabase::is_dir(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    const u32 slot = find_slot(relative);
+    return slot != PathIndex::npos && m_entries[slot].kind == Kind::dir;
+}
+
+u32 ArchiveFileDatabase::find_slot(const PurePath& rel) const {
+    return m_index.find(rel.as_posix());
+}
+
+u32 ArchiveFileDatabase::file_slot(const PurePath& rel) const {
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        throw RuntimeError("Cannot resolve the database root as a resource.");
+    }
+
+    const u32 slot = find_slot(relative);
+    if (slot == PathIndex::npos) {
+        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    }
+    if (m_entries[slot].kind != Kind::file) {
+        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
+    }
+    return slot;
+}
+
+std::span<const byte> ArchiveFileDatabase::packed(const Member& member) const {
+    const byte* base = m_mapping.data();
+    const u64 size = m_mapping.size();
+
+    u64 data = member.offset;
+    if (m_format == Format::zip) {
+        // The local header repeats name and extra field, with its own lengths.
+        if (size < 30 || member.offset > size - 30 || le32(base + member.offset) != ZIP_LOCAL_HEADER) {
+            malformed(m_file, "local header at offset " + std::to_string(member.offset) + " is invalid");
+        }
+        data = member.offset + 30 + le16(base + member.offset + 26) + le16(base + member.offset + 28);
+    }
+    if (data > size || member.packed_size > size - data) {
+        malformed(m_file, "member data at offset " + std::to_string(data) + " lies outside of the file");
+    }
+    return {base + data, static_cast<usize>(member.packed_size)};
+}
+
+ResourceHandle ArchiveFileDatabase::read_slot(u32 slot) {
+    const Member& member = m_members[slot];
+    const str& path = m_entries[slot].path.as_posix();
+    if (member.flags & ZIP_ENCRYPTED) {
+        throw RuntimeError("Archive member is encrypted: " + path);
+    }
+
+    if (member.method == ZIP_STORED) {
+        const auto data = packed(member);
+        if (data.size() != member.size) {
+            malformed(m_file, "stored member '" + path + "' has mismatching sizes");
+        }
+        std::lock_guard lock(m_mutex);
+        auto& payload = m_stored[slot];
+        if (!payload) {
+            payload = make_uptr<StoredResource>(*this, data);
+        }
+        return ResourceHandle(payload.get());
+    }
+    if (member.method != ZIP_DEFLATED) {
+        throw RuntimeError("Unsupported compression method " + std::to_string(member.method) + " for archive member: " + path);
+    }
+
+    {
+        std::lock_guard lock(m_inflated->mutex);
+        if (ResourceHandle live = m_inflated->find(slot); live.valid()) {
+            return live;
+        }
+    }
+
+    vec<byte> data;
+    try {
+        data = inflate(packed(member), static_cast<usize>(member.size));
+    } catch (const RuntimeError& ex) {
+        throw RuntimeError("Failed to inflate archive member '" + path + "': " + ex.what());
+    }
+    auto* resource = new InflatedResource(*this, m_inflated, slot, std::move(data));
+
+    std::lock_guard lock(m_inflated->mutex);
+    return m_inflated->publish(resource);
+}
@@ -0,0 +1,71 @@
+#include "mloader/database/base.hxx"
+
+#include "mtl/error.hxx"
+
+#include "mloader/residency.hxx"
+
+using namespace mloader;
+
+void Database::set_residency(ResidencyManager& manager) noexcept {
+    m_residency = &manager;
+}
+
+ResidencyManager& Database::residency() const noexcept {
+    return m_residency ? *m_residency : ResidencyManager::shared();
+}
+
+void Database::each(const PurePath& rel, const Visitor& visitor) {
+    auto relative = normalise(rel);
+    const auto entries = relative.string().empty() ? list() : list(relative);
+    for (const auto& entry : entries) {
+        visitor(entry);
+    }
+}
+
+void Database::children(const PurePath& rel, const Visitor& visitor) {
+    auto relative = normalise(rel);
+    const str parent = relative.as_posix();
+    const auto entries = parent.empty() ? list() : list(relative);
+    for (const auto& entry : entries) {
+        const str name = entry.path.as_posix();
+        const auto split = name.rfind('/');
+        const str owner = split == str::npos ? str() : name.substr(0, split);
+        if (owner == parent && name != parent) {
+            visitor(entry);
+        }
+    }
+}
+
+vec<ResourceHandle> Database::resolve(const vec<PurePath>& rels) {
+    vec<ResourceHandle> handles;
+    handles.reserve(rels.size());
+    for (const auto& rel : rels) {
+        handles.emplace_back(resolve(rel));
+    }
+    return handles;
+}
+
+Database::PurePath Database::normalise(const PurePath& rel) const {
+    if (rel.is_absolute()) {
+        throw RuntimeError("Database paths must be relative: " + rel.as_posix());
+    }
+
+    str posix = rel.as_posix();
+    while (!posix.empty() && posix.front() == '/') {
+        posix.erase(posix.begin());
+    }
+    while (!posix.empty() && posix.rfind("./", 0) == 0) {
+        posix.erase(0, 2);
+    }
+    while (!posix.empty() && posix.back() == '/') {
+        posix.pop_back();
+    }
+    if (posix == ".") {
+        posix.clear();
+    }
+    if (posix.empty()) {
+        return PurePath();
+    }
+    const str canonical = PurePath(posix).as_posix();
+    return canonical.empty() ? PurePath() : PurePath(canonical);
+}
@@ -1,2 +1,454 @@
-// WIP
+#include "mloader/database/binary.hxx"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "mtl/error.hxx"
+
+#include "mloader/extension/archive/checksum.hxx"
+#include "mloader/hash.hxx"
+#include "mloader/lz.hxx"
+#include "mloader/worker.hxx"
+
+using namespace mloader;
+using extension::ArchiveKind;
+
+namespace {
+
+    /// Spare decode buffers kept per database; larger ones are freed on release.
+    constexpr u64 BUFFER_POOL_BYTES = 32ull << 20;
+
+    /**
+     * Resource viewing a payload inside the mapping. Instances are owned by
+     * the database and reused for every resolve of the same record, so
+     * reaching a zero reference count does not free anything.
+     */
+    class BinaryResource final : public Resource {
+    public:
+        BinaryResource(Database& owner, const byte* data, u64 size)
+            : Resource(owner), m_data(data), m_size(size) {}
+
+        const void* data() const override {
+            return m_data;
+        }
+
+        u64 size() const override {
+            return m_size;
+        }
+
+    protected:
+        void destroy_self() override {}
+
+    private:
+        const byte* m_data;
+        u64 m_size;
+    };
+
+    void check_archive(const extension::ArchiveDecoder& header, const byte* data, usize size, const BinaryDatabase::Path& file) {
+        if ((header.flags & extension::ARCHIVE_FLAG_CHECKSUMS) == 0) {
+            throw RuntimeError("Archive carries no checksums to verify: " + file.string());
+        }
+
+        const auto sums = extension::compute_checksums(data, size);
+        if (sums.crc32 != header.crc32 || std::memcmp(sums.sha256.data(), header.sha256, sums.sha256.size()) != 0) {
+            throw RuntimeError("Archive checksum mismatch, the file is corrupt: " + file.string());
+        }
+    }
+
+} // namespace
+
+struct BinaryDatabase::DecodedResource final : CachedResource {
+    DecodedResource(BinaryDatabase& owner, u32 slot, Buffer buffer, u64 size)
+        : CachedResource(owner, owner.m_decoded, slot), m_pool(*owner.m_decoded), m_buffer(std::move(buffer)), m_size(size) {}
+
+    const void* data() const override {
+        return m_buffer.data.get();
+    }
+
+    u64 size() const override {
+        return m_size;
+    }
+
+protected:
+    void release() override {
+        m_pool.release(std::move(m_buffer));
+    }
+
+private:
+    /// Kept alive by the cache reference CachedResource holds.
+    DecodeCache& m_pool;
+    Buffer m_buffer;
+    u64 m_size;
+};
+
+void BinaryDatabase::set_file(const Path& file) {
+    if (m_file == file) {
+        return;
+    }
+
+    if (m_loaded) {
+        unload();
+    }
+    m_file = file;
+}
+
+const BinaryDatabase::Path& BinaryDatabase::file() const {
+    return m_file;
+}
+
+const extension::Extension& BinaryDatabase::extension() const {
+    ensure_loaded();
+    return m_header.extension;
+}
+
+void BinaryDatabase::set_verification(Verification verification) noexcept {
+    m_verification = verification;
+}
+
+BinaryDatabase::Verification BinaryDatabase::verification() const noexcept {
+    return m_verification;
+}
+
+void BinaryDatabase::verify() {
+    ensure_loaded();
+    check_archive(m_header, m_mapping.data(), m_mapping.size(), m_file);
+    for (auto& verified : m_verified) {
+        verified.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool BinaryDatabase::is_loaded() const noexcept {
+    return m_loaded;
+}
+
+BinaryDatabase& BinaryDatabase::load() {
+    if (m_loaded) {
+        return *this;
+    }
+
+    if (m_file.empty()) {
+        throw RuntimeError("BinaryDatabase archive path is empty.");
+    }
+    if (!m_file.exists() || !m_file.is_file()) {
+        throw RuntimeError("BinaryDatabase archive does not exist: " + m_file.string());
+    }
+
+    MappedFile mapping;
+    mapping.open(m_file);
+    const byte* base = mapping.data();
+    const usize size = mapping.size();
+
+    extension::ArchiveDecoder header;
+    header.decode_header(base, size);
+
+    extension::ArchiveTrailer trailer;
+    trailer.decode(base, size);
+
+    const bool eager = m_verification == Verification::eager;
+    if (eager) {
+        check_archive(header, base, size, m_file);
+    }
+
+    extension::ArchiveIndexDecoder index;
+    index.decode(base + trailer.index_offset, static_cast<usize>(trailer.index_size));
+
+    vec<std::string_view> keys;
+    keys.reserve(index.records.size());
+    for (const auto& record : index.records) {
+        if (record.kind == ArchiveKind::file &&
+            (record.offset > trailer.index_offset || record.packed_size > trailer.index_offset - record.offset)) {
+            throw RuntimeError("Archive payload lies outside of the data section: " + str(index.path(record)));
+        }
+        if ((record.flags & ~extension::ARCHIVE_RECORD_LZ) != 0 || (!record.compressed() && record.packed_size != record.size)) {
+            throw RuntimeError("Archive record has unsupported flags or sizes: " + str(index.path(record)));
+        }
+        keys.emplace_back(index.path(record));
+    }
+
+    // Slots line up with record positions because the archive index is sorted;
+    // build() rejects archives where it is not.
+    PathIndex paths;
+    paths.build(keys);
+
+    m_mapping = std::move(mapping);
+    m_header = std::move(header);
+    m_index = std::move(index);
+    m_paths = std::move(paths);
+    m_payloads.clear();
+    m_payloads.resize(m_index.records.size());
+    m_decoded = make_sptr<DecodeCache>(m_index.records.size());
+    m_verified = vec<std::atomic<bool>>(m_index.records.size());
+    if (eager) {
+        for (auto& verified : m_verified) {
+            verified.store(true, std::memory_order_relaxed);
+        }
+    }
+    m_loaded = true;
+    return *this;
+}
+
+BinaryDatabase& BinaryDatabase::unload() {
+    std::lock_guard lock(m_mutex);
+    const bool payloads_live = std::any_of(m_payloads.begin(), m_payloads.end(), [](const uptr<Resource>& payload) {
+        return payload && payload->refcount() > 0;
+    });
+    bool decoded_live = false;
+    if (m_decoded) {
+        std::lock_guard decoded_lock(m_decoded->mutex);
+        decoded_live = m_decoded->referenced();
+    }
+    if (payloads_live || decoded_live) {
+        throw RuntimeError("Cannot unload BinaryDatabase while resources are still referenced: " + m_file.string());
+    }
+
+    m_payloads.clear();
+    m_decoded.reset();
+    m_verified.clear();
+    m_paths.clear();
+    m_index = {};
+    m_header = {};
+    m_mapping.close();
+    m_loaded = false;
+    return *this;
+}
+
+void BinaryDatabase::ensure_loaded() const {
+    if (!m_loaded) {
+        const_cast<BinaryDatabase*>(this)->load();
+    }
+}
+
+std::string_view BinaryDatabase::path(const Record& record) const {
+    return m_index.path(record);
+}
+
+const BinaryDatabase::Record* BinaryDatabase::find_record(const PurePath& rel) const {
+    const u32 slot = m_paths.find(rel.as_posix());
+    return slot == PathIndex::npos ? nullptr : &m_index.records[slot];
+}
+
+u32 BinaryDatabase::file_slot(const PurePath& rel) const {
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        throw RuntimeError("Cannot resolve the database root as a resource.");
+    }
+
+    const Record* record = find_record(relative);
+    if (!record) {
+        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    }
+    if (record->kind != ArchiveKind::file) {
+        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
+    }
+    return static_cast<u32>(record - m_index.records.data());
+}
+
+ResourceHandle BinaryDatabase::read_slot(u32 slot) {
+    const Record& record = m_index.records[slot];
+    if (!record.compressed()) {
+        check_entry(slot, m_mapping.data() + record.offset);
+        std::lock_guard lock(m_mutex);
+        auto& payload = m_payloads[slot];
+        if (!payload) {
+            payload = make_uptr<BinaryResource>(*this, m_mapping.data() + record.offset, record.size);
+        }
+        return ResourceHandle(payload.get());
+    }
+
+    Buffer buffer;
+    {
+        std::lock_guard lock(m_decoded->mutex);
+        if (ResourceHandle live = m_decoded->find(slot); live.valid()) {
+            return live;
+        }
+        buffer = m_decoded->acquire(record.size);
+    }
+
+    try {
+        decompress_lz({m_mapping.data() + record.offset, static_cast<usize>(record.packed_size)},
+                      {buffer.data.get(), static_cast<usize>(record.size)});
+    } catch (const RuntimeError& ex) {
+        std::lock_guard lock(m_decoded->mutex);
+        m_decoded->release(std::move(buffer));
+        throw RuntimeError("Failed to decompress archive entry '" + str(path(record)) + "': " + ex.what());
+    }
+    try {
+        check_entry(slot, buffer.data.get());
+    } catch (const RuntimeError&) {
+        std::lock_guard lock(m_decoded->mutex);
+        m_decoded->release(std::move(buffer));
+        throw;
+    }
+    auto* resource = new DecodedResource(*this, slot, std::move(buffer), record.size);
+
+    std::lock_guard lock(m_decoded->mutex);
+    return m_decoded->publish(resource);
+}
+
+void BinaryDatabase::check_entry(u32 slot, const byte* data) {
+    if (m_verification != Verification::lazy || m_verified[slot].load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const Record& record = m_index.records[slot];
+    if (hash64(data, static_cast<usize>(record.size)) != record.hash) {
+        throw RuntimeError("Archive entry failed verification, the file is corrupt: " + str(path(record)));
+    }
+    m_verified[slot].store(true, std::memory_order_release);
+}
+
+BinaryDatabase::Buffer BinaryDatabase::DecodeCache::acquire(u64 size) {
+    auto best = buffers.end();
+    for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+        if (it->capacity >= size && (best == buffers.end() || it->capacity < best->capacity)) {
+            best = it;
+        }
+    }
+    if (best == buffers.end()) {
+        // Uninitialised storage: every byte is written by the decoder.
+        Buffer buffer;
+        buffer.data = uptr<byte[]>(new byte[std::max<u64>(size, 1)]);
+        buffer.capacity = size;
+        return buffer;
+    }
+
+    Buffer buffer = std::move(*best);
+    *best = std::move(buffers.back());
+    buffers.pop_back();
+    buffer_bytes -= buffer.capacity;
+    return buffer;
+}
+
+void BinaryDatabase::DecodeCache::release(Buffer buffer) {
+    if (!buffer.data || buffer_bytes + buffer.capacity > BUFFER_POOL_BYTES) {
+        return;
+    }
+    buffer_bytes += buffer.capacity;
+    buffers.emplace_back(std::move(buffer));
+}
+
+Database::Entry BinaryDatabase::make_entry(const Record& record) {
+    Entry entry;
+    entry.path = PurePath(str(path(record)));
+    entry.db = this;
+    entry.kind = record.kind == ArchiveKind::dir ? Entry::Kind::dir : Entry::Kind::file;
+    entry.size = record.kind == ArchiveKind::dir ? 0 : record.size;
+    return entry;
+}
+
+vec<Database::Entry> BinaryDatabase::list() {
+    ensure_loaded();
+
+    vec<Entry> entries;
+    entries.reserve(m_index.records.size());
+    for (const auto& record : m_index.records) {
+        entries.emplace_back(make_entry(record));
+    }
+    return entries;
+}
+
+vec<Database::Entry> BinaryDatabase::list(const PurePath& rel) {
+    vec<Entry> subset;
+    each(rel, [&](const Entry& entry) {
+        subset.emplace_back(entry);
+    });
+    return subset;
+}
+
+void BinaryDatabase::each(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    auto relative = normalise(rel);
+    const str key = relative.as_posix();
+    if (!key.empty()) {
+        const Record* self = find_record(relative);
+        if (!self) {
+            return;
+        }
+        visitor(make_entry(*self));
+    }
+
+    const auto range = m_paths.descendants(key);
+    for (u32 slot = range.first; slot < range.last; ++slot) {
+        visitor(make_entry(m_index.records[slot]));
+    }
+}
+
+void BinaryDatabase::children(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    auto relative = normalise(rel);
+    const str key = relative.as_posix();
+    u32 parent = PathIndex::npos;
+    if (!key.empty()) {
+        parent = m_paths.find(key);
+        if (parent == PathIndex::npos) {
+            return;
+        }
+    }
+
+    for (u32 slot : m_paths.children(parent)) {
+        visitor(make_entry(m_index.records[slot]));
+    }
+}
+
+ResourceHandle BinaryDatabase::resolve(const PurePath& rel) {
+    ensure_loaded();
+    return read_slot(file_slot(rel));
+}
+
+vec<ResourceHandle> BinaryDatabase::resolve(const vec<PurePath>& rels) {
+    ensure_loaded();
+
+    vec<u32> slots;
+    slots.reserve(rels.size());
+    bool any_compressed = false;
+    for (const auto& rel : rels) {
+        const u32 slot = slots.emplace_back(file_slot(rel));
+        any_compressed = any_compressed || m_index.records[slot].compressed();
+    }
+
+    vec<ResourceHandle> handles(slots.size());
+    if (!any_compressed) {
+        // Plain payloads are views; handing them to the pool would only add overhead.
+        for (usize i = 0; i < slots.size(); ++i) {
+            handles[i] = read_slot(slots[i]);
+        }
+        return handles;
+    }
+
+    WorkerPool::shared().parallel(slots.size(), [&](usize i) {
+        handles[i] = read_slot(slots[i]);
+    });
+    return handles;
+}
+
+bool BinaryDatabase::exists(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    return find_record(relative) != nullptr;
+}
+
+bool BinaryDatabase::is_file(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return false;
+    }
+    const Record* record = find_record(relative);
+    return record && record->kind == ArchiveKind::file;
+}
+
+bool BinaryDatabase::is_dir(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    const Record* record = find_record(relative);
+    return record && record->kind == ArchiveKind::dir;
+}
@@ -0,0 +1,65 @@
+#include "mloader/database/cache.hxx"
+
+#include <algorithm>
+
+using namespace mloader;
+
+void CachedResource::destroy_self() {
+    {
+        // A resolve racing with this may still see the pointer, but try_ref()
+        // fails at zero so it reads a fresh copy and replaces the slot instead.
+        std::lock_guard lock(m_cache->mutex);
+        if (m_slot < m_cache->m_live.size() && m_cache->m_live[m_slot] == this) {
+            m_cache->m_live[m_slot] = nullptr;
+        }
+        release();
+    }
+    delete this;
+}
+
+ResourceHandle LiveResourceCache::find(u32 slot) {
+    CachedResource* live = m_live[slot];
+    if (live && live->try_ref()) {
+        return ResourceHandle::adopt(live);
+    }
+    return ResourceHandle();
+}
+
+ResourceHandle LiveResourceCache::publish(CachedResource* resource) {
+    CachedResource*& live = m_live[resource->m_slot];
+    if (live && live->try_ref()) {
+        // Another thread produced the same entry meanwhile; keep its copy.
+        resource->release();
+        delete resource;
+        return ResourceHandle::adopt(live);
+    }
+    live = resource;
+    return ResourceHandle(resource);
+}
+
+void LiveResourceCache::invalidate(u32 slot) {
+    if (CachedResource* resource = m_live[slot]) {
+        resource->mark_stale();
+        resource->m_slot = npos;
+        m_live[slot] = nullptr;
+    }
+}
+
+void LiveResourceCache::remap(const vec<u32>& to, usize count) {
+    vec<CachedResource*> live(count, nullptr);
+    for (u32 slot = 0; slot < m_live.size(); ++slot) {
+        if (CachedResource* resource = m_live[slot]) {
+            resource->m_slot = to[slot];
+            if (to[slot] != npos) {
+                live[to[slot]] = resource;
+            }
+        }
+    }
+    m_live = std::move(live);
+}
+
+bool LiveResourceCache::referenced() const noexcept {
+    return std::any_of(m_live.begin(), m_live.end(), [](const CachedResource* resource) {
+        return resource != nullptr;
+    });
+}
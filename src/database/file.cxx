@@ -1,11 +1,28 @@
 #include "mloader/database/file.hxx"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
 #include <unordered_set>
 #include <utility>
 
 #include "mtl/error.hxx"
 
+#include "mloader/worker.hxx"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 using namespace mloader;
 
 namespace {
@@ -31,10 +48,83 @@ namespace {
         return combined;
     }
 
-    class FilesystemResource final : public Resource {
+    /**
+     * Fills size and mtime from a single stat; failures leave the fields
+     * zeroed. @return Inode number, or zero where the platform has none.
+     */
+    u64 read_metadata(const Path& absolute, Database::Entry& entry) {
+#ifdef _WIN32
+        std::error_code ec;
+        const std::filesystem::directory_entry info(std::filesystem::path(absolute.string()), ec);
+        if (ec) {
+            return 0;
+        }
+        if (entry.kind == Database::Entry::Kind::file) {
+            const auto size = info.file_size(ec);
+            entry.size = ec ? 0 : static_cast<u64>(size);
+        }
+        const auto mtime = info.last_write_time(ec);
+        if (!ec) {
+            entry.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+        }
+        return 0;
+#else
+        struct stat info {};
+        if (::stat(absolute.string().c_str(), &info) != 0) {
+            return 0;
+        }
+        if (entry.kind == Database::Entry::Kind::file) {
+            entry.size = static_cast<u64>(info.st_size);
+        }
+#ifdef __APPLE__
+        const auto& mtime = info.st_mtimespec;
+#else
+        const auto& mtime = info.st_mtim;
+#endif
+        entry.mtime = static_cast<i64>(mtime.tv_sec) * 1'000'000'000 + static_cast<i64>(mtime.tv_nsec);
+        return static_cast<u64>(info.st_ino);
+#endif
+    }
+
+    using Collected = umap<str, std::pair<Database::Entry, u64>>;
+
+    /**
+     * Walks the directory `key` under `resolved_root` into `collected`, keyed
+     * by relative path. walk() already reports which names are directories
+     * and which are files, and children are keyed by joining names onto their
+     * parent's key, so the only per-entry syscall is the metadata stat.
+     */
+    void scan_tree(Database* db, const Path& resolved_root, const str& key, Collected& collected) {
+        auto add_entry = [&](str entry_key, const Path& absolute, Database::Entry::Kind kind) {
+            if (entry_key.empty() || collected.contains(entry_key)) {
+                return;
+            }
+            Database::Entry entry;
+            entry.path = PurePath(entry_key);
+            entry.db = db;
+            entry.kind = kind;
+            const u64 inode = read_metadata(absolute, entry);
+            collected.emplace(std::move(entry_key), std::pair{std::move(entry), inode});
+        };
+
+        for (const auto& walk_entry : join_under(resolved_root, PurePath(key)).walk()) {
+            const str parent = walk_entry.path.relative_to(resolved_root).as_posix();
+            const str prefix = parent.empty() ? str() : parent + '/';
+            add_entry(parent, walk_entry.path, Database::Entry::Kind::dir);
+
+            for (const auto& dir_name : walk_entry.dirs) {
+                add_entry(prefix + dir_name, walk_entry.path / dir_name, Database::Entry::Kind::dir);
+            }
+            for (const auto& file_name : walk_entry.files) {
+                add_entry(prefix + file_name, walk_entry.path / file_name, Database::Entry::Kind::file);
+            }
+        }
+    }
+
+    class FilesystemResource final : public CachedResource {
     public:
-        FilesystemResource(Database& owner, Path absolute, vec<byte> data)
-            : Resource(owner), m_absolute(std::move(absolute)), m_data(std::move(data)) {}
+        FilesystemResource(Database& owner, sptr<LiveResourceCache> cache, u32 slot, vec<byte> data)
+            : CachedResource(owner, std::move(cache), slot), m_data(std::move(data)) {}
 
         const void* data() const override {
             return m_data.empty() ? nullptr : m_data.data();
@@ -45,12 +135,38 @@ namespace {
         }
 
     private:
-        Path m_absolute;
         vec<byte> m_data;
     };
 
 } // namespace
 
+struct FilesystemDatabase::Watcher {
+    int fd = -1;
+    /// Watch descriptor -> directory key; the root is the empty key.
+    umap<int, str> dirs;
+
+    Watcher() = default;
+    Watcher(const Watcher&) = delete;
+    Watcher& operator=(const Watcher&) = delete;
+
+    ~Watcher() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+};
+
+namespace {
+
+#ifdef __linux__
+    constexpr u32 WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                               IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+} // namespace
+
 void FilesystemDatabase::set_root(const Path& root) {
     if (m_root == root) {
         return;
@@ -88,13 +204,20 @@ FilesystemDatabase& FilesystemDatabase::load() {
     }
 
     collect_entries(resolved_root);
+    m_cache = make_sptr<LiveResourceCache>(m_entries.size());
     m_resolved_root = std::move(resolved_root);
     m_loaded = true;
     return *this;
 }
 
 FilesystemDatabase& FilesystemDatabase::unload() {
+    m_watcher.reset();
     m_entries.clear();
+    m_inodes.clear();
+    m_index.clear();
+    // Resources still referenced keep the old table alive and only ever
+    // clear their own slot in it.
+    m_cache.reset();
     m_resolved_root = {};
     m_loaded = false;
     return *this;
@@ -106,81 +229,86 @@ void FilesystemDatabase::ensure_loaded() const {
     }
 }
 
-FilesystemDatabase::PurePath FilesystemDatabase::normalise(const PurePath& rel) const {
-    if (rel.is_absolute()) {
-        throw RuntimeError("Database paths must be relative: " + rel.as_posix());
-    }
-
-    str posix = rel.as_posix();
-    while (!posix.empty() && posix.front() == '/') {
-        posix.erase(posix.begin());
-    }
-    while (!posix.empty() && posix.rfind("./", 0) == 0) {
-        posix.erase(0, 2);
-    }
-    while (!posix.empty() && posix.back() == '/') {
-        posix.pop_back();
-    }
-    if (posix == ".") {
-        posix.clear();
-    }
-    if (posix.empty()) {
-        return PurePath();
-    }
-    const str canonical = PurePath(posix).as_posix();
-    return canonical.empty() ? PurePath() : PurePath(canonical);
-}
-
 vec<Database::Entry> FilesystemDatabase::list() {
     ensure_loaded();
     return m_entries;
 }
 
 vec<Database::Entry> FilesystemDatabase::list(const PurePath& rel) {
+    vec<Entry> subset;
+    each(rel, [&](const Entry& entry) {
+        subset.emplace_back(entry);
+    });
+    return subset;
+}
+
+void FilesystemDatabase::each(const PurePath& rel, const Visitor& visitor) {
     ensure_loaded();
 
     auto relative = normalise(rel);
-    if (relative.string().empty()) {
-        return list();
+    const str key = relative.as_posix();
+    if (!key.empty()) {
+        const Entry* self = find_entry(relative);
+        if (!self) {
+            return;
+        }
+        visitor(*self);
     }
 
-    const str filter = relative.as_posix();
-    str prefix = filter;
-    if (!prefix.empty()) {
-        prefix += '/';
+    const auto range = m_index.descendants(key);
+    for (u32 slot = range.first; slot < range.last; ++slot) {
+        visitor(m_entries[slot]);
     }
+}
 
-    vec<Entry> subset;
-    for (const auto& entry : m_entries) {
-        const str entry_str = entry.path.as_posix();
-        if (entry_str == filter || (!prefix.empty() && entry_str.rfind(prefix, 0) == 0)) {
-            subset.emplace_back(entry);
+void FilesystemDatabase::children(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    auto relative = normalise(rel);
+    const str key = relative.as_posix();
+    u32 parent = PathIndex::npos;
+    if (!key.empty()) {
+        parent = m_index.find(key);
+        if (parent == PathIndex::npos) {
+            return;
         }
     }
-    return subset;
+
+    for (u32 slot : m_index.children(parent)) {
+        visitor(m_entries[slot]);
+    }
 }
 
 ResourceHandle FilesystemDatabase::resolve(const PurePath& rel) {
     ensure_loaded();
+    return read_slot(file_slot(rel));
+}
 
-    auto relative = normalise(rel);
-    if (relative.string().empty()) {
-        throw RuntimeError("Cannot resolve the database root as a resource.");
-    }
+vec<ResourceHandle> FilesystemDatabase::resolve(const vec<PurePath>& rels) {
+    ensure_loaded();
 
-    const Entry* entry = find_entry(relative);
-    if (!entry) {
-        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    // Every path is validated before the first read, so a bad entry fails
+    // the batch without doing any I/O.
+    vec<u32> slots;
+    slots.reserve(rels.size());
+    for (const auto& rel : rels) {
+        slots.emplace_back(file_slot(rel));
     }
 
-    if (!is_file(relative)) {
-        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
-    }
+    vec<usize> order(slots.size());
+    std::iota(order.begin(), order.end(), usize{0});
+    std::stable_sort(order.begin(), order.end(), [this, &slots](usize lhs, usize rhs) {
+        return m_inodes[slots[lhs]] < m_inodes[slots[rhs]];
+    });
 
-    Path absolute = make_absolute(relative);
-    auto data = absolute.read_bytes();
-    auto* resource = new FilesystemResource(*this, std::move(absolute), std::move(data));
-    return ResourceHandle(resource);
+    // parallel() hands out indices in ascending order, so reads start in
+    // inode order while each handle lands at its input position.
+    vec<ResourceHandle> handles(slots.size());
+    WorkerPool::shared().parallel(order.size(), [&](usize i) {
+        const usize at = order[i];
+        handles[at] = read_slot(slots[at]);
+    });
+    return handles;
 }
 
 bool FilesystemDatabase::exists(const PurePath& rel) const {
@@ -198,8 +326,8 @@ bool FilesystemDatabase::is_file(const PurePath& rel) const {
     if (relative.string().empty()) {
         return false;
     }
-    Path absolute = make_absolute(relative);
-    return absolute.exists() && absolute.is_file();
+    const Entry* entry = find_entry(relative);
+    return entry && entry->kind == Entry::Kind::file;
 }
 
 bool FilesystemDatabase::is_dir(const PurePath& rel) const {
@@ -208,8 +336,8 @@ bool FilesystemDatabase::is_dir(const PurePath& rel) const {
     if (relative.string().empty()) {
         return true;
     }
-    Path absolute = make_absolute(relative);
-    return absolute.exists() && absolute.is_dir();
+    const Entry* entry = find_entry(relative);
+    return entry && entry->kind == Entry::Kind::dir;
 }
 
 FilesystemDatabase::Path FilesystemDatabase::make_absolute(const PurePath& rel) const {
@@ -221,63 +349,386 @@ FilesystemDatabase::Path FilesystemDatabase::make_absolute(const PurePath& rel)
 }
 
 FilesystemDatabase::Entry* FilesystemDatabase::find_entry(const PurePath& rel) {
-    auto relative = normalise(rel);
-    const str target = relative.as_posix();
-    for (auto& entry : m_entries) {
-        if (entry.path.as_posix() == target) {
-            return &entry;
-        }
-    }
-    return nullptr;
+    const u32 slot = m_index.find(rel.as_posix());
+    return slot == PathIndex::npos ? nullptr : &m_entries[slot];
 }
 
 const FilesystemDatabase::Entry* FilesystemDatabase::find_entry(const PurePath& rel) const {
+    const u32 slot = m_index.find(rel.as_posix());
+    return slot == PathIndex::npos ? nullptr : &m_entries[slot];
+}
+
+u32 FilesystemDatabase::file_slot(const PurePath& rel) const {
     auto relative = normalise(rel);
-    const str target = relative.as_posix();
-    for (const auto& entry : m_entries) {
-        if (entry.path.as_posix() == target) {
-            return &entry;
+    if (relative.string().empty()) {
+        throw RuntimeError("Cannot resolve the database root as a resource.");
+    }
+
+    const u32 slot = m_index.find(relative.as_posix());
+    if (slot == PathIndex::npos) {
+        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    }
+    if (m_entries[slot].kind != Entry::Kind::file) {
+        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
+    }
+    return slot;
+}
+
+ResourceHandle FilesystemDatabase::read_slot(u32 slot) {
+    {
+        std::lock_guard lock(m_cache->mutex);
+        if (ResourceHandle live = m_cache->find(slot); live.valid()) {
+            return live;
         }
     }
-    return nullptr;
+
+    // Indexed keys were produced by walking the resolved root, so joining is
+    // enough; canonicalising again would cost a realpath per read.
+    auto data = join_under(m_resolved_root, m_entries[slot].path).read_bytes();
+    auto* resource = new FilesystemResource(*this, m_cache, slot, std::move(data));
+
+    std::lock_guard lock(m_cache->mutex);
+    return m_cache->publish(resource);
 }
 
 void FilesystemDatabase::collect_entries(const Path& resolved_root) {
     m_entries.clear();
+    m_inodes.clear();
+    m_index.clear();
 
-    std::unordered_set<str> seen;
-    auto add_entry = [&](const Path& absolute) {
-        auto relative_path = absolute.relative_to(resolved_root);
-        str rel_string = relative_path.as_posix();
-        if (rel_string.empty()) {
-            return;
+    Collected collected;
+    scan_tree(this, resolved_root, str(), collected);
+
+    // Keys are computed once here; both the sort and the lookup index reuse them.
+    vec<str> keys;
+    keys.reserve(collected.size());
+    for (const auto& [key, _] : collected) {
+        keys.emplace_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    vec<std::string_view> views;
+    views.reserve(keys.size());
+    m_entries.reserve(keys.size());
+    m_inodes.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto& [entry, inode] = collected.at(key);
+        m_entries.emplace_back(std::move(entry));
+        m_inodes.emplace_back(inode);
+        views.emplace_back(key);
+    }
+    m_index.build(views);
+}
+
+vec<FilesystemDatabase::Change> FilesystemDatabase::refresh(const vec<PurePath>& paths) {
+    ensure_loaded();
+
+    // Disk state of every requested path (whole subtrees for directories),
+    // and the indexed slots that state replaces.
+    Collected disk;
+    vec<u8> covered(m_entries.size(), 0);
+    auto cover_subtree = [&](std::string_view key) {
+        const auto range = m_index.descendants(key);
+        std::fill(covered.begin() + range.first, covered.begin() + range.last, u8{1});
+    };
+
+    for (const auto& rel : paths) {
+        const str key = normalise(rel).as_posix();
+        if (key.empty()) {
+            scan_tree(this, m_resolved_root, key, disk);
+            cover_subtree(key);
+            continue;
+        }
+
+        const u32 slot = m_index.find(key);
+        if (slot != PathIndex::npos) {
+            covered[slot] = 1;
+            if (m_entries[slot].kind == Entry::Kind::dir) {
+                cover_subtree(key);
+            }
         }
-        PurePath rel(rel_string);
-        str key = rel.as_posix();
-        if (seen.insert(key).second) {
+
+        const Path absolute = join_under(m_resolved_root, PurePath(key));
+        if (absolute.is_dir()) {
+            scan_tree(this, m_resolved_root, key, disk);
+        } else if (absolute.is_file() && !disk.contains(key)) {
             Entry entry;
-            entry.path = rel;
+            entry.path = PurePath(key);
             entry.db = this;
-            m_entries.emplace_back(std::move(entry));
+            entry.kind = Entry::Kind::file;
+            const u64 inode = read_metadata(absolute, entry);
+            disk.emplace(key, std::pair{std::move(entry), inode});
         }
-    };
+    }
 
-    for (const auto& walk_entry : resolved_root.walk()) {
-        Path current = walk_entry.path;
-        str current_rel = current.relative_to(resolved_root).as_posix();
-        if (!current_rel.empty()) {
-            add_entry(current);
+    vec<Change> changes;
+    vec<u8> removed(m_entries.size(), 0);
+    usize removed_count = 0;
+    {
+        std::lock_guard lock(m_cache->mutex);
+        for (u32 slot = 0; slot < covered.size(); ++slot) {
+            if (!covered[slot]) {
+                continue;
+            }
+
+            Entry& current = m_entries[slot];
+            auto found = disk.find(current.path.as_posix());
+            if (found == disk.end() || found->second.first.kind != current.kind) {
+                // Gone, or replaced by an entry of the other kind (re-added below).
+                removed[slot] = 1;
+                ++removed_count;
+                changes.emplace_back(Change{current.path, Change::Kind::removed, current.kind});
+                m_cache->invalidate(slot);
+                continue;
+            }
+
+            const auto& [entry, inode] = found->second;
+            const bool changed = entry.size != current.size || entry.mtime != current.mtime || inode != m_inodes[slot];
+            if (changed && current.kind == Entry::Kind::file) {
+                changes.emplace_back(Change{current.path, Change::Kind::modified, current.kind});
+                m_cache->invalidate(slot);
+            }
+            // Directory mtimes move with every child change; they are updated but not reported.
+            current.size = entry.size;
+            current.mtime = entry.mtime;
+            m_inodes[slot] = inode;
+            disk.erase(found);
+        }
+    }
+
+    // Whatever is left on the disk side is new. A path refreshed ahead of its
+    // directory's own event still needs the directory indexed first.
+    vec<str> added;
+    added.reserve(disk.size());
+    for (const auto& [key, _] : disk) {
+        added.emplace_back(key);
+    }
+    for (usize i = 0; i < added.size(); ++i) {
+        const auto cut = added[i].rfind('/');
+        if (cut == str::npos) {
+            continue;
+        }
+        str parent = added[i].substr(0, cut);
+        const u32 slot = m_index.find(parent);
+        if ((slot == PathIndex::npos || removed[slot]) && !disk.contains(parent)) {
+            Entry entry;
+            entry.path = PurePath(parent);
+            entry.db = this;
+            entry.kind = Entry::Kind::dir;
+            const u64 inode = read_metadata(join_under(m_resolved_root, entry.path), entry);
+            disk.emplace(parent, std::pair{std::move(entry), inode});
+            added.emplace_back(std::move(parent));
         }
+    }
+    std::sort(added.begin(), added.end());
+    for (const auto& key : added) {
+        const Entry& entry = disk.at(key).first;
+        changes.emplace_back(Change{entry.path, Change::Kind::added, entry.kind});
+    }
 
-        for (const auto& dir_name : walk_entry.dirs) {
-            add_entry((walk_entry.path / dir_name).resolve());
+    if (!added.empty() || removed_count != 0) {
+        // Merge the surviving entries with the new ones; both sides are sorted,
+        // so the index is rebuilt from memory without walking the tree again.
+        const usize count = m_entries.size() - removed_count + added.size();
+        vec<Entry> entries;
+        vec<u64> inodes;
+        vec<str> keys;
+        vec<u32> remap(m_entries.size(), PathIndex::npos);
+        entries.reserve(count);
+        inodes.reserve(count);
+        keys.reserve(count);
+
+        auto take_added = [&](const str& key) {
+            auto& [entry, inode] = disk.at(key);
+            entries.emplace_back(std::move(entry));
+            inodes.emplace_back(inode);
+            keys.emplace_back(key);
+        };
+
+        usize next = 0;
+        for (u32 slot = 0; slot < m_entries.size(); ++slot) {
+            if (removed[slot]) {
+                continue;
+            }
+            const std::string_view key = m_index.key(slot);
+            while (next < added.size() && added[next] < key) {
+                take_added(added[next++]);
+            }
+            remap[slot] = static_cast<u32>(entries.size());
+            entries.emplace_back(std::move(m_entries[slot]));
+            inodes.emplace_back(m_inodes[slot]);
+            keys.emplace_back(key);
         }
-        for (const auto& file_name : walk_entry.files) {
-            add_entry((walk_entry.path / file_name).resolve());
+        while (next < added.size()) {
+            take_added(added[next++]);
         }
+
+        vec<std::string_view> views(keys.begin(), keys.end());
+        PathIndex index;
+        index.build(views);
+
+        std::lock_guard lock(m_cache->mutex);
+        m_cache->remap(remap, entries.size());
+        m_entries = std::move(entries);
+        m_inodes = std::move(inodes);
+        m_index = std::move(index);
     }
 
-    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) {
-        return lhs.path.as_posix() < rhs.path.as_posix();
+    std::sort(changes.begin(), changes.end(), [](const Change& lhs, const Change& rhs) {
+        const str left = lhs.path.as_posix();
+        const str right = rhs.path.as_posix();
+        // A path that changed kind reports its removal first.
+        return left != right ? left < right : lhs.kind == Change::Kind::removed && rhs.kind != Change::Kind::removed;
+    });
+
+    if (!changes.empty()) {
+        // Copied so subscribers may unsubscribe from inside the callback.
+        const auto subscribers = m_subscribers;
+        for (const auto& [_, subscriber] : subscribers) {
+            subscriber(changes);
+        }
+    }
+    return changes;
+}
+
+void FilesystemDatabase::watch() {
+#ifdef __linux__
+    ensure_loaded();
+    if (m_watcher) {
+        return;
+    }
+
+    auto watcher = make_sptr<Watcher>();
+    watcher->fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->fd < 0) {
+        throw RuntimeError("Failed to initialise inotify: " + str(std::strerror(errno)));
+    }
+
+    m_watcher = std::move(watcher);
+    try {
+        add_watch(str());
+        for (const auto& entry : m_entries) {
+            if (entry.kind == Entry::Kind::dir) {
+                add_watch(entry.path.as_posix());
+            }
+        }
+    } catch (...) {
+        m_watcher.reset();
+        throw;
+    }
+#else
+    throw RuntimeError("FilesystemDatabase::watch() needs inotify; call refresh() with the changed paths instead.");
+#endif
+}
+
+void FilesystemDatabase::unwatch() {
+    m_watcher.reset();
+}
+
+bool FilesystemDatabase::watching() const noexcept {
+    return m_watcher != nullptr;
+}
+
+void FilesystemDatabase::add_watch([[maybe_unused]] const str& key) {
+#ifdef __linux__
+    const Path absolute = join_under(m_resolved_root, PurePath(key));
+    const int wd = ::inotify_add_watch(m_watcher->fd, absolute.string().c_str(), WATCH_MASK);
+    if (wd < 0) {
+        if (errno == ENOENT || errno == ENOTDIR) {
+            // Removed since it was indexed; its parent's event reports that.
+            return;
+        }
+        throw RuntimeError("Failed to watch directory '" + absolute.string() + "': " + std::strerror(errno));
+    }
+    m_watcher->dirs[wd] = key;
+#endif
+}
+
+usize FilesystemDatabase::poll() {
+#ifdef __linux__
+    if (!m_watcher) {
+        return 0;
+    }
+
+    vec<PurePath> dirty;
+    std::unordered_set<str> seen;
+    bool overflow = false;
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+        const ssize_t length = ::read(m_watcher->fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN: the queue is drained.
+            break;
+        }
+        for (ssize_t at = 0; at < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + at);
+            at += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_watcher->dirs.erase(event->wd);
+                continue;
+            }
+            auto dir = m_watcher->dirs.find(event->wd);
+            if (dir == m_watcher->dirs.end() || event->len == 0 || event->name[0] == '\0') {
+                continue;
+            }
+            str key = dir->second.empty() ? str(event->name) : dir->second + '/' + event->name;
+            if (seen.insert(key).second) {
+                dirty.emplace_back(std::move(key));
+            }
+        }
+    }
+
+    if (overflow) {
+        // Events were lost; only a full rescan is trustworthy.
+        dirty.assign(1, PurePath());
+    }
+
+    // Directories that appeared need watches of their own. Anything created in
+    // them before the watch existed is caught by refreshing them once more.
+    usize applied = 0;
+    while (!dirty.empty()) {
+        const auto changes = refresh(dirty);
+        applied += changes.size();
+        dirty.clear();
+        for (const auto& change : changes) {
+            if (change.entry != Entry::Kind::dir) {
+                continue;
+            }
+            const str key = change.path.as_posix();
+            if (change.kind == Change::Kind::added) {
+                add_watch(key);
+                dirty.emplace_back(change.path);
+            } else if (change.kind == Change::Kind::removed) {
+                // A directory moved elsewhere keeps its descriptor; stop it reporting under the old key.
+                std::erase_if(m_watcher->dirs, [&](const auto& watched) {
+                    if (watched.second != key) {
+                        return false;
+                    }
+                    ::inotify_rm_watch(m_watcher->fd, watched.first);
+                    return true;
+                });
+            }
+        }
+    }
+    return applied;
+#else
+    return 0;
+#endif
+}
+
+u64 FilesystemDatabase::subscribe(Subscriber subscriber) {
+    const u64 token = ++m_next_subscriber;
+    m_subscribers.emplace_back(token, std::move(subscriber));
+    return token;
+}
+
+void FilesystemDatabase::unsubscribe(u64 token) {
+    std::erase_if(m_subscribers, [token](const auto& entry) {
+        return entry.first == token;
     });
 }
@@ -0,0 +1,135 @@
+#include "mloader/database/index.hxx"
+
+#include <algorithm>
+
+#include "mtl/error.hxx"
+
+#include "mloader/hash.hxx"
+
+using namespace mloader;
+
+void PathIndex::build(const vec<std::string_view>& keys) {
+    clear();
+
+    usize total = 0;
+    for (usize i = 0; i < keys.size(); ++i) {
+        total += keys[i].size();
+        if (i > 0 && !(keys[i - 1] < keys[i])) {
+            throw RuntimeError("PathIndex keys must be sorted and unique: " + str(keys[i]));
+        }
+    }
+    if (keys.size() >= npos || total >= npos) {
+        throw RuntimeError("PathIndex exceeds 32-bit slot or pool limits.");
+    }
+
+    m_pool.reserve(total);
+    m_offsets.reserve(keys.size() + 1);
+    for (const auto& key : keys) {
+        m_offsets.emplace_back(static_cast<u32>(m_pool.size()));
+        m_pool.append(key);
+    }
+    m_offsets.emplace_back(static_cast<u32>(m_pool.size()));
+
+    m_table.reserve(keys.size());
+    for (u32 slot = 0; slot < keys.size(); ++slot) {
+        m_table.insert(hash64(keys[slot].data(), keys[slot].size()), slot, [](u32) { return u64{0}; });
+    }
+
+    link();
+}
+
+void PathIndex::link() {
+    const auto count = static_cast<u32>(size());
+
+    // Parent of every slot; entries whose parent directory is not indexed
+    // stay reachable through find() and descendants() only.
+    vec<u32> parents(count, npos);
+    m_child_offsets.assign(count + 2, 0);
+    for (u32 slot = 0; slot < count; ++slot) {
+        const std::string_view name = key(slot);
+        const usize split = name.rfind('/');
+        u32 parent = count;
+        if (split != std::string_view::npos) {
+            parent = find(name.substr(0, split));
+            if (parent == npos) {
+                continue;
+            }
+        }
+        parents[slot] = parent;
+        ++m_child_offsets[parent + 1];
+    }
+
+    for (u32 i = 1; i < m_child_offsets.size(); ++i) {
+        m_child_offsets[i] += m_child_offsets[i - 1];
+    }
+
+    m_children.assign(m_child_offsets.back(), 0);
+    vec<u32> cursor(m_child_offsets.begin(), m_child_offsets.end() - 1);
+    for (u32 slot = 0; slot < count; ++slot) {
+        if (parents[slot] != npos) {
+            m_children[cursor[parents[slot]]++] = slot;
+        }
+    }
+}
+
+void PathIndex::clear() noexcept {
+    m_pool.clear();
+    m_offsets.clear();
+    m_table.clear();
+    m_child_offsets.clear();
+    m_children.clear();
+}
+
+u32 PathIndex::find(std::string_view key) const noexcept {
+    return m_table.find(hash64(key.data(), key.size()), [&](u32 slot) {
+        return this->key(slot) == key;
+    });
+}
+
+u32 PathIndex::lower_bound(std::string_view base, char tail) const noexcept {
+    // Orders keys against the virtual string base + tail without building it.
+    auto less = [&](std::string_view candidate) {
+        const int order = candidate.substr(0, base.size()).compare(base);
+        if (order != 0) {
+            return order < 0;
+        }
+        return candidate.size() == base.size() ||
+               static_cast<unsigned char>(candidate[base.size()]) < static_cast<unsigned char>(tail);
+    };
+
+    u32 first = 0;
+    u32 count = static_cast<u32>(size());
+    while (count > 0) {
+        const u32 step = count / 2;
+        if (less(key(first + step))) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+PathIndex::Range PathIndex::descendants(std::string_view key) const noexcept {
+    if (key.empty()) {
+        return Range{0, static_cast<u32>(size())};
+    }
+
+    // Everything below "dir" starts with "dir/" and sorts before "dir0".
+    return Range{lower_bound(key, '/'), lower_bound(key, static_cast<char>('/' + 1))};
+}
+
+std::span<const u32> PathIndex::children(u32 slot) const noexcept {
+    if (m_child_offsets.empty()) {
+        return {};
+    }
+    const usize index = slot == npos ? size() : slot;
+    const u32 begin = m_child_offsets[index];
+    return std::span<const u32>(m_children).subspan(begin, m_child_offsets[index + 1] - begin);
+}
+
+std::string_view PathIndex::key(u32 slot) const noexcept {
+    const u32 begin = m_offsets[slot];
+    return std::string_view(m_pool).substr(begin, m_offsets[slot + 1] - begin);
+}
@@ -0,0 +1,329 @@
+#include "mloader/database/joined.hxx"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "mtl/error.hxx"
+
+using namespace mloader;
+
+JoinedDatabase& JoinedDatabase::mount(Database& db, const PurePath& at, i32 priority) {
+    if (&db == this) {
+        throw RuntimeError("A JoinedDatabase cannot be mounted into itself.");
+    }
+    if (const auto* joined = dynamic_cast<const JoinedDatabase*>(&db); joined && joined->mounts_database(*this)) {
+        throw RuntimeError("Mounting this JoinedDatabase would create a mount cycle.");
+    }
+
+    m_mounts.emplace_back(Mount{&db, normalise(at), priority});
+    if (m_loaded) {
+        if (!db.is_loaded()) {
+            db.load();
+        }
+        build();
+    }
+    return *this;
+}
+
+bool JoinedDatabase::mounts_database(const Database& db) const {
+    // Every mount() rejects cycles, so the walk over nested joins terminates.
+    return std::any_of(m_mounts.begin(), m_mounts.end(), [&db](const Mount& mount) {
+        if (mount.db == &db) {
+            return true;
+        }
+        const auto* joined = dynamic_cast<const JoinedDatabase*>(mount.db);
+        return joined && joined->mounts_database(db);
+    });
+}
+
+JoinedDatabase& JoinedDatabase::unmount(Database& db) {
+    std::erase_if(m_mounts, [&db](const Mount& mount) {
+        return mount.db == &db;
+    });
+    if (m_loaded) {
+        build();
+    }
+    return *this;
+}
+
+bool JoinedDatabase::is_loaded() const noexcept {
+    return m_loaded;
+}
+
+JoinedDatabase& JoinedDatabase::load() {
+    if (m_loaded) {
+        return *this;
+    }
+
+    for (const auto& mount : m_mounts) {
+        if (!mount.db->is_loaded()) {
+            mount.db->load();
+        }
+    }
+    build();
+    m_loaded = true;
+    return *this;
+}
+
+JoinedDatabase& JoinedDatabase::unload() {
+    m_entries.clear();
+    m_owners.clear();
+    m_index.clear();
+    m_loaded = false;
+    return *this;
+}
+
+JoinedDatabase& JoinedDatabase::reindex() {
+    if (!m_loaded) {
+        return load();
+    }
+    build();
+    return *this;
+}
+
+void JoinedDatabase::ensure_loaded() const {
+    if (!m_loaded) {
+        const_cast<JoinedDatabase*>(this)->load();
+    }
+}
+
+void JoinedDatabase::build() {
+    // Visit mounts from the strongest down (later mounts first on equal
+    // priority), so the first claim on a path is the one that wins.
+    vec<u32> order(m_mounts.size());
+    std::iota(order.begin(), order.end(), u32{0});
+    std::stable_sort(order.begin(), order.end(), [this](u32 lhs, u32 rhs) {
+        if (m_mounts[lhs].priority != m_mounts[rhs].priority) {
+            return m_mounts[lhs].priority > m_mounts[rhs].priority;
+        }
+        return lhs > rhs;
+    });
+
+    umap<str, std::pair<Entry, u32>> merged;
+    auto claim_dir = [&](str key) {
+        Entry entry;
+        entry.path = PurePath(key);
+        entry.db = this;
+        entry.kind = Entry::Kind::dir;
+        merged.try_emplace(std::move(key), std::move(entry), PathIndex::npos);
+    };
+
+    for (u32 m : order) {
+        const Mount& mount = m_mounts[m];
+        const str prefix = mount.at.as_posix();
+        // The mount point and its ancestors exist even if no mount provides them.
+        for (str key = prefix; !key.empty();) {
+            const auto cut = key.rfind('/');
+            claim_dir(key);
+            key = cut == str::npos ? str() : key.substr(0, cut);
+        }
+
+        mount.db->each(PurePath(), [&](const Entry& entry) {
+            str key = prefix.empty() ? entry.path.as_posix() : prefix + '/' + entry.path.as_posix();
+            if (merged.contains(key)) {
+                return;
+            }
+            Entry joined = entry;
+            joined.path = PurePath(key);
+            joined.db = this;
+            merged.emplace(std::move(key), std::pair{std::move(joined), m});
+        });
+    }
+
+    // A file that shadows a directory of a weaker mount hides its contents too.
+    auto shadowed = [&merged](const str& key) {
+        for (auto cut = key.rfind('/'); cut != str::npos; cut = key.rfind('/', cut - 1)) {
+            auto parent = merged.find(key.substr(0, cut));
+            if (parent != merged.end() && parent->second.first.kind == Entry::Kind::file) {
+                return true;
+            }
+            if (cut == 0) {
+                break;
+            }
+        }
+        return false;
+    };
+
+    vec<str> keys;
+    keys.reserve(merged.size());
+    for (const auto& [key, _] : merged) {
+        if (!shadowed(key)) {
+            keys.emplace_back(key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    vec<Entry> entries;
+    vec<u32> owners;
+    vec<std::string_view> views;
+    entries.reserve(keys.size());
+    owners.reserve(keys.size());
+    views.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto& [entry, owner] = merged.at(key);
+        entries.emplace_back(std::move(entry));
+        owners.emplace_back(owner);
+        views.emplace_back(key);
+    }
+
+    PathIndex index;
+    index.build(views);
+    m_entries = std::move(entries);
+    m_owners = std::move(owners);
+    m_index = std::move(index);
+}
+
+vec<Database::Entry> JoinedDatabase::list() {
+    ensure_loaded();
+    return m_entries;
+}
+
+vec<Database::Entry> JoinedDatabase::list(const PurePath& rel) {
+    vec<Entry> subset;
+    each(rel, [&](const Entry& entry) {
+        subset.emplace_back(entry);
+    });
+    return subset;
+}
+
+void JoinedDatabase::each(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    if (!key.empty()) {
+        const u32 slot = m_index.find(key);
+        if (slot == PathIndex::npos) {
+            return;
+        }
+        visitor(m_entries[slot]);
+    }
+
+    const auto range = m_index.descendants(key);
+    for (u32 slot = range.first; slot < range.last; ++slot) {
+        visitor(m_entries[slot]);
+    }
+}
+
+void JoinedDatabase::children(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    u32 parent = PathIndex::npos;
+    if (!key.empty()) {
+        parent = m_index.find(key);
+        if (parent == PathIndex::npos) {
+            return;
+        }
+    }
+
+    for (u32 slot : m_index.children(parent)) {
+        visitor(m_entries[slot]);
+    }
+}
+
+ResourceHandle JoinedDatabase::resolve(const PurePath& rel) {
+    ensure_loaded();
+    const u32 slot = file_slot(rel);
+    return m_mounts[m_owners[slot]].db->resolve(inner_path(slot));
+}
+
+vec<ResourceHandle> JoinedDatabase::resolve(const vec<PurePath>& rels) {
+    ensure_loaded();
+
+    vec<u32> slots;
+    slots.reserve(rels.size());
+    for (const auto& rel : rels) {
+        slots.emplace_back(file_slot(rel));
+    }
+
+    // One batch per owning database keeps their own batching (parallel,
+    // inode ordered reads) intact; handles are scattered back in input order.
+    vec<vec<usize>> groups(m_mounts.size());
+    for (usize i = 0; i < slots.size(); ++i) {
+        groups[m_owners[slots[i]]].emplace_back(i);
+    }
+
+    vec<ResourceHandle> handles(rels.size());
+    for (usize m = 0; m < groups.size(); ++m) {
+        const auto& group = groups[m];
+        if (group.empty()) {
+            continue;
+        }
+
+        vec<PurePath> inner;
+        inner.reserve(group.size());
+        for (usize i : group) {
+            inner.emplace_back(inner_path(slots[i]));
+        }
+        auto resolved = m_mounts[m].db->resolve(inner);
+        for (usize j = 0; j < group.size(); ++j) {
+            handles[group[j]] = std::move(resolved[j]);
+        }
+    }
+    return handles;
+}
+
+bool JoinedDatabase::exists(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    return find_slot(relative) != PathIndex::npos;
+}
+
+bool JoinedDatabase::is_file(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return false;
+    }
+    const u32 slot = find_slot(relative);
+    return slot != PathIndex::npos && m_entries[slot].kind == Entry::Kind::file;
+}
+
+bool JoinedDatabase::is_dir(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    const u32 slot = find_slot(relative);
+    return slot != PathIndex::npos && m_entries[slot].kind == Entry::Kind::dir;
+}
+
+Database* JoinedDatabase::owner(const PurePath& rel) const {
+    ensure_loaded();
+    const u32 slot = find_slot(normalise(rel));
+    if (slot == PathIndex::npos || m_owners[slot] == PathIndex::npos) {
+        return nullptr;
+    }
+    return m_mounts[m_owners[slot]].db;
+}
+
+u32 JoinedDatabase::find_slot(const PurePath& rel) const {
+    return m_index.find(rel.as_posix());
+}
+
+u32 JoinedDatabase::file_slot(const PurePath& rel) const {
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        throw RuntimeError("Cannot resolve the database root as a resource.");
+    }
+
+    const u32 slot = find_slot(relative);
+    if (slot == PathIndex::npos) {
+        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    }
+    if (m_entries[slot].kind != Entry::Kind::file) {
+        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
+    }
+    return slot;
+}
+
+JoinedDatabase::PurePath JoinedDatabase::inner_path(u32 slot) const {
+    const std::string_view key = m_index.key(slot);
+    const str prefix = m_mounts[m_owners[slot]].at.as_posix();
+    return PurePath(str(prefix.empty() ? key : key.substr(prefix.size() + 1)));
+}
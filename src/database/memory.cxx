@@ -0,0 +1,448 @@
+#include "mloader/database/memory.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "mtl/error.hxx"
+
+using namespace mloader;
+
+namespace {
+
+    constexpr usize ARENA_ALIGNMENT = 16;
+
+    /**
+     * Resource viewing a file inside the arena. Instances are owned by the
+     * database and reused for every resolve of the same file, so reaching a
+     * zero reference count does not free anything.
+     */
+    class MemoryResource final : public Resource {
+    public:
+        MemoryResource(Database& owner, std::span<const byte> data)
+            : Resource(owner), m_data(data) {}
+
+        const void* data() const override {
+            return m_data.data();
+        }
+
+        u64 size() const override {
+            return static_cast<u64>(m_data.size());
+        }
+
+    protected:
+        void destroy_self() override {}
+
+    private:
+        std::span<const byte> m_data;
+    };
+
+    i64 now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+} // namespace
+
+byte* InMemoryDatabase::Arena::allocate(usize size) {
+    const usize offset = (used + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    if (chunks.empty() || offset + size > sizes.back()) {
+        // Oversized files get a chunk of their own.
+        const usize capacity = std::max(chunk_size, size);
+        chunks.emplace_back(new byte[capacity]);
+        sizes.emplace_back(capacity);
+        used = size;
+        return chunks.back().get();
+    }
+    used = offset + size;
+    return chunks.back().get() + offset;
+}
+
+usize InMemoryDatabase::Arena::capacity() const noexcept {
+    usize total = 0;
+    for (usize size : sizes) {
+        total += size;
+    }
+    return total;
+}
+
+void InMemoryDatabase::Arena::clear() noexcept {
+    chunks.clear();
+    sizes.clear();
+    used = 0;
+}
+
+bool InMemoryDatabase::is_loaded() const noexcept {
+    return m_loaded;
+}
+
+InMemoryDatabase& InMemoryDatabase::load() {
+    m_loaded = true;
+    return *this;
+}
+
+InMemoryDatabase& InMemoryDatabase::unload() {
+    m_slots.clear();
+    m_index.clear();
+    m_dirty = true;
+    m_loaded = false;
+    return *this;
+}
+
+void InMemoryDatabase::ensure_loaded() const {
+    if (!m_dirty.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // Queries reach this from const methods on several threads; only one rebuilds.
+    std::lock_guard lock(m_mutex);
+    if (!m_loaded) {
+        const_cast<InMemoryDatabase*>(this)->load();
+    }
+    ensure_indexed();
+}
+
+void InMemoryDatabase::ensure_indexed() const {
+    if (!m_dirty.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Keys view the map's own strings, which stay put until the next edit.
+    vec<std::pair<std::string_view, Node*>> sorted;
+    sorted.reserve(m_nodes.size());
+    for (const auto& [key, node] : m_nodes) {
+        sorted.emplace_back(key, const_cast<Node*>(&node));
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    vec<std::string_view> keys;
+    keys.reserve(sorted.size());
+    m_slots.clear();
+    m_slots.reserve(sorted.size());
+    for (const auto& [key, node] : sorted) {
+        keys.emplace_back(key);
+        m_slots.emplace_back(node);
+    }
+    m_index.build(keys);
+    m_dirty.store(false, std::memory_order_release);
+}
+
+InMemoryDatabase& InMemoryDatabase::insert(const PurePath& rel, std::span<const byte> data) {
+    const str key = normalise(rel).as_posix();
+    if (key.empty()) {
+        throw RuntimeError("Cannot store a file at the database root.");
+    }
+
+    if (auto found = m_nodes.find(key); found != m_nodes.end() && found->second.entry.kind == Entry::Kind::dir) {
+        throw RuntimeError("Cannot replace a directory with a file: " + key);
+    }
+    add_parents(key);
+
+    byte* stored = nullptr;
+    if (!data.empty()) {
+        stored = m_arena.allocate(data.size());
+        std::memcpy(stored, data.data(), data.size());
+    }
+
+    // Looked up after add_parents(), which may rehash the map.
+    auto it = m_nodes.find(key);
+    if (it == m_nodes.end()) {
+        it = m_nodes.try_emplace(key).first;
+        m_dirty = true;
+    } else {
+        // The old bytes stay in the arena for handles that still view them.
+        retire(it->second);
+        m_live_bytes -= it->second.data.size();
+    }
+
+    Node& node = it->second;
+    node.entry.path = PurePath(key);
+    node.entry.db = this;
+    node.entry.kind = Entry::Kind::file;
+    node.entry.size = static_cast<u64>(data.size());
+    node.entry.mtime = now();
+    node.data = {stored, data.size()};
+    m_live_bytes += data.size();
+    return *this;
+}
+
+InMemoryDatabase& InMemoryDatabase::insert(const PurePath& rel, std::string_view text) {
+    return insert(rel, std::span<const byte>(reinterpret_cast<const byte*>(text.data()), text.size()));
+}
+
+InMemoryDatabase& InMemoryDatabase::insert(const vec<std::pair<PurePath, std::span<const byte>>>& files) {
+    for (const auto& [rel, data] : files) {
+        insert(rel, data);
+    }
+    return *this;
+}
+
+InMemoryDatabase& InMemoryDatabase::add_dir(const PurePath& rel) {
+    const str key = normalise(rel).as_posix();
+    if (key.empty()) {
+        return *this;
+    }
+
+    auto it = m_nodes.find(key);
+    if (it != m_nodes.end()) {
+        if (it->second.entry.kind != Entry::Kind::dir) {
+            throw RuntimeError("Cannot replace a file with a directory: " + key);
+        }
+        return *this;
+    }
+
+    add_parents(key);
+    Node& node = m_nodes[key];
+    node.entry.path = PurePath(key);
+    node.entry.db = this;
+    node.entry.kind = Entry::Kind::dir;
+    node.entry.mtime = now();
+    m_dirty = true;
+    return *this;
+}
+
+void InMemoryDatabase::add_parents(const str& key) {
+    for (auto cut = key.find('/'); cut != str::npos; cut = key.find('/', cut + 1)) {
+        const str parent = key.substr(0, cut);
+        auto it = m_nodes.find(parent);
+        if (it == m_nodes.end()) {
+            Node& node = m_nodes[parent];
+            node.entry.path = PurePath(parent);
+            node.entry.db = this;
+            node.entry.kind = Entry::Kind::dir;
+            node.entry.mtime = now();
+            m_dirty = true;
+        } else if (it->second.entry.kind != Entry::Kind::dir) {
+            throw RuntimeError("Path runs through a file: " + key);
+        }
+    }
+}
+
+usize InMemoryDatabase::remove(const PurePath& rel) {
+    const str key = normalise(rel).as_posix();
+    if (key.empty()) {
+        const usize count = m_nodes.size();
+        clear();
+        return count;
+    }
+    return erase(key);
+}
+
+usize InMemoryDatabase::remove(const vec<PurePath>& rels) {
+    usize count = 0;
+    for (const auto& rel : rels) {
+        count += remove(rel);
+    }
+    return count;
+}
+
+usize InMemoryDatabase::erase(const str& key) {
+    auto it = m_nodes.find(key);
+    if (it == m_nodes.end()) {
+        return 0;
+    }
+
+    usize count = 0;
+    if (it->second.entry.kind == Entry::Kind::dir) {
+        // Removals do not rebuild the index, so the subtree is found by prefix.
+        const str prefix = key + '/';
+        for (auto child = m_nodes.begin(); child != m_nodes.end();) {
+            if (child->first.starts_with(prefix)) {
+                retire(child->second);
+                m_live_bytes -= child->second.data.size();
+                child = m_nodes.erase(child);
+                ++count;
+            } else {
+                ++child;
+            }
+        }
+        it = m_nodes.find(key);
+    }
+
+    retire(it->second);
+    m_live_bytes -= it->second.data.size();
+    m_nodes.erase(it);
+    m_dirty = true;
+    return count + 1;
+}
+
+void InMemoryDatabase::clear() {
+    for (auto& [_, node] : m_nodes) {
+        retire(node);
+    }
+    m_nodes.clear();
+    m_live_bytes = 0;
+    m_dirty = true;
+    if (!referenced()) {
+        m_retired.clear();
+        m_arena.clear();
+    }
+}
+
+void InMemoryDatabase::compact() {
+    if (referenced()) {
+        throw RuntimeError("Cannot compact InMemoryDatabase while resources are still referenced.");
+    }
+
+    Arena arena;
+    arena.chunk_size = m_arena.chunk_size;
+    for (auto& [_, node] : m_nodes) {
+        node.resource.reset();
+        if (!node.data.empty()) {
+            byte* stored = arena.allocate(node.data.size());
+            std::memcpy(stored, node.data.data(), node.data.size());
+            node.data = {stored, node.data.size()};
+        }
+    }
+    m_retired.clear();
+    m_arena = std::move(arena);
+}
+
+usize InMemoryDatabase::arena_capacity() const noexcept {
+    return m_arena.capacity();
+}
+
+void InMemoryDatabase::retire(Node& node) {
+    if (!node.resource) {
+        return;
+    }
+
+    node.resource->mark_stale();
+    if (node.resource->refcount() > 0) {
+        m_retired.emplace_back(std::move(node.resource));
+    }
+    node.resource.reset();
+    std::erase_if(m_retired, [](const uptr<Resource>& resource) {
+        return resource->refcount() == 0;
+    });
+}
+
+bool InMemoryDatabase::referenced() const {
+    for (const auto& resource : m_retired) {
+        if (resource->refcount() > 0) {
+            return true;
+        }
+    }
+    for (const auto& [_, node] : m_nodes) {
+        if (node.resource && node.resource->refcount() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+vec<Database::Entry> InMemoryDatabase::list() {
+    ensure_loaded();
+
+    vec<Entry> entries;
+    entries.reserve(m_slots.size());
+    for (const Node* node : m_slots) {
+        entries.emplace_back(node->entry);
+    }
+    return entries;
+}
+
+vec<Database::Entry> InMemoryDatabase::list(const PurePath& rel) {
+    vec<Entry> subset;
+    each(rel, [&](const Entry& entry) {
+        subset.emplace_back(entry);
+    });
+    return subset;
+}
+
+void InMemoryDatabase::each(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    if (!key.empty()) {
+        const u32 slot = m_index.find(key);
+        if (slot == PathIndex::npos) {
+            return;
+        }
+        visitor(m_slots[slot]->entry);
+    }
+
+    const auto range = m_index.descendants(key);
+    for (u32 slot = range.first; slot < range.last; ++slot) {
+        visitor(m_slots[slot]->entry);
+    }
+}
+
+void InMemoryDatabase::children(const PurePath& rel, const Visitor& visitor) {
+    ensure_loaded();
+
+    const str key = normalise(rel).as_posix();
+    u32 parent = PathIndex::npos;
+    if (!key.empty()) {
+        parent = m_index.find(key);
+        if (parent == PathIndex::npos) {
+            return;
+        }
+    }
+
+    for (u32 slot : m_index.children(parent)) {
+        visitor(m_slots[slot]->entry);
+    }
+}
+
+ResourceHandle InMemoryDatabase::resolve(const PurePath& rel) {
+    ensure_loaded();
+
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        throw RuntimeError("Cannot resolve the database root as a resource.");
+    }
+
+    const u32 slot = m_index.find(relative.as_posix());
+    if (slot == PathIndex::npos) {
+        throw RuntimeError("Failed to resolve resource: " + relative.as_posix());
+    }
+    Node& node = *m_slots[slot];
+    if (node.entry.kind != Entry::Kind::file) {
+        throw RuntimeError("Requested path is not a file: " + relative.as_posix());
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (!node.resource) {
+        node.resource = make_uptr<MemoryResource>(*this, node.data);
+    }
+    return ResourceHandle(node.resource.get());
+}
+
+const InMemoryDatabase::Node* InMemoryDatabase::find_node(const PurePath& rel) const {
+    const u32 slot = m_index.find(rel.as_posix());
+    return slot == PathIndex::npos ? nullptr : m_slots[slot];
+}
+
+bool InMemoryDatabase::exists(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    return find_node(relative) != nullptr;
+}
+
+bool InMemoryDatabase::is_file(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return false;
+    }
+    const Node* node = find_node(relative);
+    return node && node->entry.kind == Entry::Kind::file;
+}
+
+bool InMemoryDatabase::is_dir(const PurePath& rel) const {
+    ensure_loaded();
+    auto relative = normalise(rel);
+    if (relative.string().empty()) {
+        return true;
+    }
+    const Node* node = find_node(relative);
+    return node && node->entry.kind == Entry::Kind::dir;
+}
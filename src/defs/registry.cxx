@@ -1,12 +1,66 @@
 #include "mloader/defs/registry.hxx"
 
+#include "mtl/binary/binary.hxx"
 #include "mtl/common/string.hxx"
 #include "mtl/error.hxx"
 
+#include "mloader/hash.hxx"
+#include "mloader/mapping.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
 #include <yaml-cpp/yaml.h>
 
 namespace mloader {
 
+    namespace {
+
+        constexpr char CACHE_MAGIC[4] = {'M', 'L', 'D', 'C'};
+        constexpr u32 CACHE_VERSION = 2;
+
+        /// Symbols are dense, so a Fibonacci multiply spreads them well enough for FlatTable.
+        u64 symbol_hash(u32 symbol) noexcept {
+            return static_cast<u64>(symbol) * 0x9E3779B97F4A7C15ull;
+        }
+
+        /// Deep-merges mappings; any other overlay value replaces the base outright.
+        YAML::Node merge_nodes(const YAML::Node& base, const YAML::Node& overlay) {
+            if (!base || !base.IsMap() || !overlay.IsMap()) {
+                return YAML::Clone(overlay);
+            }
+
+            YAML::Node merged = YAML::Clone(base);
+            for (const auto& entry : overlay) {
+                const str key = entry.first.as<str>();
+                const YAML::Node inherited = base[key];
+                merged[key] = inherited ? merge_nodes(inherited, entry.second) : YAML::Clone(entry.second);
+            }
+            return merged;
+        }
+
+    } // namespace
+
+    struct DefinitionRegistry::Template {
+        str type_name;
+        str id;
+        str parent;
+        str source_label;
+        YAML::Node data;
+        /// `data` merged over the parent's resolved data with `id` injected; set once linked.
+        YAML::Node resolved;
+        bool linked = false;
+        bool visiting = false;
+    };
+
+    DefinitionRegistry::DefinitionRegistry() = default;
+    DefinitionRegistry::~DefinitionRegistry() = default;
+
     void DefinitionRegistry::register_type(const str& type_name, Factory factory) {
         if (!factory) {
             throw RuntimeError("Attempted to register definition type '" + type_name + "' with null factory.");
@@ -19,22 +73,22 @@ namespace mloader {
     }
 
     void DefinitionRegistry::ingest(const mtl::fs::Path& file_path) {
-        if (!file_path.exists()) {
-            throw RuntimeError("Definition file not found: " + file_path.string());
-        }
-
-        auto contents = file_path.read_text();
-        ingest_yaml(contents, file_path.string());
+        auto batch = parse_file(file_path);
+        commit(batch);
+        link();
     }
 
     void DefinitionRegistry::ingest(const vec<mtl::fs::Path>& files) {
         for (const auto& file : files) {
-            ingest(file);
+            auto batch = parse_file(file);
+            commit(batch);
         }
+        link();
     }
 
     void DefinitionRegistry::ingest(const ResourceHandle& resource) {
         ingest_resource(resource, "<resource>");
+        link();
     }
 
     void DefinitionRegistry::ingest(const vec<ResourceHandle>& resources) {
@@ -42,11 +96,215 @@ namespace mloader {
             str label = "<resource[" + std::to_string(i) + "]>";
             ingest_resource(resources[i], label);
         }
+        link();
+    }
+
+    void DefinitionRegistry::ingest(const vec<mtl::fs::Path>& files, WorkerPool& pool) {
+        vec<Batch> batches(files.size());
+        vec<std::exception_ptr> errors(files.size());
+        pool.parallel(files.size(), [&](usize i) {
+            try {
+                batches[i] = parse_file(files[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        merge(batches, errors);
+    }
+
+    void DefinitionRegistry::ingest(const vec<ResourceHandle>& resources, WorkerPool& pool) {
+        vec<Batch> batches(resources.size());
+        vec<std::exception_ptr> errors(resources.size());
+        pool.parallel(resources.size(), [&](usize i) {
+            try {
+                batches[i] = parse_resource(resources[i], "<resource[" + std::to_string(i) + "]>");
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        merge(batches, errors);
+    }
+
+    void DefinitionRegistry::ingest(Database& db, const vec<Database::PurePath>& paths) {
+        const auto resources = db.resolve(paths);
+        for (usize i = 0; i < resources.size(); ++i) {
+            ingest_resource(resources[i], paths[i].as_posix());
+        }
+        link();
+    }
+
+    void DefinitionRegistry::reingest(Database& db, const vec<Database::PurePath>& paths) {
+        vec<Batch> batches;
+        std::unordered_set<str> labels;
+        for (const auto& path : paths) {
+            str label = path.as_posix();
+            if (db.is_file(path)) {
+                batches.emplace_back(parse_resource(db.resolve(path), label));
+            }
+            labels.emplace(std::move(label));
+        }
+
+        // Everything is staged and checked against what would survive before
+        // the registry is touched, so any failure leaves it unchanged. Keyed
+        // entries of the replaced files go; entries that inherit from them
+        // stay but are relinked, since their merged data is stale even though
+        // their own file did not change.
+        umap<str, umap<str, uptr<Template>>> staged;
+        umap<str, std::unordered_set<str>> relinked;
+        vec<Template*> pending;
+        for (const auto& [type_name, bucket] : m_templates) {
+            auto& staged_bucket = staged[type_name];
+            std::unordered_set<str> replaced;
+            for (const auto& [id, entry] : bucket) {
+                if (labels.contains(entry->source_label)) {
+                    replaced.emplace(id);
+                } else {
+                    staged_bucket.emplace(id, make_uptr<Template>(*entry));
+                }
+            }
+
+            for (bool grew = !replaced.empty(); grew;) {
+                grew = false;
+                for (auto& [id, entry] : staged_bucket) {
+                    if (entry->linked && replaced.contains(entry->parent)) {
+                        entry->linked = false;
+                        // reset() rebinds; assigning would write through to the live template's node.
+                        entry->resolved.reset();
+                        pending.emplace_back(entry.get());
+                        replaced.emplace(id);
+                        relinked[type_name].emplace(id);
+                        grew = true;
+                    }
+                }
+            }
+        }
+
+        std::unordered_set<Symbol> sources;
+        for (const auto& label : labels) {
+            const Symbol source = m_sources.find(label);
+            if (source != SymbolTable::npos) {
+                sources.emplace(source);
+            }
+        }
+
+        // Ids that stay defined per type; new definitions must not collide with them.
+        vec<vec<u8>> drops(m_tables.size());
+        umap<str, std::unordered_set<str>> taken;
+        for (Symbol type = 0; type < m_tables.size(); ++type) {
+            const auto& table = m_tables[type];
+            const str type_name(m_type_names.name(type));
+            const auto dependents = relinked.find(type_name);
+            auto& ids = taken[type_name];
+            drops[type].assign(table.definitions.size(), 0);
+            for (usize i = 0; i < table.definitions.size(); ++i) {
+                const str& id = table.definitions[i]->identifier();
+                if (sources.contains(table.sources[i]) || (dependents != relinked.end() && dependents->second.contains(id))) {
+                    drops[type][i] = 1;
+                } else {
+                    ids.emplace(id);
+                }
+            }
+        }
+
+        const auto claim = [&](const str& type_name, const str& id, const str& source_label) {
+            if (!taken[type_name].emplace(id).second) {
+                throw RuntimeError("Duplicate definition '" + id + "' for type '" + type_name + "' encountered in " + source_label + ".");
+            }
+        };
+        for (auto& batch : batches) {
+            for (const auto& [type_name, definition] : batch.definitions) {
+                claim(type_name, definition->identifier(), batch.source_label);
+            }
+            for (auto& entry : batch.templates) {
+                auto& staged_bucket = staged[entry.type_name];
+                if (staged_bucket.contains(entry.id)) {
+                    throw RuntimeError("Duplicate definition '" + entry.id + "' for type '" + entry.type_name + "' encountered in " + entry.source_label + ".");
+                }
+                const str id = entry.id;
+                pending.emplace_back(staged_bucket.emplace(id, make_uptr<Template>(std::move(entry))).first->second.get());
+            }
+        }
+
+        // resolve_template() works on m_templates, so link against the staged set and swap back on failure.
+        vec<DefinitionPtr> built;
+        m_templates.swap(staged);
+        try {
+            for (Template* entry : pending) {
+                resolve_template(*entry);
+            }
+            for (Template* entry : pending) {
+                claim(entry->type_name, entry->id, entry->source_label);
+                built.emplace_back(build_node(entry->type_name, entry->resolved, entry->source_label));
+            }
+        } catch (...) {
+            m_templates.swap(staged);
+            throw;
+        }
+
+        for (Symbol type = 0; type < drops.size(); ++type) {
+            if (std::find(drops[type].begin(), drops[type].end(), u8{1}) != drops[type].end()) {
+                erase(type, drops[type]);
+            }
+        }
+        for (auto& batch : batches) {
+            for (auto& [type_name, definition] : batch.definitions) {
+                insert(type_name, std::move(definition), batch.source_label);
+            }
+        }
+        for (usize i = 0; i < pending.size(); ++i) {
+            insert(pending[i]->type_name, std::move(built[i]), pending[i]->source_label);
+        }
+    }
+
+    void DefinitionRegistry::merge(vec<Batch>& batches, vec<std::exception_ptr>& errors) {
+        // Walking the inputs in order reproduces the serial ingest: an earlier
+        // duplicate wins over a later parse error and vice versa.
+        for (usize i = 0; i < batches.size(); ++i) {
+            if (errors[i]) {
+                std::rethrow_exception(errors[i]);
+            }
+            commit(batches[i]);
+        }
+        link();
+    }
+
+    void DefinitionRegistry::commit(Batch& batch) {
+        for (auto& [type_name, definition] : batch.definitions) {
+            insert(type_name, std::move(definition), batch.source_label);
+        }
+        for (auto& entry : batch.templates) {
+            add_template(std::move(entry));
+        }
     }
 
     void DefinitionRegistry::ingest_yaml(const str& contents, const str& source_label) {
+        auto batch = parse_yaml(contents, source_label);
+        commit(batch);
+    }
+
+    void DefinitionRegistry::ingest_resource(const ResourceHandle& resource, const str& source_label) {
+        auto batch = parse_resource(resource, source_label);
+        commit(batch);
+    }
+
+    void DefinitionRegistry::ingest_node(const str& type_name, const YAML::Node& node, const str& source_label) {
+        insert(type_name, build_node(type_name, node, source_label), source_label);
+    }
+
+    DefinitionRegistry::Batch DefinitionRegistry::parse_file(const mtl::fs::Path& file_path) const {
+        if (!file_path.exists()) {
+            throw RuntimeError("Definition file not found: " + file_path.string());
+        }
+
+        auto contents = file_path.read_text();
+        return parse_yaml(contents, file_path.string());
+    }
+
+    DefinitionRegistry::Batch DefinitionRegistry::parse_yaml(const str& contents, const str& source_label) const {
+        Batch batch;
+        batch.source_label = source_label;
         if (contents.empty()) {
-            return;
+            return batch;
         }
 
         YAML::Node root;
@@ -57,7 +315,7 @@ namespace mloader {
         }
 
         if (!root || root.IsNull()) {
-            return;
+            return batch;
         }
 
         auto process_node = [&](const YAML::Node& node) {
@@ -77,28 +335,66 @@ namespace mloader {
                 throw RuntimeError("Failed to convert definition type to string in '" + source_label + "': " + ex.what());
             }
 
-            ingest_node(type_name, node, source_label);
+            batch.definitions.emplace_back(type_name, build_node(type_name, node, source_label));
+        };
+
+        auto process_keyed = [&](const str& id, const YAML::Node& node) {
+            if (!node.IsMap()) {
+                throw RuntimeError("Definition '" + id + "' in '" + source_label + "' must be a mapping.");
+            }
+
+            auto type_node = node["type"];
+            if (!type_node || !type_node.IsScalar()) {
+                throw RuntimeError("Definition entry in '" + source_label + "' is missing scalar 'type' field.");
+            }
+
+            Template entry;
+            entry.type_name = type_node.as<str>();
+            entry.id = id;
+            entry.source_label = source_label;
+            if (!m_factories.contains(entry.type_name)) {
+                throw RuntimeError("No factory registered for definition type '" + entry.type_name + "' (found in " + source_label + ").");
+            }
+
+            if (auto parent_node = node["parent"]) {
+                if (!parent_node.IsScalar()) {
+                    throw RuntimeError("Definition '" + id + "' in '" + source_label + "' has a non-scalar 'parent' field.");
+                }
+                entry.parent = parent_node.as<str>();
+            }
+
+            auto data_node = node["data"];
+            if (data_node && !data_node.IsMap() && !data_node.IsNull()) {
+                throw RuntimeError("Definition '" + id + "' in '" + source_label + "' has a 'data' field that is not a mapping.");
+            }
+            entry.data = data_node && data_node.IsMap() ? data_node : YAML::Node(YAML::NodeType::Map);
+            batch.templates.emplace_back(std::move(entry));
         };
 
         if (root.IsSequence()) {
             for (const auto& entry : root) {
                 process_node(entry);
             }
-        } else if (root.IsMap()) {
+        } else if (root.IsMap() && root["type"]) {
             process_node(root);
+        } else if (root.IsMap()) {
+            for (const auto& entry : root) {
+                process_keyed(entry.first.as<str>(), entry.second);
+            }
         } else {
             throw RuntimeError("Root of '" + source_label + "' must be a mapping or sequence of mappings.");
         }
+        return batch;
     }
 
-    void DefinitionRegistry::ingest_resource(const ResourceHandle& resource, const str& source_label) {
+    DefinitionRegistry::Batch DefinitionRegistry::parse_resource(const ResourceHandle& resource, const str& source_label) const {
         if (!resource.valid()) {
             throw RuntimeError("Attempted to ingest invalid resource handle: " + source_label);
         }
 
         const auto size = resource->size();
         if (size == 0) {
-            return;
+            return Batch{source_label, {}, {}};
         }
 
         const auto* raw = static_cast<const char*>(resource->data());
@@ -107,52 +403,243 @@ namespace mloader {
         }
 
         str contents(raw, raw + size);
-        ingest_yaml(contents, source_label);
+        return parse_yaml(contents, source_label);
     }
 
     vec<str> DefinitionRegistry::types() const {
         vec<str> names;
-        names.reserve(m_definitions.size());
-        for (const auto& [type_name, _] : m_definitions) {
-            names.emplace_back(type_name);
+        for (Symbol type = 0; type < m_tables.size(); ++type) {
+            if (!m_tables[type].definitions.empty()) {
+                names.emplace_back(m_type_names.name(type));
+            }
         }
         return names;
     }
 
-    vec<const Definition*> DefinitionRegistry::definitions(const str& type_name) const {
+    vec<const Definition*> DefinitionRegistry::definitions(std::string_view type_name) const {
         vec<const Definition*> listed;
-        auto it = m_definitions.find(type_name);
-        if (it == m_definitions.end()) {
+        const Symbol type = type_symbol(type_name);
+        if (type == SymbolTable::npos || type >= m_tables.size()) {
             return listed;
         }
 
-        listed.reserve(it->second.size());
-        for (const auto& [_, definition] : it->second) {
-            listed.emplace_back(definition.get());
-        }
+        const auto& table = m_tables[type];
+        listed.assign(table.definitions.begin(), table.definitions.end());
         return listed;
     }
 
-    const Definition* DefinitionRegistry::find(const str& type_name, const str& identifier) const {
-        auto type_it = m_definitions.find(type_name);
-        if (type_it == m_definitions.end()) {
+    const Definition* DefinitionRegistry::find(std::string_view type_name, std::string_view identifier) const noexcept {
+        return find(type_symbol(type_name), id_symbol(identifier));
+    }
+
+    const Definition* DefinitionRegistry::find(Symbol type, Symbol identifier) const noexcept {
+        if (type >= m_tables.size() || identifier == SymbolTable::npos) {
             return nullptr;
         }
+        return m_tables[type].find(identifier);
+    }
 
-        const auto& bucket = type_it->second;
-        auto def_it = bucket.find(identifier);
-        if (def_it == bucket.end()) {
-            return nullptr;
+    DefinitionRegistry::Symbol DefinitionRegistry::type_symbol(std::string_view type_name) const noexcept {
+        return m_type_names.find(type_name);
+    }
+
+    DefinitionRegistry::Symbol DefinitionRegistry::id_symbol(std::string_view identifier) const noexcept {
+        return m_ids.find(identifier);
+    }
+
+    Definition* DefinitionRegistry::TypeTable::find(Symbol id) const noexcept {
+        const u32 position = index.find(symbol_hash(id), [&](u32 candidate) { return ids[candidate] == id; });
+        return position == FlatTable::npos ? nullptr : definitions[position];
+    }
+
+    void DefinitionRegistry::TypeTable::insert(Symbol id, Definition* definition, Symbol source) {
+        index.insert(symbol_hash(id), static_cast<u32>(definitions.size()), [&](u32 position) {
+            return symbol_hash(ids[position]);
+        });
+        definitions.emplace_back(definition);
+        ids.emplace_back(id);
+        sources.emplace_back(source);
+    }
+
+    u64 DefinitionRegistry::fingerprint(const vec<ResourceHandle>& sources) {
+        u64 hash = hash64(nullptr, 0, CACHE_VERSION);
+        for (const auto& source : sources) {
+            if (!source.valid()) {
+                throw RuntimeError("Attempted to fingerprint an invalid resource handle.");
+            }
+            const u64 size = source->size();
+            hash = hash64(&size, sizeof(size), hash);
+            hash = hash64(source->data(), static_cast<usize>(size), hash);
         }
+        return hash;
+    }
 
-        return def_it->second.get();
+    u64 DefinitionRegistry::fingerprint(const vec<Database::Entry>& sources) {
+        u64 hash = hash64(nullptr, 0, CACHE_VERSION);
+        for (const auto& source : sources) {
+            const str path = source.path.as_posix();
+            hash = hash64(path.data(), path.size() + 1, hash);
+            hash = hash64(&source.size, sizeof(source.size), hash);
+            hash = hash64(&source.mtime, sizeof(source.mtime), hash);
+        }
+        return hash;
+    }
+
+    vec<byte> DefinitionRegistry::save_cache(u64 fingerprint) const {
+        mtl::binary::EncodeStream stream;
+        stream.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        stream.integer<u32>(CACHE_VERSION);
+        stream.integer<u64>(fingerprint);
+
+        // Ingest order, so a warm start lists definitions like the cold one.
+        const vec<str> type_names = types();
+        stream.integer<u64>(type_names.size());
+        for (const auto& type_name : type_names) {
+            const auto listed = definitions(type_name);
+            stream.cstring(type_name);
+            stream.integer<u64>(listed.size());
+            for (const Definition* definition : listed) {
+                definition->encode(stream);
+            }
+        }
+
+        // Keyed entries keep their merged data so files ingested after a warm
+        // start can still inherit from them; sorted to keep the blob stable.
+        vec<const Template*> templates;
+        for (const auto& [type_name, bucket] : m_templates) {
+            for (const auto& [id, entry] : bucket) {
+                if (entry->linked) {
+                    templates.emplace_back(entry.get());
+                }
+            }
+        }
+        std::sort(templates.begin(), templates.end(), [](const Template* lhs, const Template* rhs) {
+            return std::tie(lhs->type_name, lhs->id) < std::tie(rhs->type_name, rhs->id);
+        });
+        stream.integer<u64>(templates.size());
+        for (const Template* entry : templates) {
+            stream.cstring(entry->type_name);
+            stream.cstring(entry->id);
+            stream.cstring(entry->parent);
+            stream.cstring(entry->source_label);
+            stream.cstring(YAML::Dump(entry->resolved));
+        }
+        return stream.finish();
+    }
+
+    void DefinitionRegistry::save_cache(const mtl::fs::Path& file_path, u64 fingerprint) const {
+        const auto blob = save_cache(fingerprint);
+        std::ofstream stream(file_path.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+        if (!stream.is_open()) {
+            throw RuntimeError("Failed to open definition cache for writing: " + file_path.string());
+        }
+        stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!stream) {
+            throw RuntimeError("Failed to write definition cache: " + file_path.string());
+        }
+    }
+
+    bool DefinitionRegistry::load_cache(const byte* data, usize size, u64 fingerprint) {
+        constexpr usize header_size = sizeof(CACHE_MAGIC) + sizeof(u32) + sizeof(u64);
+        if (!data || size < header_size) {
+            return false;
+        }
+
+        mtl::binary::DecodeStream stream(data, size);
+        char magic[sizeof(CACHE_MAGIC)];
+        stream.read(magic, sizeof(magic));
+        if (std::memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+            stream.integer<u32>() != CACHE_VERSION ||
+            stream.integer<u64>() != fingerprint) {
+            return false;
+        }
+
+        // Decode everything first so a corrupt blob cannot leave a half-filled registry.
+        vec<std::pair<str, DefinitionPtr>> decoded;
+        const auto type_count = stream.integer<u64>();
+        for (u64 t = 0; t < type_count; ++t) {
+            const str type_name = stream.cstring();
+            auto factory_it = m_factories.find(type_name);
+            if (factory_it == m_factories.end()) {
+                throw RuntimeError("No factory registered for definition type '" + type_name + "' (found in <cache>).");
+            }
+
+            const auto count = stream.integer<u64>();
+            for (u64 i = 0; i < count; ++i) {
+                auto definition = factory_it->second();
+                if (!definition) {
+                    throw RuntimeError("Factory for definition type '" + type_name + "' returned null (source: <cache>).");
+                }
+                definition->decode(stream);
+                decoded.emplace_back(type_name, std::move(definition));
+            }
+        }
+
+        vec<uptr<Template>> templates;
+        const auto template_count = stream.integer<u64>();
+        for (u64 i = 0; i < template_count; ++i) {
+            auto entry = make_uptr<Template>();
+            entry->type_name = stream.cstring();
+            entry->id = stream.cstring();
+            entry->parent = stream.cstring();
+            entry->source_label = stream.cstring();
+            const str resolved = stream.cstring();
+            try {
+                entry->resolved = YAML::Load(resolved);
+            } catch (const YAML::Exception& ex) {
+                throw RuntimeError("Failed to parse definition '" + entry->id + "' of type '" + entry->type_name + "' in <cache>: " + ex.what());
+            }
+            entry->linked = true;
+            templates.emplace_back(std::move(entry));
+        }
+
+        // Reject clashes up front as well; insert() would throw halfway through.
+        umap<str, std::unordered_set<str>> seen;
+        for (const auto& [type_name, definition] : decoded) {
+            const str& id = definition->identifier();
+            if (find(type_name, id) || !seen[type_name].emplace(id).second) {
+                throw RuntimeError("Duplicate definition '" + id + "' for type '" + type_name + "' encountered in <cache>.");
+            }
+        }
+        for (const auto& entry : templates) {
+            const auto bucket = m_templates.find(entry->type_name);
+            if (bucket != m_templates.end() && bucket->second.contains(entry->id)) {
+                throw RuntimeError("Duplicate definition '" + entry->id + "' for type '" + entry->type_name + "' encountered in <cache>.");
+            }
+        }
+        for (auto& [type_name, definition] : decoded) {
+            insert(type_name, std::move(definition), "<cache>");
+        }
+        for (auto& entry : templates) {
+            auto& bucket = m_templates[entry->type_name];
+            const str id = entry->id;
+            bucket.emplace(id, std::move(entry));
+        }
+        return true;
+    }
+
+    bool DefinitionRegistry::load_cache(const mtl::fs::Path& file_path, u64 fingerprint) {
+        if (!file_path.exists()) {
+            return false;
+        }
+
+        MappedFile mapping;
+        mapping.open(file_path);
+        return load_cache(mapping.data(), mapping.size(), fingerprint);
     }
 
     void DefinitionRegistry::clear() {
-        m_definitions.clear();
+        m_tables.clear();
+        for (auto& arena : m_arenas) {
+            if (arena) {
+                arena->clear();
+            }
+        }
+        m_templates.clear();
+        m_unlinked.clear();
     }
 
-    void DefinitionRegistry::ingest_node(const str& type_name, const YAML::Node& node, const str& source_label) {
+    DefinitionRegistry::DefinitionPtr DefinitionRegistry::build_node(const str& type_name, const YAML::Node& node, const str& source_label) const {
         auto factory_it = m_factories.find(type_name);
         if (factory_it == m_factories.end()) {
             throw RuntimeError("No factory registered for definition type '" + type_name + "' (found in " + source_label + ").");
@@ -173,13 +660,144 @@ namespace mloader {
         if (id.empty()) {
             throw RuntimeError("Definition of type '" + type_name + "' in " + source_label + " produced an empty identifier.");
         }
+        return definition;
+    }
+
+    void DefinitionRegistry::insert(const str& type_name, DefinitionPtr definition, const str& source_label) {
+        const str& id = definition->identifier();
+        const Symbol type = m_type_names.intern(type_name);
+        if (type >= m_tables.size()) {
+            m_tables.resize(type + 1);
+        }
 
-        auto& bucket = m_definitions[type_name];
-        if (bucket.contains(id)) {
+        auto& table = m_tables[type];
+        const Symbol symbol = m_ids.intern(id);
+        if (table.contains(symbol)) {
             throw RuntimeError("Duplicate definition '" + id + "' for type '" + type_name + "' encountered in " + source_label + ".");
         }
 
-        bucket.emplace(id, std::move(definition));
+        // Typed registrations move the definition into their arena; the
+        // factory-made original is released when `definition` goes out of scope.
+        DefinitionArena* arena = type < m_arenas.size() ? m_arenas[type].get() : nullptr;
+        Definition* stored = arena ? arena->adopt(*definition) : table.owned.emplace_back(std::move(definition)).get();
+        table.insert(symbol, stored, m_sources.intern(source_label));
+    }
+
+    void DefinitionRegistry::erase(Symbol type, const vec<u8>& drop) {
+        TypeTable& table = m_tables[type];
+        DefinitionArena* arena = type < m_arenas.size() ? m_arenas[type].get() : nullptr;
+
+        // Arena entries and untyped ownership both follow ingest order, as does `drop`.
+        TypeTable rebuilt;
+        vec<Definition*> survivors;
+        if (arena) {
+            survivors = arena->erase(drop);
+        } else {
+            for (usize i = 0; i < table.owned.size(); ++i) {
+                if (!drop[i]) {
+                    survivors.emplace_back(table.owned[i].get());
+                    rebuilt.owned.emplace_back(std::move(table.owned[i]));
+                }
+            }
+        }
+
+        usize next = 0;
+        for (usize i = 0; i < drop.size(); ++i) {
+            if (!drop[i]) {
+                Definition* definition = survivors[next++];
+                rebuilt.insert(m_ids.find(definition->identifier()), definition, table.sources[i]);
+            }
+        }
+        table = std::move(rebuilt);
+    }
+
+    DefinitionRegistry::Template& DefinitionRegistry::add_template(Template&& entry) {
+        auto& bucket = m_templates[entry.type_name];
+        if (bucket.contains(entry.id) || find(entry.type_name, entry.id)) {
+            throw RuntimeError("Duplicate definition '" + entry.id + "' for type '" + entry.type_name + "' encountered in " + entry.source_label + ".");
+        }
+
+        auto& slot = bucket[entry.id];
+        slot = make_uptr<Template>(std::move(entry));
+        m_unlinked.emplace_back(slot.get());
+        return *slot;
+    }
+
+    void DefinitionRegistry::link() {
+        vec<Template*> pending;
+        pending.swap(m_unlinked);
+
+        // Resolve every entry first (parents are merged once and cached on
+        // their template), then build in ingest order so duplicate errors
+        // match the order the entries were read in.
+        usize built = 0;
+        try {
+            for (Template* entry : pending) {
+                resolve_template(*entry);
+            }
+            for (; built < pending.size(); ++built) {
+                Template* entry = pending[built];
+                insert(entry->type_name, build_node(entry->type_name, entry->resolved, entry->source_label), entry->source_label);
+            }
+        } catch (...) {
+            // Entries that were not built would otherwise keep their ids
+            // taken without ever producing a definition; drop them so a
+            // corrected ingest can add them again.
+            for (usize i = built; i < pending.size(); ++i) {
+                const str type_name = pending[i]->type_name;
+                const str id = pending[i]->id;
+                m_templates[type_name].erase(id);
+            }
+            throw;
+        }
+    }
+
+    const YAML::Node& DefinitionRegistry::resolve_template(Template& entry) {
+        // Walk up to the nearest linked ancestor (or a root), then merge back
+        // down; each template on the way is linked exactly once.
+        vec<Template*> chain;
+        auto fail = [&](const str& message) {
+            for (Template* visited : chain) {
+                visited->visiting = false;
+            }
+            throw RuntimeError(message);
+        };
+
+        Template* current = &entry;
+        while (!current->linked) {
+            if (current->visiting) {
+                str cycle = current->id;
+                for (auto it = chain.rbegin(); it != chain.rend() && *it != current; ++it) {
+                    cycle = (*it)->id + " -> " + cycle;
+                }
+                fail("Definition inheritance cycle for type '" + current->type_name + "': " + current->id + " -> " + cycle + ".");
+            }
+            current->visiting = true;
+            chain.emplace_back(current);
+            if (current->parent.empty()) {
+                break;
+            }
+
+            const auto& bucket = m_templates[current->type_name];
+            auto parent_it = bucket.find(current->parent);
+            if (parent_it == bucket.end()) {
+                fail("Definition '" + current->id + "' of type '" + current->type_name + "' in " + current->source_label +
+                     " references unknown parent '" + current->parent + "'.");
+            }
+            current = parent_it->second.get();
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            Template& link = **it;
+            const YAML::Node base = link.parent.empty()
+                                        ? YAML::Node(YAML::NodeType::Map)
+                                        : m_templates[link.type_name].at(link.parent)->resolved;
+            link.resolved = merge_nodes(base, link.data);
+            link.resolved["id"] = link.id;
+            link.linked = true;
+            link.visiting = false;
+        }
+        return entry.resolved;
     }
 
 } // namespace mloader
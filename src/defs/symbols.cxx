@@ -0,0 +1,41 @@
+#include "mloader/defs/symbols.hxx"
+
+#include "mtl/error.hxx"
+
+#include "mloader/hash.hxx"
+
+using namespace mloader;
+
+SymbolTable::Symbol SymbolTable::intern(std::string_view name) {
+    const u64 hash = hash64(name.data(), name.size());
+    const Symbol existing = m_table.find(hash, [&](Symbol symbol) { return m_names[symbol] == name; });
+    if (existing != npos) {
+        return existing;
+    }
+
+    if (m_names.size() >= npos - 1) {
+        throw RuntimeError("SymbolTable exceeds 32-bit handle limits.");
+    }
+    const auto symbol = static_cast<Symbol>(m_names.size());
+    m_names.emplace_back(name);
+    m_table.insert(hash, symbol, [&](Symbol stored) {
+        return hash64(m_names[stored].data(), m_names[stored].size());
+    });
+    return symbol;
+}
+
+SymbolTable::Symbol SymbolTable::find(std::string_view name) const noexcept {
+    return m_table.find(hash64(name.data(), name.size()), [&](Symbol symbol) { return m_names[symbol] == name; });
+}
+
+std::string_view SymbolTable::name(Symbol symbol) const {
+    if (symbol >= m_names.size()) {
+        throw RuntimeError("Unknown symbol handle: " + std::to_string(symbol));
+    }
+    return m_names[symbol];
+}
+
+void SymbolTable::clear() {
+    m_names.clear();
+    m_table.clear();
+}
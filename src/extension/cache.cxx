@@ -0,0 +1,141 @@
+#include "mloader/extension/cache.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <unordered_set>
+
+#include "mtl/error.hxx"
+#include "mtl/binary/binary.hxx"
+
+#include "mloader/extension/archive/decoder.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/mapping.hxx"
+
+namespace mloader::extension {
+    namespace {
+        constexpr char CACHE_MAGIC[4] = {'M', 'L', 'X', 'C'};
+        constexpr u32 CACHE_VERSION = 1;
+    } // namespace
+
+    const Extension* ExtensionCache::find(std::string_view path, u64 size, i64 mtime) const {
+        auto it = m_entries.find(str(path));
+        if (it == m_entries.end() || it->second.size != size || it->second.mtime != mtime) {
+            return nullptr;
+        }
+        return &it->second.info;
+    }
+
+    void ExtensionCache::store(std::string_view path, u64 size, i64 mtime, const Extension& info) {
+        m_entries.insert_or_assign(str(path), Entry{size, mtime, info});
+    }
+
+    void ExtensionCache::retain(const vec<str>& paths) {
+        const std::unordered_set<std::string_view> keep(paths.begin(), paths.end());
+        std::erase_if(m_entries, [&keep](const auto& item) {
+            return !keep.contains(item.first);
+        });
+    }
+
+    void ExtensionCache::clear() noexcept {
+        m_entries.clear();
+    }
+
+    vec<byte> ExtensionCache::encode() const {
+        mtl::binary::EncodeStream stream;
+        stream.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        stream.integer<u32>(CACHE_VERSION);
+
+        // Sorted so the same entries always produce the same blob.
+        vec<const std::pair<const str, Entry>*> sorted;
+        sorted.reserve(m_entries.size());
+        for (const auto& item : m_entries) {
+            sorted.emplace_back(&item);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->first < rhs->first;
+        });
+
+        stream.integer<u64>(sorted.size());
+        for (const auto* item : sorted) {
+            // Metadata is stored in the archive header layout, checksums left zero.
+            ArchiveEncoder header{};
+            header.extension = item->second.info;
+            const vec<byte> encoded = header.encode_header();
+
+            stream.cstring(item->first);
+            stream.integer<u64>(item->second.size);
+            stream.integer<i64>(item->second.mtime);
+            stream.integer<u64>(encoded.size());
+            stream.write(encoded.data(), encoded.size());
+        }
+        return stream.finish();
+    }
+
+    bool ExtensionCache::decode(const byte* data, usize size) {
+        m_entries.clear();
+        constexpr usize header_size = sizeof(CACHE_MAGIC) + sizeof(u32);
+        if (!data || size < header_size) {
+            return false;
+        }
+
+        try {
+            mtl::binary::DecodeStream stream(data, size);
+            char magic[sizeof(CACHE_MAGIC)];
+            stream.read(magic, sizeof(magic));
+            if (std::memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || stream.integer<u32>() != CACHE_VERSION) {
+                return false;
+            }
+
+            umap<str, Entry> entries;
+            const auto count = stream.integer<u64>();
+            vec<byte> encoded;
+            for (u64 i = 0; i < count; ++i) {
+                str path = stream.cstring();
+                Entry entry;
+                entry.size = stream.integer<u64>();
+                entry.mtime = stream.integer<i64>();
+                const auto encoded_size = stream.integer<u64>();
+                if (encoded_size > size) {
+                    return false;
+                }
+                encoded.resize(static_cast<usize>(encoded_size));
+                stream.read(encoded.data(), encoded.size());
+
+                ArchiveDecoder header;
+                header.decode_header(encoded);
+                entry.info = std::move(header.extension);
+                entries.insert_or_assign(std::move(path), std::move(entry));
+            }
+            m_entries = std::move(entries);
+        } catch (const std::exception&) {
+            // A cache is only an accelerator; a damaged one is dropped.
+            return false;
+        }
+        return true;
+    }
+
+    void ExtensionCache::save(const mtl::fs::Path& file) const {
+        const auto blob = encode();
+        std::ofstream stream(file.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+        if (!stream.is_open()) {
+            throw RuntimeError("Failed to open extension cache for writing: " + file.string());
+        }
+        stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!stream) {
+            throw RuntimeError("Failed to write extension cache: " + file.string());
+        }
+    }
+
+    bool ExtensionCache::load(const mtl::fs::Path& file) {
+        m_entries.clear();
+        if (!file.exists() || !file.is_file()) {
+            return false;
+        }
+
+        MappedFile mapping;
+        mapping.open(file);
+        return decode(mapping.data(), mapping.size());
+    }
+}
@@ -0,0 +1,138 @@
+#include "mloader/extension/archive/packer.hxx"
+
+#include <deque>
+#include <future>
+
+#include <yaml-cpp/yaml.h>
+
+#include "mtl/error.hxx"
+#include "mtl/version.hxx"
+
+#include "mloader/database/file.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/extension/archive/writer.hxx"
+#include "mloader/hash.hxx"
+#include "mloader/lz.hxx"
+#include "mloader/worker.hxx"
+
+namespace mloader::extension {
+    namespace {
+
+        /// File contents read and hashed by a worker, waiting to be written in order.
+        struct Packed {
+            ResourceHandle handle;
+            u64 hash = 0;
+            /// compress_lz() output; empty when the file is stored as is.
+            vec<byte> compressed;
+        };
+
+        /// Entries must shrink by at least 1/16 to be worth decoding on every resolve.
+        bool worth_compressing(u64 size, u64 packed_size) {
+            return packed_size > 0 && packed_size <= size - size / 16;
+        }
+
+        Extension read_extension(FilesystemDatabase& db, const PackOptions& options) {
+            Extension extension{};
+            const FilesystemDatabase::PurePath config(options.config);
+            if (!options.config.empty() && db.is_file(config)) {
+                auto handle = db.resolve(config);
+                const auto* raw = static_cast<const char*>(handle->data());
+                const str contents(raw, raw + handle->size());
+                YAML::Node node;
+                try {
+                    node = YAML::Load(contents);
+                } catch (const YAML::Exception& ex) {
+                    throw RuntimeError("Failed to parse extension config '" + options.config + "': " + ex.what());
+                }
+                if (node && node.IsMap()) {
+                    extension = Extension{}.from_config(node);
+                }
+            }
+
+            if (!options.name.empty()) {
+                extension.name = options.name;
+            }
+            if (!options.version_text.empty()) {
+                extension.version = version::from_string(options.version_text);
+            }
+            if (extension.name.empty()) {
+                throw RuntimeError("Extension name is missing; pass --name or provide '" + options.config + "'.");
+            }
+            return extension;
+        }
+
+    } // namespace
+
+    PackSummary pack_directory(const PackOptions& options) {
+        FilesystemDatabase db{options.source};
+        db.load();
+
+        ArchiveEncoder header{};
+        header.extension = read_extension(db, options);
+
+        ArchiveWriter writer(options.output, header);
+        WorkerPool pool(options.jobs);
+
+        vec<FilesystemDatabase::PurePath> files;
+        for (const auto& entry : db.list()) {
+            if (entry.is_file()) {
+                files.emplace_back(entry.path);
+            } else {
+                writer.add_dir(entry.path.as_posix());
+            }
+        }
+
+        // Reads, hashes and compression run ahead on the pool, bounded by
+        // `window` so only a handful of payloads are resident; the writer
+        // consumes them in order.
+        const usize window = options.window ? options.window : pool.size() * 4;
+        std::deque<std::future<Packed>> inflight;
+        usize next = 0;
+        auto enqueue = [&] {
+            const auto path = files[next++];
+            inflight.emplace_back(pool.submit([&db, &options, path] {
+                Packed packed;
+                packed.handle = db.resolve(path);
+                const auto* data = static_cast<const byte*>(packed.handle->data());
+                const auto size = static_cast<usize>(packed.handle->size());
+                packed.hash = hash64(data, size);
+                if (options.compress) {
+                    packed.compressed = compress_lz({data, size});
+                    if (!worth_compressing(size, packed.compressed.size())) {
+                        packed.compressed = {};
+                    }
+                }
+                return packed;
+            }));
+        };
+
+        while (next < files.size() && inflight.size() < window) {
+            enqueue();
+        }
+
+        PackSummary summary;
+        while (!inflight.empty()) {
+            Packed packed = inflight.front().get();
+            inflight.pop_front();
+            if (next < files.size()) {
+                enqueue();
+            }
+
+            const auto path = files[summary.files++].as_posix();
+            const auto* data = static_cast<const byte*>(packed.handle->data());
+            if (packed.compressed.empty()) {
+                writer.add_file(path, data, packed.handle->size(), packed.hash);
+            } else {
+                writer.add_compressed(path, packed.compressed.data(), packed.compressed.size(), packed.handle->size(), packed.hash);
+                ++summary.compressed;
+                summary.saved += packed.handle->size() - packed.compressed.size();
+            }
+        }
+
+        summary.bytes = writer.finish();
+        summary.entries = writer.count();
+        summary.workers = pool.size();
+        return summary;
+    }
+
+} // namespace mloader::extension
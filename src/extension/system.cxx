@@ -0,0 +1,331 @@
+#include "mloader/extension/system.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#include <unordered_set>
+
+#include "mtl/error.hxx"
+
+#include "mloader/database/binary.hxx"
+#include "mloader/database/file.hxx"
+#include "mloader/extension/archive/decoder.hxx"
+
+namespace mloader::extension {
+    namespace {
+        bool ends_with(std::string_view text, std::string_view suffix) {
+            return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+        }
+
+        [[noreturn]] void report(const str& heading, const vec<str>& problems) {
+            str message = heading;
+            for (const auto& problem : problems) {
+                message += "\n  - " + problem;
+            }
+            throw RuntimeError(message);
+        }
+
+        /// Candidate found by scan(), with the stats the metadata cache is keyed on.
+        struct Candidate {
+            Path source;
+            bool unpacked = false;
+            u64 size = 0;
+            i64 mtime = 0;
+        };
+
+        bool stat_file(const std::filesystem::path& path, u64& size, i64& mtime) {
+            std::error_code ec;
+            const std::filesystem::directory_entry entry(path, ec);
+            if (ec || !entry.is_regular_file(ec)) {
+                return false;
+            }
+            size = entry.file_size(ec);
+            mtime = static_cast<i64>(std::chrono::duration_cast<std::chrono::nanoseconds>(entry.last_write_time(ec).time_since_epoch()).count());
+            return !ec;
+        }
+
+        uptr<ExtensionSystem::Installed> read_extension(const Candidate& candidate, const Extension* cached) {
+            auto installed = make_uptr<ExtensionSystem::Installed>();
+            installed->source = candidate.source;
+            if (cached) {
+                installed->info = *cached;
+            } else if (candidate.unpacked) {
+                installed->info = Extension{}.from_config(YAML::LoadFile((candidate.source / EXTENSION_CONFIG).string()));
+            } else {
+                ArchiveDecoder header;
+                header.probe_header(candidate.source);
+                installed->info = std::move(header.extension);
+            }
+
+            if (candidate.unpacked) {
+                installed->db = make_uptr<FilesystemDatabase>(candidate.source);
+            } else {
+                installed->db = make_uptr<BinaryDatabase>(candidate.source);
+            }
+            if (installed->info.name.empty()) {
+                throw RuntimeError("extension has no name");
+            }
+            return installed;
+        }
+
+        vec<Database::PurePath> definition_files(Database& db, const Extension::PurePath& root) {
+            vec<Database::PurePath> files;
+            if (root.as_posix().empty() || !db.is_dir(root)) {
+                return files;
+            }
+            db.each(root, [&](const Database::Entry& entry) {
+                const str path = entry.path.as_posix();
+                if (entry.is_file() && (ends_with(path, ".yml") || ends_with(path, ".yaml"))) {
+                    files.emplace_back(entry.path);
+                }
+            });
+            return files;
+        }
+    } // namespace
+
+    ExtensionSystem::ExtensionSystem(Path data_root) {
+        add_location(data_root);
+    }
+
+    ExtensionSystem::~ExtensionSystem() = default;
+
+    void ExtensionSystem::add_location(const Path& location) {
+        if (std::find(m_locations.begin(), m_locations.end(), location) == m_locations.end()) {
+            m_locations.emplace_back(location);
+        }
+    }
+
+    void ExtensionSystem::remove_location(const Path& location) {
+        m_locations.erase(std::remove(m_locations.begin(), m_locations.end(), location), m_locations.end());
+    }
+
+    const vec<Path>& ExtensionSystem::locations() {
+        return m_locations;
+    }
+
+    const ExtensionSystem::Installed* ExtensionSystem::find(std::string_view name) const {
+        for (const auto& installed : m_extensions) {
+            if (installed->info.name == name) {
+                return installed.get();
+            }
+        }
+        return nullptr;
+    }
+
+    void ExtensionSystem::unmount_all() {
+        m_content.unload();
+        while (!m_content.mounts().empty()) {
+            m_content.unmount(*m_content.mounts().back().db);
+        }
+    }
+
+    void ExtensionSystem::scan() {
+        vec<Candidate> candidates;
+        for (const auto& location : m_locations) {
+            std::error_code ec;
+            std::filesystem::directory_iterator it(std::filesystem::path(location.string()), ec);
+            for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+                Candidate candidate;
+                candidate.source = Path(it->path().string());
+                std::error_code kind_ec;
+                if (it->is_regular_file(kind_ec) && ends_with(candidate.source.name(), EXTENSION_ARCHIVE_SUFFIX)) {
+                    stat_file(it->path(), candidate.size, candidate.mtime);
+                    candidates.emplace_back(std::move(candidate));
+                } else if (it->is_directory(kind_ec) && stat_file(it->path() / EXTENSION_CONFIG, candidate.size, candidate.mtime)) {
+                    candidate.unpacked = true;
+                    candidates.emplace_back(std::move(candidate));
+                }
+            }
+        }
+        // Directory order is unspecified; keep scans reproducible.
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+            return lhs.source.string() < rhs.source.string();
+        });
+
+        vec<uptr<Installed>> found(candidates.size());
+        vec<str> errors(candidates.size());
+        vec<u8> probed(candidates.size(), 0);
+        WorkerPool::shared().parallel(candidates.size(), [&](usize i) {
+            const Candidate& candidate = candidates[i];
+            try {
+                const Extension* cached = m_cache.find(candidate.source.string(), candidate.size, candidate.mtime);
+                found[i] = read_extension(candidate, cached);
+                probed[i] = cached == nullptr;
+            } catch (const std::exception& ex) {
+                errors[i] = "'" + candidate.source.string() + "': " + ex.what();
+            }
+        });
+
+        vec<str> problems;
+        for (auto& error : errors) {
+            if (!error.empty()) {
+                problems.emplace_back(std::move(error));
+            }
+        }
+        if (!problems.empty()) {
+            report("Cannot read extensions:", problems);
+        }
+
+        vec<str> seen;
+        seen.reserve(candidates.size());
+        for (usize i = 0; i < candidates.size(); ++i) {
+            seen.emplace_back(candidates[i].source.string());
+            if (probed[i]) {
+                m_cache.store(seen.back(), candidates[i].size, candidates[i].mtime, found[i]->info);
+            }
+        }
+        m_cache.retain(seen);
+
+        unmount_all();
+        m_extensions = std::move(found);
+    }
+
+    vec<vec<usize>> ExtensionSystem::solve() const {
+        const usize count = m_extensions.size();
+        vec<str> problems;
+
+        umap<str, usize> by_name;
+        for (usize i = 0; i < count; ++i) {
+            const auto [it, inserted] = by_name.emplace(m_extensions[i]->info.name, i);
+            if (!inserted) {
+                problems.emplace_back("Extension '" + it->first + "' is installed twice: '" + m_extensions[it->second]->source.string() +
+                                      "' and '" + m_extensions[i]->source.string() + "'.");
+            }
+        }
+
+        vec<vec<usize>> dependents(count);
+        vec<usize> pending(count, 0);
+        std::unordered_set<str> clashes;
+        for (usize i = 0; i < count; ++i) {
+            const Extension& info = m_extensions[i]->info;
+            auto depend = [&](usize dependency) {
+                dependents[dependency].emplace_back(i);
+                ++pending[i];
+            };
+
+            for (const auto& name : info.dependencies) {
+                auto it = by_name.find(name);
+                if (it == by_name.end()) {
+                    problems.emplace_back("Extension '" + info.name + "' requires '" + name + "', which is not installed.");
+                } else {
+                    depend(it->second);
+                }
+            }
+            for (const auto& name : info.optional) {
+                if (auto it = by_name.find(name); it != by_name.end()) {
+                    depend(it->second);
+                }
+            }
+            for (const auto& name : info.incompatible) {
+                if (!by_name.contains(name)) {
+                    continue;
+                }
+                // Report each pair once, even when both sides declare it.
+                const str key = std::min(info.name, name) + '\n' + std::max(info.name, name);
+                if (clashes.insert(key).second) {
+                    problems.emplace_back("Extension '" + info.name + "' is incompatible with '" + name + "'; remove one of them.");
+                }
+            }
+        }
+        if (!problems.empty()) {
+            report("Cannot load extensions:", problems);
+        }
+
+        auto by_extension_name = [this](usize lhs, usize rhs) {
+            return m_extensions[lhs]->info.name < m_extensions[rhs]->info.name;
+        };
+
+        vec<vec<usize>> frontiers;
+        vec<usize> frontier;
+        for (usize i = 0; i < count; ++i) {
+            if (pending[i] == 0) {
+                frontier.emplace_back(i);
+            }
+        }
+        usize ordered = 0;
+        while (!frontier.empty()) {
+            std::sort(frontier.begin(), frontier.end(), by_extension_name);
+            vec<usize> next;
+            for (usize i : frontier) {
+                for (usize dependent : dependents[i]) {
+                    if (--pending[dependent] == 0) {
+                        next.emplace_back(dependent);
+                    }
+                }
+            }
+            ordered += frontier.size();
+            frontiers.emplace_back(std::move(frontier));
+            frontier = std::move(next);
+        }
+
+        if (ordered < count) {
+            // Every extension left waits on another one left, so following
+            // waiting dependencies from any of them must run into a cycle.
+            vec<vec<usize>> waits_on(count);
+            for (usize i = 0; i < count; ++i) {
+                for (usize dependent : dependents[i]) {
+                    if (pending[i] > 0 && pending[dependent] > 0) {
+                        waits_on[dependent].emplace_back(i);
+                    }
+                }
+            }
+
+            usize at = 0;
+            while (pending[at] == 0) {
+                ++at;
+            }
+            vec<usize> seen(count, count);
+            vec<usize> path;
+            while (seen[at] == count) {
+                seen[at] = path.size();
+                path.emplace_back(at);
+                at = waits_on[at].front();
+            }
+
+            str cycle;
+            for (usize i = seen[at]; i < path.size(); ++i) {
+                cycle += m_extensions[path[i]]->info.name + " -> ";
+            }
+            cycle += m_extensions[at]->info.name;
+            report("Cannot load extensions:", {"Dependency cycle: " + cycle + "."});
+        }
+        return frontiers;
+    }
+
+    void ExtensionSystem::load(DefinitionRegistry& registry, WorkerPool& pool) {
+        const auto frontiers = solve();
+        unmount_all();
+
+        for (const auto& frontier : frontiers) {
+            vec<vec<ResourceHandle>> definitions(frontier.size());
+            pool.parallel(frontier.size(), [&](usize i) {
+                Installed& installed = *m_extensions[frontier[i]];
+                try {
+                    installed.db->load();
+                    definitions[i] = installed.db->resolve(definition_files(*installed.db, installed.info.definitions));
+                } catch (const std::exception& ex) {
+                    throw RuntimeError("Failed to load extension '" + installed.info.name + "': " + ex.what());
+                }
+            });
+
+            // One ingest per frontier: files of independent extensions are
+            // parsed together, and merged in name order.
+            vec<ResourceHandle> batch;
+            for (auto& handles : definitions) {
+                for (auto& handle : handles) {
+                    batch.emplace_back(std::move(handle));
+                }
+            }
+            registry.ingest(batch, pool);
+        }
+
+        // Later mounts win ties, so dependents override their dependencies.
+        for (const auto& frontier : frontiers) {
+            for (usize i : frontier) {
+                m_content.mount(*m_extensions[i]->db);
+            }
+        }
+        m_content.load();
+    }
+}
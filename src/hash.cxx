@@ -0,0 +1,111 @@
+#include "mloader/hash.hxx"
+
+#include <bit>
+#include <cstring>
+
+using namespace mloader;
+
+namespace {
+
+    constexpr u64 PRIME1 = 0x9E3779B185EBCA87ULL;
+    constexpr u64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr u64 PRIME3 = 0x165667B19E3779F9ULL;
+    constexpr u64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr u64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    inline u64 rotl(u64 value, int bits) noexcept {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // xxHash64 reads its input as little-endian words; big-endian targets
+    // assemble them byte by byte so the hash matches everywhere.
+    inline u64 load64(const byte* p) noexcept {
+        if constexpr (std::endian::native == std::endian::little) {
+            u64 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        } else {
+            u64 value = 0;
+            for (int i = 7; i >= 0; --i) {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+    }
+
+    inline u32 load32(const byte* p) noexcept {
+        if constexpr (std::endian::native == std::endian::little) {
+            u32 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        } else {
+            return u32(p[0]) | u32(p[1]) << 8 | u32(p[2]) << 16 | u32(p[3]) << 24;
+        }
+    }
+
+    inline u64 round(u64 acc, u64 input) noexcept {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    inline u64 merge(u64 acc, u64 value) noexcept {
+        acc ^= round(0, value);
+        return acc * PRIME1 + PRIME4;
+    }
+
+} // namespace
+
+u64 mloader::hash64(const void* data, usize size, u64 seed) noexcept {
+    const auto* p = static_cast<const byte*>(data);
+    const byte* const end = p + size;
+    u64 h;
+
+    if (size >= 32) {
+        u64 v1 = seed + PRIME1 + PRIME2;
+        u64 v2 = seed + PRIME2;
+        u64 v3 = seed;
+        u64 v4 = seed - PRIME1;
+        const byte* const limit = end - 32;
+        do {
+            v1 = round(v1, load64(p));
+            v2 = round(v2, load64(p + 8));
+            v3 = round(v3, load64(p + 16));
+            v4 = round(v4, load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+
+    h += static_cast<u64>(size);
+
+    while (p + 8 <= end) {
+        h ^= round(0, load64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<u64>(load32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= static_cast<u64>(*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
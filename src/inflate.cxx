@@ -0,0 +1,314 @@
+#include "mloader/inflate.hxx"
+
+#include <array>
+#include <cstring>
+
+#include "mtl/error.hxx"
+
+namespace mloader {
+
+    namespace {
+
+        constexpr u32 MAX_BITS = 15;
+        /// Codes up to this length decode with a single table lookup.
+        constexpr u32 FAST_BITS = 9;
+
+        constexpr u16 LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                         31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr u8 LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                         2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr u16 DIST_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                       193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr u8 DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        constexpr u8 CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        [[noreturn]] void corrupt(const char* what) {
+            throw RuntimeError(str("Corrupt DEFLATE stream: ") + what + ".");
+        }
+
+        /// LSB-first bit reader over the compressed input.
+        struct BitReader {
+            const byte* data;
+            usize size;
+            usize pos = 0;
+            u64 bits = 0;
+            u32 count = 0;
+
+            /// Loads as many whole bytes as fit; never fails.
+            void fill() noexcept {
+                while (count <= 56 && pos < size) {
+                    bits |= static_cast<u64>(data[pos++]) << count;
+                    count += 8;
+                }
+            }
+
+            u32 take(u32 n) {
+                if (count < n) {
+                    fill();
+                    if (count < n) {
+                        corrupt("input ends inside a block");
+                    }
+                }
+                const u32 value = static_cast<u32>(bits & ((u64{1} << n) - 1));
+                bits >>= n;
+                count -= n;
+                return value;
+            }
+
+            void align() noexcept {
+                bits >>= count % 8;
+                count -= count % 8;
+            }
+        };
+
+        /**
+         * Canonical Huffman decoder: a FAST_BITS lookup table for short codes
+         * and the counts/symbols form (as in zlib's puff) for the rest.
+         */
+        struct Huffman {
+            /// symbol | length << 9; zero marks codes longer than FAST_BITS.
+            std::array<u16, 1u << FAST_BITS> fast{};
+            std::array<u16, MAX_BITS + 1> counts{};
+            std::array<u16, 288> symbols{};
+
+            void build(const u8* lengths, u32 n) {
+                fast.fill(0);
+                counts.fill(0);
+                for (u32 i = 0; i < n; ++i) {
+                    ++counts[lengths[i]];
+                }
+                counts[0] = 0;
+
+                i32 left = 1;
+                for (u32 len = 1; len <= MAX_BITS; ++len) {
+                    left = (left << 1) - counts[len];
+                    if (left < 0) {
+                        corrupt("over-subscribed code lengths");
+                    }
+                }
+
+                // First symbol slot and first canonical code of every length.
+                std::array<u16, MAX_BITS + 2> offsets{};
+                std::array<u32, MAX_BITS + 1> next{};
+                u32 code = 0;
+                for (u32 len = 1; len <= MAX_BITS; ++len) {
+                    offsets[len + 1] = static_cast<u16>(offsets[len] + counts[len]);
+                    next[len] = code;
+                    code = (code + counts[len]) << 1;
+                }
+
+                for (u32 symbol = 0; symbol < n; ++symbol) {
+                    const u32 len = lengths[symbol];
+                    if (len == 0) {
+                        continue;
+                    }
+                    symbols[offsets[len]++] = static_cast<u16>(symbol);
+
+                    const u32 assigned = next[len]++;
+                    if (len <= FAST_BITS) {
+                        // Codes are stored MSB first, the stream is read LSB first.
+                        u32 reversed = 0;
+                        for (u32 b = 0; b < len; ++b) {
+                            reversed |= ((assigned >> b) & 1u) << (len - 1 - b);
+                        }
+                        for (u32 i = reversed; i < fast.size(); i += 1u << len) {
+                            fast[i] = static_cast<u16>(symbol | len << 9);
+                        }
+                    }
+                }
+            }
+
+            u32 decode(BitReader& in) const {
+                in.fill();
+                if (in.count >= FAST_BITS) {
+                    const u16 entry = fast[in.bits & ((1u << FAST_BITS) - 1)];
+                    if (entry != 0) {
+                        const u32 len = entry >> 9;
+                        in.bits >>= len;
+                        in.count -= len;
+                        return entry & 0x1FFu;
+                    }
+                }
+
+                i32 code = 0;
+                i32 first = 0;
+                i32 index = 0;
+                for (u32 len = 1; len <= MAX_BITS; ++len) {
+                    code |= static_cast<i32>(in.take(1));
+                    const i32 count = counts[len];
+                    if (code - count < first) {
+                        return symbols[static_cast<usize>(index + (code - first))];
+                    }
+                    index += count;
+                    first = (first + count) << 1;
+                    code <<= 1;
+                }
+                corrupt("invalid Huffman code");
+            }
+        };
+
+        struct FixedTables {
+            Huffman literals;
+            Huffman distances;
+
+            FixedTables() {
+                u8 lengths[288];
+                std::memset(lengths, 8, 144);
+                std::memset(lengths + 144, 9, 112);
+                std::memset(lengths + 256, 7, 24);
+                std::memset(lengths + 280, 8, 8);
+                literals.build(lengths, 288);
+                std::memset(lengths, 5, 30);
+                distances.build(lengths, 30);
+            }
+        };
+
+        void read_dynamic(BitReader& in, Huffman& literals, Huffman& distances) {
+            const u32 nlen = in.take(5) + 257;
+            const u32 ndist = in.take(5) + 1;
+            const u32 ncode = in.take(4) + 4;
+            if (nlen > 286 || ndist > 30) {
+                corrupt("too many length or distance codes");
+            }
+
+            u8 lengths[288 + 32]{};
+            for (u32 i = 0; i < ncode; ++i) {
+                lengths[CODE_LENGTH_ORDER[i]] = static_cast<u8>(in.take(3));
+            }
+            Huffman code_lengths;
+            code_lengths.build(lengths, 19);
+
+            u8 all[288 + 32]{};
+            for (u32 i = 0; i < nlen + ndist;) {
+                const u32 symbol = code_lengths.decode(in);
+                if (symbol < 16) {
+                    all[i++] = static_cast<u8>(symbol);
+                    continue;
+                }
+
+                u8 repeat_value = 0;
+                u32 repeat = 0;
+                if (symbol == 16) {
+                    if (i == 0) {
+                        corrupt("repeat with no previous length");
+                    }
+                    repeat_value = all[i - 1];
+                    repeat = 3 + in.take(2);
+                } else if (symbol == 17) {
+                    repeat = 3 + in.take(3);
+                } else {
+                    repeat = 11 + in.take(7);
+                }
+                if (i + repeat > nlen + ndist) {
+                    corrupt("code lengths overflow");
+                }
+                std::memset(all + i, repeat_value, repeat);
+                i += repeat;
+            }
+
+            if (all[256] == 0) {
+                corrupt("missing end-of-block code");
+            }
+            literals.build(all, nlen);
+            distances.build(all + nlen, ndist);
+        }
+
+        void inflate_block(BitReader& in, const Huffman& literals, const Huffman& distances, std::span<byte> output, usize& out) {
+            while (true) {
+                const u32 symbol = literals.decode(in);
+                if (symbol < 256) {
+                    if (out >= output.size()) {
+                        corrupt("output exceeds the declared size");
+                    }
+                    output[out++] = static_cast<byte>(symbol);
+                    continue;
+                }
+                if (symbol == 256) {
+                    return;
+                }
+
+                const u32 length_code = symbol - 257;
+                if (length_code >= 29) {
+                    corrupt("invalid length code");
+                }
+                const usize length = LENGTH_BASE[length_code] + in.take(LENGTH_EXTRA[length_code]);
+
+                const u32 dist_code = distances.decode(in);
+                if (dist_code >= 30) {
+                    corrupt("invalid distance code");
+                }
+                const usize distance = DIST_BASE[dist_code] + in.take(DIST_EXTRA[dist_code]);
+                if (distance > out) {
+                    corrupt("distance reaches before the output start");
+                }
+                if (length > output.size() - out) {
+                    corrupt("output exceeds the declared size");
+                }
+
+                // Byte by byte: the source may overlap the bytes being written.
+                byte* target = output.data() + out;
+                const byte* source = target - distance;
+                for (usize i = 0; i < length; ++i) {
+                    target[i] = source[i];
+                }
+                out += length;
+            }
+        }
+
+    } // namespace
+
+    void inflate(std::span<const byte> input, std::span<byte> output) {
+        static const FixedTables fixed;
+
+        BitReader in{input.data(), input.size()};
+        Huffman literals;
+        Huffman distances;
+        usize out = 0;
+        bool last = false;
+        while (!last) {
+            last = in.take(1) != 0;
+            const u32 type = in.take(2);
+            if (type == 0) {
+                in.align();
+                const u32 length = in.take(16);
+                if ((in.take(16) ^ 0xFFFFu) != length) {
+                    corrupt("stored block length check failed");
+                }
+                if (length > output.size() - out) {
+                    corrupt("output exceeds the declared size");
+                }
+
+                // Whole bytes may still sit in the bit buffer after the header.
+                usize copied = 0;
+                while (copied < length && in.count >= 8) {
+                    output[out + copied++] = static_cast<byte>(in.take(8));
+                }
+                if (length - copied > in.size - in.pos) {
+                    corrupt("input ends inside a stored block");
+                }
+                std::memcpy(output.data() + out + copied, in.data + in.pos, length - copied);
+                in.pos += length - copied;
+                out += length;
+            } else if (type == 1) {
+                inflate_block(in, fixed.literals, fixed.distances, output, out);
+            } else if (type == 2) {
+                read_dynamic(in, literals, distances);
+                inflate_block(in, literals, distances, output, out);
+            } else {
+                corrupt("reserved block type");
+            }
+        }
+
+        if (out != output.size()) {
+            corrupt("output is shorter than the declared size");
+        }
+    }
+
+    vec<byte> inflate(std::span<const byte> input, usize size) {
+        vec<byte> output(size);
+        inflate(input, output);
+        return output;
+    }
+
+} // namespace mloader
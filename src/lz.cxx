@@ -0,0 +1,237 @@
+#include "mloader/lz.hxx"
+
+#include <bit>
+#include <cstring>
+
+#include "mtl/error.hxx"
+
+namespace mloader {
+
+    namespace {
+
+        constexpr usize MIN_MATCH = 4;
+        /// The block always ends with this many literals.
+        constexpr usize LAST_LITERALS = 5;
+        /// No match starts within this many bytes of the end.
+        constexpr usize MATCH_LIMIT = 12;
+        constexpr usize MAX_DISTANCE = 0xFFFF;
+        constexpr u32 HASH_BITS = 14;
+        /// After this many misses in a row the search step grows by one.
+        constexpr u32 SKIP_SHIFT = 6;
+
+        [[noreturn]] void corrupt(const char* what) {
+            throw RuntimeError(str("Corrupt LZ block: ") + what + ".");
+        }
+
+        u32 load32(const byte* p) noexcept {
+            u32 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        u64 load64(const byte* p) noexcept {
+            u64 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        u32 hash4(const byte* p) noexcept {
+            return (load32(p) * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        /// @return Length of the common prefix of `a` and `b`, stopping at `limit`.
+        usize common_prefix(const byte* a, const byte* b, const byte* limit) noexcept {
+            const byte* start = a;
+            while (a + sizeof(u64) <= limit) {
+                const u64 diff = load64(a) ^ load64(b);
+                if (diff != 0) {
+                    // Little-endian: the lowest differing byte is the first mismatch.
+                    return static_cast<usize>(a - start) + static_cast<usize>(std::countr_zero(diff)) / 8;
+                }
+                a += sizeof(u64);
+                b += sizeof(u64);
+            }
+            while (a < limit && *a == *b) {
+                ++a;
+                ++b;
+            }
+            return static_cast<usize>(a - start);
+        }
+
+        void put_length(vec<byte>& out, usize length) {
+            while (length >= 255) {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<byte>(length));
+        }
+
+        void put_sequence(vec<byte>& out, const byte* literals, usize literal_size, usize distance, usize match_size) {
+            const usize match_code = match_size - MIN_MATCH;
+            out.push_back(static_cast<byte>(std::min<usize>(literal_size, 15) << 4 | std::min<usize>(match_code, 15)));
+            if (literal_size >= 15) {
+                put_length(out, literal_size - 15);
+            }
+            out.insert(out.end(), literals, literals + literal_size);
+            if (match_size == 0) {
+                return;
+            }
+            out.push_back(static_cast<byte>(distance));
+            out.push_back(static_cast<byte>(distance >> 8));
+            if (match_code >= 15) {
+                put_length(out, match_code - 15);
+            }
+        }
+
+        usize take_length(const byte*& in, const byte* end) {
+            usize length = 0;
+            byte next = 255;
+            while (next == 255) {
+                if (in == end) {
+                    corrupt("input ends inside a length");
+                }
+                next = *in++;
+                length += next;
+            }
+            return length;
+        }
+
+    } // namespace
+
+    vec<byte> compress_lz(std::span<const byte> input) {
+        const usize size = input.size();
+        if (size <= MATCH_LIMIT + 1) {
+            return {};
+        }
+
+        const byte* src = input.data();
+        const byte* match_end = src + size - LAST_LITERALS;
+        const usize limit = size - MATCH_LIMIT;
+
+        vec<byte> out;
+        out.reserve(size);
+        vec<u32> table(usize{1} << HASH_BITS, 0);
+
+        usize anchor = 0;
+        usize pos = 1;
+        table[hash4(src)] = 0;
+        while (pos < limit) {
+            usize candidate = 0;
+            u32 misses = 1u << SKIP_SHIFT;
+            bool found = false;
+            while (pos < limit) {
+                const u32 slot = hash4(src + pos);
+                candidate = table[slot];
+                table[slot] = static_cast<u32>(pos);
+                if (pos - candidate <= MAX_DISTANCE && load32(src + candidate) == load32(src + pos)) {
+                    found = true;
+                    break;
+                }
+                pos += misses++ >> SKIP_SHIFT;
+            }
+            if (!found) {
+                break;
+            }
+
+            while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            const usize length = MIN_MATCH + common_prefix(src + pos + MIN_MATCH, src + candidate + MIN_MATCH, match_end);
+
+            put_sequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            if (out.size() >= size) {
+                return {};
+            }
+
+            pos += length;
+            anchor = pos;
+            if (pos < limit) {
+                table[hash4(src + pos - 2)] = static_cast<u32>(pos - 2);
+            }
+        }
+
+        put_sequence(out, src + anchor, size - anchor, 0, 0);
+        if (out.size() >= size) {
+            return {};
+        }
+        return out;
+    }
+
+    void decompress_lz(std::span<const byte> input, std::span<byte> output) {
+        const byte* in = input.data();
+        const byte* in_end = in + input.size();
+        byte* out = output.data();
+        byte* const out_begin = out;
+        byte* const out_end = out + output.size();
+
+        while (true) {
+            if (in == in_end) {
+                corrupt("input ends before the last sequence");
+            }
+            const u32 token = *in++;
+
+            usize literals = token >> 4;
+            if (literals < 15 && in_end - in >= 16 && out_end - out >= 16) {
+                // Short runs: one fixed-size copy, the excess is overwritten later.
+                std::memcpy(out, in, 16);
+            } else {
+                if (literals == 15) {
+                    literals += take_length(in, in_end);
+                }
+                if (literals > static_cast<usize>(in_end - in) || literals > static_cast<usize>(out_end - out)) {
+                    corrupt("literal run exceeds the block");
+                }
+                std::memcpy(out, in, literals);
+            }
+            in += literals;
+            out += literals;
+
+            // Only the final sequence ends after its literals.
+            if (in == in_end) {
+                break;
+            }
+            if (in_end - in < 2) {
+                corrupt("input ends inside a match distance");
+            }
+            const usize distance = static_cast<usize>(in[0] | in[1] << 8);
+            in += 2;
+            if (distance == 0 || distance > static_cast<usize>(out - out_begin)) {
+                corrupt("distance reaches before the output start");
+            }
+
+            usize length = token & 15;
+            if (length == 15) {
+                length += take_length(in, in_end);
+            }
+            length += MIN_MATCH;
+            const usize room = static_cast<usize>(out_end - out);
+            if (length > room) {
+                corrupt("output exceeds the declared size");
+            }
+
+            const byte* source = out - distance;
+            if (length <= 18 && distance >= sizeof(u64) && room >= 24) {
+                std::memcpy(out, source, 8);
+                std::memcpy(out + 8, source + 8, 8);
+                std::memcpy(out + 16, source + 16, 8);
+            } else if (distance >= sizeof(u64) && room - length >= sizeof(u64)) {
+                // Eight bytes at a time; may write past the match, never past the output.
+                for (usize i = 0; i < length; i += sizeof(u64)) {
+                    std::memcpy(out + i, source + i, sizeof(u64));
+                }
+            } else {
+                // Byte by byte: a short distance repeats bytes being written.
+                for (usize i = 0; i < length; ++i) {
+                    out[i] = source[i];
+                }
+            }
+            out += length;
+        }
+
+        if (out != out_end) {
+            corrupt("output is shorter than the declared size");
+        }
+    }
+
+} // namespace mloader
@@ -0,0 +1,145 @@
+#include "mloader/mapping.hxx"
+
+#include <utility>
+
+#include "mtl/error.hxx"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mloader;
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_open = std::exchange(other.m_open, false);
+#ifdef _WIN32
+    m_file = std::exchange(other.m_file, nullptr);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const mtl::fs::Path& path) {
+    close();
+
+    const str name = path.string();
+    HANDLE file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw RuntimeError("Failed to open file for mapping: " + name);
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw RuntimeError("Failed to query size of mapped file: " + name);
+    }
+
+    m_file = file;
+    m_size = static_cast<usize>(size.QuadPart);
+    m_open = true;
+    if (m_size == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        throw RuntimeError("Failed to create file mapping: " + name);
+    }
+    m_mapping = mapping;
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        close();
+        throw RuntimeError("Failed to map view of file: " + name);
+    }
+    m_data = static_cast<const byte*>(view);
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    }
+    if (m_file) {
+        CloseHandle(static_cast<HANDLE>(m_file));
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+void MappedFile::open(const mtl::fs::Path& path) {
+    close();
+
+    const str name = path.string();
+    const int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw RuntimeError("Failed to open file for mapping: " + name);
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw RuntimeError("Failed to query size of mapped file: " + name);
+    }
+
+    const auto size = static_cast<usize>(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        m_open = true;
+        return;
+    }
+
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw RuntimeError("Failed to map file: " + name);
+    }
+
+    m_data = static_cast<const byte*>(mapped);
+    m_size = size;
+    m_open = true;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) {
+        ::munmap(const_cast<byte*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
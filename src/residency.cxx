@@ -0,0 +1,147 @@
+#include "mloader/residency.hxx"
+
+#include <algorithm>
+#include <utility>
+
+using namespace mloader;
+
+ResidencyManager::ResidencyManager(u64 budget)
+    : m_budget(budget) {}
+
+ResidencyManager::~ResidencyManager() {
+    std::lock_guard lock(m_mutex);
+    for (Resource* resource : m_resources) {
+        resource->m_residency.store(nullptr, std::memory_order_release);
+    }
+}
+
+void ResidencyManager::set_budget(u64 budget) noexcept {
+    m_budget.store(budget, std::memory_order_relaxed);
+}
+
+u64 ResidencyManager::resident() const {
+    std::lock_guard lock(m_mutex);
+    return m_resident;
+}
+
+usize ResidencyManager::tracked() const {
+    std::lock_guard lock(m_mutex);
+    return m_resources.size();
+}
+
+void ResidencyManager::track(Resource& resource, const function<u64()>& insert) {
+    std::lock_guard lock(m_mutex);
+    const u64 bytes = insert();
+    if (resource.m_residency.load(std::memory_order_relaxed) != this) {
+        resource.m_residency_slot = m_resources.size();
+        resource.m_charge = resource.size();
+        m_resources.emplace_back(&resource);
+        m_resident += resource.m_charge;
+        resource.m_residency.store(this, std::memory_order_release);
+    } else if (resource.m_charge == 0) {
+        // Parsed again after an eviction released the resource's bytes.
+        resource.m_charge = resource.size();
+        m_resident += resource.m_charge;
+    }
+    resource.m_charge += bytes;
+    m_resident += bytes;
+    resource.m_last_use.store(m_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void ResidencyManager::touch(Resource& resource) const noexcept {
+    // A plain store of the coarse clock keeps the hot path free of contended writes.
+    resource.m_last_use.store(m_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void ResidencyManager::forget(Resource& resource) noexcept {
+    std::lock_guard lock(m_mutex);
+    if (resource.m_residency.load(std::memory_order_relaxed) != this) {
+        return;
+    }
+    const usize slot = resource.m_residency_slot;
+    m_resources[slot] = m_resources.back();
+    m_resources[slot]->m_residency_slot = slot;
+    m_resources.pop_back();
+    m_resident -= resource.m_charge;
+    resource.m_residency.store(nullptr, std::memory_order_release);
+}
+
+usize ResidencyManager::trim() {
+    const u64 target = budget();
+    return target == 0 ? 0 : trim(target);
+}
+
+usize ResidencyManager::trim(u64 target) {
+    std::lock_guard lock(m_mutex);
+    m_clock.fetch_add(1, std::memory_order_relaxed);
+    if (m_resident <= target) {
+        return 0;
+    }
+
+    vec<Resource*> candidates;
+    for (Resource* resource : m_resources) {
+        if (resource->m_charge != 0 && !resource->pinned()) {
+            candidates.emplace_back(resource);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Resource* lhs, const Resource* rhs) {
+        return lhs->m_last_use.load(std::memory_order_relaxed) < rhs->m_last_use.load(std::memory_order_relaxed);
+    });
+
+    usize evicted = 0;
+    for (Resource* resource : candidates) {
+        if (m_resident <= target) {
+            break;
+        }
+        std::array<AssetPayload*, ASSET_SLOT_COUNT> payloads{};
+        {
+            std::lock_guard pin_lock(resource->m_pin_mutex);
+            if (resource->pinned()) {
+                continue;
+            }
+            // Payloads are only published under m_mutex, so no slot can fill up meanwhile.
+            for (usize slot = 0; slot < ASSET_SLOT_COUNT; ++slot) {
+                payloads[slot] = resource->m_payloads[slot].exchange(nullptr, std::memory_order_acq_rel);
+            }
+            resource->m_generation.fetch_add(1, std::memory_order_release);
+        }
+        for (AssetPayload* payload : payloads) {
+            delete payload;
+        }
+        // The generation bump makes assets drop their handles on next access,
+        // so the resource's own bytes go with the payloads. That also covers
+        // binary, sound and font payloads, which only borrow those bytes.
+        m_resident -= resource->m_charge;
+        resource->m_charge = 0;
+        ++evicted;
+    }
+    return evicted;
+}
+
+ResidencyManager& ResidencyManager::shared() {
+    static ResidencyManager manager;
+    return manager;
+}
+
+ResidencyPin::ResidencyPin(ResourceHandle handle)
+    : m_handle(std::move(handle)) {
+    if (m_handle.valid()) {
+        m_handle->pin();
+    }
+}
+
+ResidencyPin::~ResidencyPin() {
+    if (m_handle.valid()) {
+        m_handle->unpin();
+    }
+}
+
+ResidencyPin& ResidencyPin::operator=(ResidencyPin&& other) noexcept {
+    if (this != &other) {
+        if (m_handle.valid()) {
+            m_handle->unpin();
+        }
+        m_handle = std::move(other.m_handle);
+    }
+    return *this;
+}
@@ -1,5 +1,7 @@
 #include "mloader/resource.hxx"
 
+#include "mloader/residency.hxx"
+
 #include <utility>
 
 using namespace mloader;
@@ -7,6 +9,15 @@ using namespace mloader;
 Resource::Resource(Database& owner)
     : m_db(&owner) {}
 
+Resource::~Resource() {
+    if (auto* residency = m_residency.load(std::memory_order_acquire)) {
+        residency->forget(*this);
+    }
+    for (auto& slot : m_payloads) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
 Database& Resource::db() const {
     return *m_db;
 }
@@ -21,6 +32,47 @@ void Resource::dec_ref() {
     }
 }
 
+bool Resource::try_ref() noexcept {
+    u32 current = m_refcount.load();
+    while (current != 0) {
+        if (m_refcount.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u32 Resource::refcount() const noexcept {
+    return m_refcount.load();
+}
+
+bool Resource::stale() const noexcept {
+    return m_stale.load(std::memory_order_acquire);
+}
+
+void Resource::mark_stale() noexcept {
+    m_stale.store(true, std::memory_order_release);
+}
+
+void Resource::pin() {
+    // Under the pin lock so trim() never evicts between its check and a new pin.
+    std::lock_guard lock(m_pin_mutex);
+    m_pins.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Resource::unpin() {
+    std::lock_guard lock(m_pin_mutex);
+    m_pins.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool Resource::pinned() const noexcept {
+    return m_pins.load(std::memory_order_relaxed) != 0;
+}
+
+u32 Resource::generation() const noexcept {
+    return m_generation.load(std::memory_order_acquire);
+}
+
 void Resource::destroy_self() {
     delete this;
 }
@@ -32,6 +84,12 @@ ResourceHandle::ResourceHandle(Resource* res)
     }
 }
 
+ResourceHandle ResourceHandle::adopt(Resource* res) {
+    ResourceHandle handle;
+    handle.m_res = res;
+    return handle;
+}
+
 ResourceHandle::ResourceHandle(const ResourceHandle& other)
     : m_res(other.m_res) {
     if (m_res) {
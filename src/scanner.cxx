@@ -26,25 +26,16 @@ DatabaseScanner& DatabaseScanner::scan() {
         db.load();
     }
 
-    vec<Database::Entry> entries = db.list();
-    for (const auto& entry : entries) {
+    db.each(Database::PurePath(), [&](const Database::Entry& entry) {
         Database* entry_db = entry.db ? entry.db : &db;
-        if (!entry_db) {
-            continue;
-        }
-
         const bool file_like = entry.db ? entry.is_file()
                                        : entry_db->is_file(entry.path);
-        if (!file_like) {
-            continue;
-        }
-
-        if (!is_config(entry.path)) {
-            continue;
+        if (!file_like || !is_config(entry.path)) {
+            return;
         }
 
         m_configs.emplace_back(entry.path);
-    }
+    });
 
     std::sort(m_configs.begin(), m_configs.end(), [](const Database::PurePath& lhs, const Database::PurePath& rhs) {
         return lhs.as_posix() < rhs.as_posix();
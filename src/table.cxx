@@ -0,0 +1,27 @@
+#include "mloader/table.hxx"
+
+#include <algorithm>
+#include <bit>
+
+using namespace mloader;
+
+void FlatTable::reserve(usize count) {
+    const u64 capacity = std::bit_ceil(std::max<u64>(16, static_cast<u64>(count) * 2));
+    m_buckets.assign(static_cast<usize>(capacity), Bucket{});
+    m_mask = capacity - 1;
+    m_size = 0;
+}
+
+void FlatTable::clear() noexcept {
+    m_buckets.clear();
+    m_mask = 0;
+    m_size = 0;
+}
+
+void FlatTable::place(u64 hash, u32 value) noexcept {
+    u64 i = hash & m_mask;
+    while (m_buckets[static_cast<usize>(i)].value != npos) {
+        i = (i + 1) & m_mask;
+    }
+    m_buckets[static_cast<usize>(i)] = Bucket{static_cast<u32>(hash >> 32), value};
+}
@@ -0,0 +1,126 @@
+#include "mloader/worker.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace mloader;
+
+namespace {
+
+    /// Shared between the caller of parallel() and the helpers it posted.
+    struct ParallelState {
+        std::atomic<usize> next{0};
+        usize count = 0;
+        usize active = 0;
+        bool done = false;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable idle;
+    };
+
+    void drain(ParallelState& state, const function<void(usize)>& body) {
+        for (usize i = state.next++; i < state.count; i = state.next++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard lock(state.mutex);
+                if (!state.error) {
+                    state.error = std::current_exception();
+                }
+                state.next = state.count;
+            }
+        }
+    }
+
+} // namespace
+
+WorkerPool::WorkerPool(usize threads) {
+    if (threads == 0) {
+        threads = std::max<usize>(1, std::thread::hardware_concurrency());
+    }
+
+    m_threads.reserve(threads);
+    for (usize i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this] { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::post(function<void()> task) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.emplace_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void WorkerPool::run() {
+    for (;;) {
+        function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::parallel(usize count, const function<void(usize)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    auto state = make_sptr<ParallelState>();
+    state->count = count;
+
+    // Helpers only join while the caller has not finished; a helper that is
+    // dequeued late sees `done` and never touches `body` after we return.
+    const usize helpers = std::min(size(), count - 1);
+    for (usize i = 0; i < helpers; ++i) {
+        post([state, &body] {
+            {
+                std::lock_guard lock(state->mutex);
+                if (state->done) {
+                    return;
+                }
+                ++state->active;
+            }
+            drain(*state, body);
+            {
+                std::lock_guard lock(state->mutex);
+                --state->active;
+            }
+            state->idle.notify_all();
+        });
+    }
+
+    drain(*state, body);
+
+    std::unique_lock lock(state->mutex);
+    state->idle.wait(lock, [&] { return state->active == 0; });
+    state->done = true;
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,218 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/database/archive.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using mloader::ArchiveFileDatabase;
+using mloader::ResourceHandle;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+using PurePath = ArchiveFileDatabase::PurePath;
+
+namespace {
+
+    /**
+     * Written by Python's zipfile: stored readme.txt, deflated data/long.txt
+     * (dynamic Huffman) and data/fixed.txt (fixed Huffman), and an explicit
+     * empty/ directory, all dated 2024-05-17 12:30:10.
+     */
+    constexpr u8 SAMPLE_ZIP[] = {
+        0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc5, 0x63, 0xb1, 0x58, 0x07, 0xd3,
+        0xcf, 0x85, 0x0e, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x72, 0x65,
+        0x61, 0x64, 0x6d, 0x65, 0x2e, 0x74, 0x78, 0x74, 0x73, 0x74, 0x6f, 0x72, 0x65, 0x64, 0x20, 0x72,
+        0x65, 0x61, 0x64, 0x6d, 0x65, 0x0a, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00,
+        0xc5, 0x63, 0xb1, 0x58, 0x08, 0x31, 0x88, 0x30, 0x8d, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00,
+        0x0d, 0x00, 0x00, 0x00, 0x64, 0x61, 0x74, 0x61, 0x2f, 0x6c, 0x6f, 0x6e, 0x67, 0x2e, 0x74, 0x78,
+        0x74, 0xed, 0xd4, 0xbb, 0x0d, 0xc2, 0x40, 0x18, 0x04, 0xe1, 0x9c, 0x2a, 0xae, 0x84, 0xdb, 0x5d,
+        0x9e, 0xe5, 0x80, 0xfc, 0x5b, 0x20, 0x9d, 0x41, 0x42, 0xee, 0x5f, 0x04, 0xe4, 0x4c, 0x01, 0x38,
+        0x9e, 0xec, 0x0b, 0x66, 0x3c, 0x9e, 0xd5, 0x7a, 0xef, 0xed, 0x35, 0xb7, 0xf5, 0x5e, 0x6d, 0xaa,
+        0x79, 0x5c, 0xd7, 0x9a, 0xda, 0x52, 0xcb, 0xad, 0xde, 0xbb, 0xf1, 0xed, 0x82, 0x6e, 0xe8, 0x81,
+        0xbe, 0x87, 0x7e, 0x80, 0x7e, 0x84, 0x7e, 0x82, 0x7e, 0x86, 0x7e, 0xf9, 0xdd, 0x05, 0x7e, 0x02,
+        0x3f, 0x81, 0x9f, 0xc0, 0x4f, 0xe0, 0x27, 0xf0, 0x13, 0xf8, 0x09, 0xfc, 0x04, 0x7e, 0x02, 0x3f,
+        0x83, 0x9f, 0xc1, 0xcf, 0xe0, 0x67, 0xf0, 0x33, 0xf8, 0x19, 0xfc, 0x0c, 0x7e, 0x06, 0x3f, 0x83,
+        0x9f, 0xc1, 0x2f, 0xe0, 0x17, 0xf0, 0x0b, 0xf8, 0x05, 0xfc, 0x02, 0x7e, 0x01, 0xbf, 0x80, 0x5f,
+        0xc0, 0x2f, 0xe0, 0x17, 0xf0, 0xdb, 0xfe, 0xb7, 0xfd, 0xef, 0x3f, 0xff, 0xf7, 0x01, 0x50, 0x4b,
+        0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0xc5, 0x63, 0xb1, 0x58, 0x13, 0xdd, 0x09, 0xa2,
+        0x15, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x64, 0x61, 0x74, 0x61,
+        0x2f, 0x66, 0x69, 0x78, 0x65, 0x64, 0x2e, 0x74, 0x78, 0x74, 0x2b, 0xce, 0xc8, 0x2f, 0x2a, 0x51,
+        0x48, 0x49, 0x4d, 0xcb, 0x49, 0x2c, 0x49, 0x4d, 0x51, 0x28, 0x49, 0xad, 0x28, 0x01, 0x00, 0x50,
+        0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc5, 0x63, 0xb1, 0x58, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x65, 0x6d, 0x70,
+        0x74, 0x79, 0x2f, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc5,
+        0x63, 0xb1, 0x58, 0x07, 0xd3, 0xcf, 0x85, 0x0e, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00,
+        0x00, 0x72, 0x65, 0x61, 0x64, 0x6d, 0x65, 0x2e, 0x74, 0x78, 0x74, 0x50, 0x4b, 0x01, 0x02, 0x14,
+        0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0xc5, 0x63, 0xb1, 0x58, 0x08, 0x31, 0x88, 0x30, 0x8d,
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x80, 0x01, 0x36, 0x00, 0x00, 0x00, 0x64, 0x61, 0x74, 0x61, 0x2f, 0x6c, 0x6f,
+        0x6e, 0x67, 0x2e, 0x74, 0x78, 0x74, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00,
+        0x08, 0x00, 0xc5, 0x63, 0xb1, 0x58, 0x13, 0xdd, 0x09, 0xa2, 0x15, 0x00, 0x00, 0x00, 0x13, 0x00,
+        0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01,
+        0xee, 0x00, 0x00, 0x00, 0x64, 0x61, 0x74, 0x61, 0x2f, 0x66, 0x69, 0x78, 0x65, 0x64, 0x2e, 0x74,
+        0x78, 0x74, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc5, 0x63,
+        0xb1, 0x58, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x2f, 0x01, 0x00, 0x00,
+        0x65, 0x6d, 0x70, 0x74, 0x79, 0x2f, 0x50, 0x4b, 0x05, 0x06, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+        0x04, 0x00, 0xe3, 0x00, 0x00, 0x00, 0x53, 0x01, 0x00, 0x00, 0x00, 0x00,    };
+
+    str long_text() {
+        str text;
+        for (int i = 0; i < 64; ++i) {
+            char line[64];
+            std::snprintf(line, sizeof(line), "line %03d of the deflated member\n", i % 40);
+            text += line;
+        }
+        return text;
+    }
+
+    str read_text(const ResourceHandle& handle) {
+        const auto* raw = static_cast<const char*>(handle->data());
+        return str(raw, raw + handle->size());
+    }
+
+    Path write_bytes(const Path& target, const str& bytes) {
+        std::ofstream out(target.string(), std::ios::binary);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return target;
+    }
+
+    /// Appends a ustar member; names over 100 bytes are split into prefix and name.
+    void add_tar_member(str& tar, const str& path, char type, const str& contents) {
+        char header[512]{};
+        str name = path;
+        if (name.size() > 100) {
+            const usize cut = name.rfind('/', 155);
+            path.copy(header + 345, cut);
+            name = name.substr(cut + 1);
+        }
+        name.copy(header, 100);
+        std::snprintf(header + 100, 8, "%07o", 0644);
+        std::snprintf(header + 124, 12, "%011o", static_cast<unsigned>(contents.size()));
+        std::snprintf(header + 136, 12, "%011o", 1700000000u);
+        header[156] = type;
+        std::memcpy(header + 257, "ustar", 6);
+        std::memcpy(header + 263, "00", 2);
+
+        std::memset(header + 148, ' ', 8);
+        unsigned sum = 0;
+        for (unsigned char c : header) {
+            sum += c;
+        }
+        std::snprintf(header + 148, 8, "%06o", sum);
+
+        tar.append(header, sizeof(header));
+        tar += contents;
+        tar.append((512 - contents.size() % 512) % 512, '\0');
+    }
+
+    bool throws(const auto& body) {
+        try {
+            body();
+        } catch (const RuntimeError&) {
+            return true;
+        }
+        return false;
+    }
+
+} // namespace
+
+MTL_TEST(archive_db, reads_zip_members_stored_and_deflated) {
+    directory temp_dir;
+    const auto file = write_bytes(temp_dir.path() / "sample.zip", str(reinterpret_cast<const char*>(SAMPLE_ZIP), sizeof(SAMPLE_ZIP)));
+    ArchiveFileDatabase db(file);
+
+    fassert(db.format() == ArchiveFileDatabase::Format::zip, "zip should be detected");
+    fassert(db.list().size() == 5, "expected data dir, three files and empty dir", db.list().size());
+    fassert(db.is_dir(PurePath("data")) && db.is_dir(PurePath("empty")), "implied and explicit dirs should exist");
+    fassert(db.list(PurePath("readme.txt")).front().mtime == 1715949010ll * 1'000'000'000, "DOS timestamps should convert");
+
+    auto readme = db.resolve(PurePath("readme.txt"));
+    fassert(read_text(readme) == "stored readme\n", "stored member should read back", read_text(readme));
+    const auto* base = reinterpret_cast<const byte*>(SAMPLE_ZIP);
+    fassert(std::memcmp(readme->data(), base + 30 + 10, readme->size()) == 0, "stored member should follow its local header");
+
+    auto batch = db.resolve(vec<PurePath>{PurePath("data/long.txt"), PurePath("readme.txt"), PurePath("data/fixed.txt")});
+    fassert(read_text(batch[0]) == long_text(), "dynamic block member should inflate");
+    fassert(batch[1]->data() == readme->data(), "stored members should be shared");
+    fassert(read_text(batch[2]) == "short deflated text", "fixed block member should inflate");
+
+    auto again = db.resolve(PurePath("data/long.txt"));
+    fassert(again->data() == batch[0]->data(), "live inflated members should be shared");
+
+    fassert(throws([&] { (void)db.resolve(PurePath("empty")); }), "directories should not resolve");
+    fassert(throws([&] { db.unload(); }), "unload should refuse while handles are live");
+    readme = ResourceHandle();
+    batch.clear();
+    again = ResourceHandle();
+    db.unload();
+    fassert(!db.is_loaded(), "unload should succeed once handles are gone");
+}
+
+MTL_TEST(archive_db, reads_tar_members_in_place) {
+    directory temp_dir;
+    const str deep = "mods/" + str(60, 'a') + "/" + str(60, 'b') + "/model.obj";
+    str tar;
+    add_tar_member(tar, "mods/", '5', "");
+    add_tar_member(tar, "mods/readme.txt", '0', "tar readme");
+    add_tar_member(tar, deep, '0', "v 0 0 0\n");
+    add_tar_member(tar, "../escape.txt", '0', "nope");
+    tar.append(1024, '\0');
+
+    auto bad = write_bytes(temp_dir.path() / "bad.tar", tar);
+    fassert(throws([&] { ArchiveFileDatabase(bad).load(); }), "members escaping the root should be rejected");
+
+    tar.clear();
+    add_tar_member(tar, "mods/", '5', "");
+    add_tar_member(tar, "mods/readme.txt", '0', "tar readme");
+    add_tar_member(tar, deep, '0', "v 0 0 0\n");
+    tar.append(1024, '\0');
+    ArchiveFileDatabase db(write_bytes(temp_dir.path() / "mods.tar", tar));
+
+    fassert(db.format() == ArchiveFileDatabase::Format::tar, "tar should be detected");
+    fassert(db.is_file(PurePath(deep)), "prefix field should join long names", deep);
+    fassert(db.list(PurePath("mods")).size() == 5, "expected readme, two implied dirs and model");
+    fassert(db.list(PurePath("mods/readme.txt")).front().mtime == 1700000000ll * 1'000'000'000, "tar mtime should convert");
+
+    auto handles = db.resolve(vec<PurePath>{PurePath(deep), PurePath("mods/readme.txt")});
+    fassert(read_text(handles[0]) == "v 0 0 0\n", "long-named member should read back");
+    fassert(read_text(handles[1]) == "tar readme", "tar member should read back");
+}
+
+MTL_TEST(archive_db, rejects_short_and_truncated_archives) {
+    directory temp_dir;
+    const str zip(reinterpret_cast<const char*>(SAMPLE_ZIP), sizeof(SAMPLE_ZIP));
+
+    for (usize length : {4, 12, 21}) {
+        const auto file = write_bytes(temp_dir.path() / ("short" + std::to_string(length) + ".zip"), zip.substr(0, length));
+        fassert(throws([&] { ArchiveFileDatabase(file).load(); }), "zip shorter than its end record should be rejected", length);
+    }
+    const auto cut = write_bytes(temp_dir.path() / "cut.zip", zip.substr(0, zip.size() / 2));
+    fassert(throws([&] { ArchiveFileDatabase(cut).load(); }), "zip without its central directory should be rejected");
+
+    // The end record still points at a central directory past the new end of file.
+    str moved = zip;
+    moved.erase(40, 64);
+    const auto shifted = write_bytes(temp_dir.path() / "shifted.zip", moved);
+    fassert(throws([&] { ArchiveFileDatabase(shifted).load(); }), "zip with a misplaced central directory should be rejected");
+
+    for (const str& records : {str("12 size=abc\n"), str("99999999999999999999999 size=1\n"), str("2 size=1\n"), str("40 size=1\n")}) {
+        str tar;
+        add_tar_member(tar, "pax", 'x', records);
+        add_tar_member(tar, "readme.txt", '0', "text");
+        tar.append(1024, '\0');
+        const auto file = write_bytes(temp_dir.path() / "pax.tar", tar);
+        fassert(throws([&] { ArchiveFileDatabase(file).load(); }), "malformed pax header should be rejected", records);
+    }
+
+    str tar;
+    add_tar_member(tar, "readme.txt", '0', str(2048, 'x'));
+    const auto truncated = write_bytes(temp_dir.path() / "truncated.tar", tar.substr(0, 1024));
+    fassert(throws([&] { ArchiveFileDatabase(truncated).load(); }), "tar member past the end of file should be rejected");
+}
@@ -6,11 +6,15 @@
 #include "mtl/fs/tmp.hxx"
 
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <thread>
 
 using mloader::BinaryAsset;
 using mloader::FilesystemDatabase;
+using mloader::ImageAsset;
 using mloader::TextAsset;
 using mtl::fs::Path;
 using mtl::fs::tmp::directory;
@@ -45,8 +49,58 @@ namespace {
         stream.close();
     }
 
+    std::atomic<int> slow_parses{0};
+
+    /// Text asset whose parser is slow enough for concurrent first accesses to overlap.
+    class SlowTextAsset : public TextAsset {
+    public:
+        using TextAsset::TextAsset;
+
+    protected:
+        Parser parser() const override {
+            return [](mloader::Resource& resource) {
+                ++slow_parses;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return TextAsset::parse(resource);
+            };
+        }
+    };
+
+    /// Text asset whose parser produces the wrong payload type.
+    class MistypedTextAsset : public TextAsset {
+    public:
+        using TextAsset::TextAsset;
+
+    protected:
+        Parser parser() const override {
+            return [](mloader::Resource&) {
+                return make_parsed(42);
+            };
+        }
+    };
+
 } // namespace
 
+MTL_TEST(asset, mistyped_payload_is_rejected) {
+    directory temp_dir;
+    write_text(temp_dir.path() / "typed.txt", "text");
+
+    FilesystemDatabase db(temp_dir.path());
+    db.load();
+
+    const MistypedTextAsset asset(db, FilesystemDatabase::PurePath("typed.txt"));
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool threw = false;
+        try {
+            (void)asset.text();
+        } catch (const RuntimeError&) {
+            threw = true;
+        }
+        fassert(threw, "an accessor must not reinterpret another payload type", attempt);
+    }
+    fassert(TextAsset(db, FilesystemDatabase::PurePath("typed.txt")).text() == "text", "the mistyped payload must not be published");
+}
+
 MTL_TEST(asset, text_asset_returns_utf8_content) {
     directory temp_dir;
     Path root = temp_dir.path();
@@ -82,6 +136,227 @@ MTL_TEST(asset, binary_asset_loads_raw_bytes) {
     const auto& data = blob.data();
     fassert(data.size() == payload.size(), "payload size mismatch", data.size());
     fassert(std::equal(data.begin(), data.end(), payload.begin(), payload.end()), "payload content mismatch");
+    fassert(data.data() == blob.handle()->data(), "binary payload should borrow the resource bytes");
+
+    auto owned = blob.copy();
+    fassert(owned == payload, "copy should return the resource bytes");
+    fassert(owned.data() != data.data(), "copy should own its buffer");
 
     db.deactivate();
 }
+
+MTL_TEST(asset, assets_share_resource_and_parsed_payload) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "assets" / "messages" / "greeting.txt", "shared");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    const FilesystemDatabase::PurePath path("assets/messages/greeting.txt");
+    TextAsset first(db, path);
+    TextAsset second(db, path);
+    fassert(&*first.handle() == &*second.handle(), "assets should share one resource");
+    fassert(&first.text() == &second.text(), "assets should share the parsed payload");
+}
+
+MTL_TEST(asset, request_loads_in_background_and_touch_collects) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "assets" / "messages" / "greeting.txt", "hello async");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    mloader::WorkerPool pool(2);
+    std::promise<bool> finished;
+    TextAsset asset(db, FilesystemDatabase::PurePath("assets/messages/greeting.txt"));
+    asset.request(pool, [&](std::exception_ptr error) {
+        finished.set_value(error == nullptr);
+    });
+    fassert(asset.state() == mloader::AssetState::pending, "request should leave the asset pending");
+    fassert(finished.get_future().get(), "background load reported an error");
+    fassert(asset.ready(), "asset should be ready after the completion callback");
+
+    const auto& touched = asset.touch();
+    fassert(&touched == &asset, "touch should return the asset itself");
+    fassert(asset.state() == mloader::AssetState::parsed, "touch should collect the parsed payload");
+    fassert(asset.text() == "hello async", "unexpected text payload:", asset.text());
+
+    TextAsset missing(db, FilesystemDatabase::PurePath("assets/messages/missing.txt"));
+    missing.request(pool);
+    bool threw = false;
+    try {
+        missing.touch();
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    fassert(threw, "touch should rethrow the background failure");
+    fassert(missing.state() == mloader::AssetState::unloaded, "a failed load should not stay pending");
+}
+
+MTL_TEST(asset, every_request_runs_its_completion) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "assets" / "messages" / "greeting.txt", "hello twice");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    mloader::WorkerPool pool(2);
+    std::promise<bool> first;
+    std::promise<bool> second;
+    TextAsset asset(db, FilesystemDatabase::PurePath("assets/messages/greeting.txt"));
+    asset.request(pool, [&](std::exception_ptr error) {
+        first.set_value(error == nullptr);
+    });
+    asset.request(pool, [&](std::exception_ptr error) {
+        second.set_value(error == nullptr);
+    });
+    fassert(first.get_future().get(), "first request reported an error");
+    fassert(second.get_future().get(), "second request reported an error");
+    fassert(asset.text() == "hello twice", "unexpected text payload:", asset.text());
+
+    bool immediate = false;
+    asset.request(pool, [&](std::exception_ptr error) {
+        immediate = error == nullptr;
+    });
+    fassert(immediate, "a request for a parsed asset should complete right away");
+}
+
+MTL_TEST(asset, image_asset_decodes_pixels) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    // 2x1 RGB image: one red and one green pixel.
+    const vec<byte> png{
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02, 0x00, 0x00, 0x00, 0x7B, 0x40, 0xE8,
+        0xDD, 0x00, 0x00, 0x00, 0x0F, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9C, 0x63, 0xF8, 0xCF, 0xC0, 0xC0,
+        0xF0, 0x9F, 0x01, 0x00, 0x07, 0xFF, 0x01, 0xFF, 0x01, 0x7F, 0x89, 0xA7, 0x00, 0x00, 0x00, 0x00,
+        0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+    };
+    write_bytes(root / "textures" / "pair.png", png);
+    write_text(root / "textures" / "broken.png", "not an image");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    ImageAsset broken(db, FilesystemDatabase::PurePath("textures/broken.png"));
+    bool threw = false;
+    try {
+        (void)broken.image();
+    } catch (const RuntimeError&) {
+        threw = true;
+    }
+    fassert(threw, "undecodable image should throw");
+
+    if (!ImageAsset::supports("png")) {
+        return;
+    }
+
+    ImageAsset asset(db, FilesystemDatabase::PurePath("textures/pair.png"));
+    const auto& image = asset.image();
+    fassert(image.format == "png", "unexpected format:", image.format);
+    fassert(image.width == 2 && image.height == 1, "unexpected dimensions", image.width, image.height);
+    fassert(image.channels == 3 && image.stride == 6, "unexpected layout", image.channels, image.stride);
+    const vec<byte> expected{255, 0, 0, 0, 255, 0};
+    fassert(image.pixels == expected, "unexpected pixel values");
+}
+
+MTL_TEST(asset, residency_trim_evicts_least_recently_used_payloads) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "a.txt", str(100, 'a'));
+    write_text(root / "b.txt", str(100, 'b'));
+    write_text(root / "c.txt", str(100, 'c'));
+
+    FilesystemDatabase db(root);
+    db.load();
+    mloader::ResidencyManager residency;
+    db.set_residency(residency);
+
+    TextAsset a(db, FilesystemDatabase::PurePath("a.txt"));
+    TextAsset b(db, FilesystemDatabase::PurePath("b.txt"));
+    TextAsset c(db, FilesystemDatabase::PurePath("c.txt"));
+    fassert(a.text().size() == 100 && b.text().size() == 100 && c.text().size() == 100, "texts should parse");
+    fassert(residency.tracked() == 3, "every parsed resource should be tracked", residency.tracked());
+    const u64 full = residency.resident();
+    fassert(full >= 600, "resources and payloads should both be charged", full);
+
+    fassert(residency.trim() == 0, "an unlimited budget should not evict");
+    const auto pin = b.pin();
+    // Trims advance the use clock even when nothing is evicted.
+    fassert(residency.trim(full) == 0, "a resident total within the target should not evict");
+    (void)a.text();
+
+    // b is pinned and a was used after the last trim, so c goes first.
+    residency.set_budget(full - 50);
+    fassert(residency.trim() == 1, "one eviction should fit the budget");
+    fassert(a.handle()->generation() == 0 && b.handle()->generation() == 0, "recent and pinned payloads should stay");
+    fassert(residency.resident() <= full - 50, "trim should reach the budget", residency.resident());
+
+    fassert(c.text() == str(100, 'c'), "evicted payloads should parse again on access");
+    fassert(residency.tracked() == 3, "the released resource should be replaced, not leaked", residency.tracked());
+    fassert(residency.resident() == full, "reparsed payloads should be charged again", residency.resident());
+}
+
+MTL_TEST(asset, residency_trim_evicts_borrowed_binary_payloads) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "blob.bin", str(4096, 'x'));
+    write_text(root / "note.txt", "small");
+
+    FilesystemDatabase db(root);
+    db.load();
+    mloader::ResidencyManager residency;
+    db.set_residency(residency);
+
+    BinaryAsset blob(db, FilesystemDatabase::PurePath("blob.bin"));
+    TextAsset note(db, FilesystemDatabase::PurePath("note.txt"));
+    fassert(blob.data().size() == 4096, "binary should parse");
+    fassert(note.text() == "small", "text should parse");
+    const u64 full = residency.resident();
+    fassert(full >= 4096, "borrowed bytes should be charged", full);
+
+    // The binary asset is the least recently used and the only way to fit.
+    residency.set_budget(1024);
+    fassert(residency.trim() >= 1, "the binary payload should be evicted");
+    fassert(blob.handle()->generation() == 0, "the asset should hold a freshly resolved resource");
+    fassert(residency.resident() <= 1024, "trim should release the borrowed bytes", residency.resident());
+
+    fassert(blob.data().size() == 4096, "evicted binary payloads should parse again on access");
+    fassert(residency.resident() == full, "reparsed payloads should be charged again", residency.resident());
+}
+
+MTL_TEST(asset, concurrent_first_access_parses_once) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text(root / "shared.txt", "parsed once");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    slow_parses = 0;
+    const SlowTextAsset asset(db, FilesystemDatabase::PurePath("shared.txt"));
+    vec<SlowTextAsset> copies(8, asset);
+    vec<const str*> seen(copies.size(), nullptr);
+    vec<std::thread> threads;
+    for (usize i = 0; i < copies.size(); ++i) {
+        threads.emplace_back([&, i] { seen[i] = &copies[i].text(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    fassert(slow_parses == 1, "concurrent accesses should share one parse", slow_parses.load());
+    fassert(std::all_of(seen.begin(), seen.end(), [&](const str* text) { return text == seen.front(); }),
+            "every asset should see the published payload");
+    fassert(*seen.front() == "parsed once", "unexpected payload:", *seen.front());
+}
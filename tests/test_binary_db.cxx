@@ -1,6 +1,255 @@
 #include "mtl/testing.hxx"
 
-MTL_TEST(binary_db, placeholder) {
-    // WIP
+#include "mloader/database/binary.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/extension/archive/writer.hxx"
+#include "mloader/hash.hxx"
+#include "mloader/lz.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+
+#include <cstdint>
+#include <fstream>
+
+using mloader::BinaryDatabase;
+using mloader::ResourceHandle;
+using mloader::extension::ArchiveEncoder;
+using mloader::extension::ArchiveWriter;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    struct PackedFile {
+        str path;
+        str contents;
+    };
+
+    Path write_archive(const Path& target, const vec<str>& dirs, const vec<PackedFile>& files) {
+        ArchiveEncoder header{};
+        header.extension.name = "test.pack";
+
+        ArchiveWriter writer(target, header);
+        for (const auto& dir : dirs) {
+            writer.add_dir(dir);
+        }
+        for (const auto& file : files) {
+            const auto* data = reinterpret_cast<const byte*>(file.contents.data());
+            writer.add_file(file.path, data, file.contents.size(), mloader::hash64(data, file.contents.size()));
+        }
+        writer.finish();
+        return target;
+    }
+
+    Path sample_archive(const Path& root) {
+        return write_archive(root / "sample.mlda",
+                             {"assets", "assets/levels", "assets/textures"},
+                             {{"assets/levels/intro.txt", "intro level"},
+                              {"assets/levels/boss.txt", "boss level"},
+                              {"readme.md", "# readme"}});
+    }
+
+} // namespace
+
+MTL_TEST(binary_db, lists_archive_entries) {
+    directory temp_dir;
+    BinaryDatabase db(sample_archive(temp_dir.path()));
+    db.load();
+
+    fassert(db.is_loaded(), "database should be marked loaded");
+    fassert(db.extension().name == "test.pack", "header metadata mismatch", db.extension().name);
+
+    vec<str> names;
+    for (const auto& entry : db.list()) {
+        names.emplace_back(entry.path.as_posix());
+        fassert(entry.db == &db, "entry should reference database");
+    }
+    vec<str> expected{
+        "assets",
+        "assets/levels",
+        "assets/levels/boss.txt",
+        "assets/levels/intro.txt",
+        "assets/textures",
+        "readme.md"
+    };
+    fassert(names == expected, "unexpected entries");
+
+    auto subset = db.list(BinaryDatabase::PurePath("assets/levels"));
+    fassert(subset.size() == 3, "expected levels dir and two files", subset.size());
+
+    vec<str> children;
+    db.children(BinaryDatabase::PurePath("assets"), [&](const BinaryDatabase::Entry& entry) {
+        children.emplace_back(entry.path.as_posix());
+    });
+    fassert((children == vec<str>{"assets/levels", "assets/textures"}), "unexpected direct children");
+
+    fassert(db.is_dir(BinaryDatabase::PurePath("assets/textures")), "textures should be a directory");
+    fassert(db.is_file(BinaryDatabase::PurePath("./readme.md")), "readme should be a file");
+    fassert(!db.exists(BinaryDatabase::PurePath("assets/missing")), "missing path should not exist");
+}
+
+MTL_TEST(binary_db, resolves_payloads_without_copying) {
+    directory temp_dir;
+    BinaryDatabase db(sample_archive(temp_dir.path()));
+
+    auto handle = db.resolve(BinaryDatabase::PurePath("assets/levels/boss.txt"));
+    fassert(handle.valid(), "resource handle should be valid");
+
+    const auto* raw = static_cast<const char*>(handle->data());
+    str resolved(raw, raw + handle->size());
+    fassert(resolved == "boss level", "resource payload mismatch", resolved);
+
+    auto address = reinterpret_cast<std::uintptr_t>(handle->data());
+    fassert(address % mloader::extension::ARCHIVE_ALIGNMENT == 0, "payload should be aligned");
+
+    auto again = db.resolve(BinaryDatabase::PurePath("assets/levels/boss.txt"));
+    fassert(again->data() == handle->data(), "payloads should view the same mapping");
+
+    bool threw = false;
+    try {
+        (void)db.resolve(BinaryDatabase::PurePath("assets/levels"));
+    } catch (const RuntimeError&) {
+        threw = true;
+    }
+    fassert(threw, "resolving a directory should throw");
+}
+
+MTL_TEST(binary_db, decodes_compressed_entries_on_resolve) {
+    directory temp_dir;
+    str text;
+    for (int i = 0; i < 200; ++i) {
+        text += "unit_" + std::to_string(i % 13) + ": { health: 100, armour: 20 }\n";
+    }
+    const auto* data = reinterpret_cast<const byte*>(text.data());
+    const auto packed = mloader::compress_lz({data, text.size()});
+    fassert(!packed.empty() && packed.size() < text.size() / 4, "repetitive text should compress", packed.size());
+
+    ArchiveEncoder header{};
+    header.extension.name = "test.pack";
+    ArchiveWriter writer(temp_dir.path() / "packed.mlda", header);
+    writer.add_dir("defs");
+    writer.add_compressed("defs/units.yml", packed.data(), packed.size(), text.size(), mloader::hash64(data, text.size()));
+    writer.add_file("defs/plain.yml", data, 16, mloader::hash64(data, 16));
+    writer.finish();
+
+    BinaryDatabase db(temp_dir.path() / "packed.mlda");
+    fassert(db.list(BinaryDatabase::PurePath("defs/units.yml")).front().size == text.size(), "entries report the decoded size");
+
+    auto handles = db.resolve(vec<BinaryDatabase::PurePath>{BinaryDatabase::PurePath("defs/units.yml"), BinaryDatabase::PurePath("defs/plain.yml")});
+    const auto* raw = static_cast<const char*>(handles[0]->data());
+    fassert(str(raw, raw + handles[0]->size()) == text, "compressed entry should decode to the original bytes");
+    fassert(handles[1]->size() == 16, "stored entries resolve as before");
+
+    const void* decoded = handles[0]->data();
+    auto again = db.resolve(BinaryDatabase::PurePath("defs/units.yml"));
+    fassert(again->data() == decoded, "live decoded entries should be shared");
+
+    handles.clear();
+    again = ResourceHandle();
+    auto reused = db.resolve(BinaryDatabase::PurePath("defs/units.yml"));
+    fassert(reused->data() == decoded, "released decode buffers should be pooled");
+    reused = ResourceHandle();
+    db.unload();
 }
 
+MTL_TEST(binary_db, decoded_handles_outlive_the_database) {
+    directory temp_dir;
+    const str text(4096, 'z');
+    const auto* data = reinterpret_cast<const byte*>(text.data());
+    const auto packed = mloader::compress_lz({data, text.size()});
+
+    ArchiveEncoder header{};
+    header.extension.name = "test.pack";
+    ArchiveWriter writer(temp_dir.path() / "packed.mlda", header);
+    writer.add_compressed("zeros.bin", packed.data(), packed.size(), text.size(), mloader::hash64(data, text.size()));
+    writer.finish();
+
+    ResourceHandle handle;
+    {
+        BinaryDatabase db(temp_dir.path() / "packed.mlda");
+        handle = db.resolve(BinaryDatabase::PurePath("zeros.bin"));
+    }
+    const auto* raw = static_cast<const char*>(handle->data());
+    fassert(str(raw, raw + handle->size()) == text, "decoded bytes should stay valid after the database is gone");
+    handle = ResourceHandle();
+}
+
+MTL_TEST(binary_db, verifies_checksums_per_mode) {
+    directory temp_dir;
+    const Path archive = sample_archive(temp_dir.path());
+    {
+        BinaryDatabase db(archive, BinaryDatabase::Verification::eager);
+        db.load();
+        db.verify();
+    }
+
+    // Flip one payload byte of boss.txt.
+    std::fstream stream(archive.string(), std::ios::binary | std::ios::in | std::ios::out);
+    str bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const auto at = bytes.find("boss level");
+    fassert(at != str::npos, "payload should be stored verbatim");
+    stream.seekp(static_cast<std::streamoff>(at));
+    stream.put('B');
+    stream.close();
+
+    auto throws = [](const auto& body) {
+        try {
+            body();
+        } catch (const RuntimeError&) {
+            return true;
+        }
+        return false;
+    };
+
+    BinaryDatabase eager(archive, BinaryDatabase::Verification::eager);
+    fassert(throws([&] { eager.load(); }), "eager mode should reject the archive on load");
+
+    BinaryDatabase lazy(archive, BinaryDatabase::Verification::lazy);
+    fassert(throws([&] { (void)lazy.resolve(BinaryDatabase::PurePath("assets/levels/boss.txt")); }), "lazy mode should reject the entry");
+    fassert(lazy.resolve(BinaryDatabase::PurePath("assets/levels/intro.txt"))->size() == 11, "intact entries still resolve");
+    fassert(throws([&] { lazy.verify(); }), "verify() should check the whole archive");
+
+    BinaryDatabase off(archive);
+    fassert(off.verification() == BinaryDatabase::Verification::off, "entries should not be hashed unless asked for");
+    auto handle = off.resolve(BinaryDatabase::PurePath("assets/levels/boss.txt"));
+    fassert(static_cast<const char*>(handle->data())[0] == 'B', "off mode should serve bytes unchecked");
+}
+
+MTL_TEST(binary_db, refuses_unload_with_live_handles) {
+    directory temp_dir;
+    BinaryDatabase db(sample_archive(temp_dir.path()));
+
+    {
+        auto handle = db.resolve(BinaryDatabase::PurePath("readme.md"));
+        bool threw = false;
+        try {
+            db.unload();
+        } catch (const RuntimeError&) {
+            threw = true;
+        }
+        fassert(threw, "unload should fail while handles are alive");
+    }
+
+    db.unload();
+    fassert(!db.is_loaded(), "database should unload once handles are released");
+}
+
+MTL_TEST(binary_db, rejects_corrupt_trailer) {
+    directory temp_dir;
+    Path archive = temp_dir.path() / "broken.mlda";
+    std::ofstream stream(archive.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+    stream << "MLDA not really an archive";
+    stream.close();
+
+    BinaryDatabase db(archive);
+    bool threw = false;
+    try {
+        db.load();
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    fassert(threw, "loading a corrupt archive should throw");
+    fassert(!db.is_loaded(), "corrupt archive must not be marked loaded");
+}
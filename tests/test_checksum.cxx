@@ -0,0 +1,42 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/checksum.hxx"
+#include "mloader/hash.hxx"
+
+#include <cstring>
+
+MTL_TEST(checksum, crc32c_matches_reference_vectors) {
+    fassert(mloader::crc32c("123456789", 9) == 0xE3069283u, "crc32c check value mismatch", mloader::crc32c_backend());
+
+    const char* text = "Nobody inspects the spammish repetition";
+    const usize size = std::strlen(text);
+    const u32 head = mloader::crc32c(text, 10);
+    const u32 tail = mloader::crc32c(text + 10, size - 10);
+    fassert(mloader::crc32c_combine(head, tail, size - 10) == mloader::crc32c(text, size), "combined crc mismatch");
+    fassert(mloader::crc32c(text + 10, size - 10, head) == mloader::crc32c(text, size), "continued crc mismatch");
+}
+
+MTL_TEST(checksum, sha256_matches_reference_vectors) {
+    const byte abc[] = {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+                        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+    const auto digest = mloader::Sha256::digest("abc", 3);
+    fassert(std::memcmp(digest.data(), abc, sizeof(abc)) == 0, "sha256 digest mismatch");
+
+    // Two-block message, fed in uneven pieces so updates straddle the block boundary.
+    const char* text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    const byte two_blocks[] = {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+                               0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1};
+    mloader::Sha256 sha;
+    sha.update(text, 7);
+    sha.update(text + 7, std::strlen(text) - 7);
+    const auto streamed = sha.finish();
+    fassert(std::memcmp(streamed.data(), two_blocks, sizeof(two_blocks)) == 0, "streamed sha256 digest mismatch");
+}
+
+MTL_TEST(checksum, hash64_matches_reference_vectors) {
+    fassert(mloader::hash64("", 0) == 0xEF46DB3751D8E999ULL, "empty input hash mismatch");
+    fassert(mloader::hash64("abc", 3) == 0x44BC2CF5AD770999ULL, "short input hash mismatch");
+
+    const char* text = "Nobody inspects the spammish repetition";
+    fassert(mloader::hash64(text, std::strlen(text)) == 0xFBCEA83C8A378BF1ULL, "long input hash mismatch");
+}
@@ -0,0 +1,197 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/defs/registry.hxx"
+#include "mloader/extension/archive/decoder.hxx"
+#include "mloader/extension/archive/writer.hxx"
+#include "mloader/extension/system.hxx"
+#include "mloader/hash.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+#include "mtl/serial.hxx"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using mloader::DefinitionRegistry;
+using mloader::extension::ArchiveEncoder;
+using mloader::extension::ArchiveWriter;
+using mloader::extension::ExtensionSystem;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    struct Unit : mloader::Definition {
+        str id;
+        int health = 0;
+
+        VISIT() override {
+            VIEW(id);
+            VIEW(health);
+        }
+
+        use const str& identifier() cx override {
+            return id;
+        }
+    };
+
+    void write_text_file(const Path& target, const str& contents) {
+        std::filesystem::create_directories(std::filesystem::path(target.string()).parent_path());
+        std::ofstream stream(target.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+        stream << contents;
+    }
+
+    /// Unpacked extension: a directory with index.yml, one unit definition and a shared texture path.
+    void write_mod(const Path& root, const str& name, const str& extra_config, const str& texture) {
+        write_text_file(root / name / "index.yml", "name: " + name + "\nversion: 1.0.0\ndefinitions: defs\n" + extra_config);
+        write_text_file(root / name / "defs" / "units.yml", "- type: Unit\n  id: " + name + "_unit\n  health: 10\n");
+        write_text_file(root / name / "textures" / "shared.txt", texture);
+    }
+
+    str load_error(ExtensionSystem& system) {
+        try {
+            system.scan();
+            DefinitionRegistry registry;
+            system.load(registry);
+        } catch (const RuntimeError& ex) {
+            return ex.what();
+        }
+        return {};
+    }
+
+} // namespace
+
+MTL_TEST(extension_system, loads_packed_and_unpacked_extensions_in_dependency_order) {
+    directory temp_dir;
+    const Path root = temp_dir.path();
+    write_mod(root, "core", "", "core");
+    write_mod(root, "weapons", "dependencies: [core]\n", "weapons");
+    write_mod(root, "maps", "dependencies: [core]\noptional: [absent]\n", "maps");
+
+    // A packed extension that optionally builds on weapons.
+    ArchiveEncoder header{};
+    header.extension.name = "balance";
+    header.extension.dependencies = {"core"};
+    header.extension.optional = {"weapons"};
+    header.extension.definitions = mloader::extension::Extension::PurePath("defs");
+    {
+        ArchiveWriter writer(root / "balance.mlda", header);
+        const str units = "- type: Unit\n  id: balance_unit\n  health: 99\n";
+        const str texture = "balance";
+        writer.add_dir("defs");
+        writer.add_dir("textures");
+        writer.add_file("defs/units.yml", reinterpret_cast<const byte*>(units.data()), units.size(),
+                        mloader::hash64(units.data(), units.size()));
+        writer.add_file("textures/shared.txt", reinterpret_cast<const byte*>(texture.data()), texture.size(),
+                        mloader::hash64(texture.data(), texture.size()));
+        writer.finish();
+    }
+
+    ExtensionSystem system(root);
+    system.scan();
+    fassert(system.extensions().size() == 4, "expected four extensions", system.extensions().size());
+    fassert(system.find("balance") && system.find("balance")->info.optional.front() == "weapons", "archive headers should be read");
+
+    const auto frontiers = system.solve();
+    auto names = [&](const vec<usize>& frontier) {
+        vec<str> out;
+        for (usize i : frontier) {
+            out.emplace_back(system.extensions()[i]->info.name);
+        }
+        return out;
+    };
+    fassert(frontiers.size() == 3, "expected three frontiers", frontiers.size());
+    fassert((names(frontiers[0]) == vec<str>{"core"}), "core has no dependencies");
+    fassert((names(frontiers[1]) == vec<str>{"maps", "weapons"}), "independent extensions share a frontier");
+    fassert((names(frontiers[2]) == vec<str>{"balance"}), "installed optional dependencies order like required ones");
+
+    DefinitionRegistry registry;
+    registry.register_type<Unit>("Unit");
+    system.load(registry);
+
+    fassert(registry.each<Unit>().size() == 4, "every extension should contribute its definitions");
+    fassert(registry.find("Unit", "balance_unit") != nullptr, "packed definitions should be ingested");
+
+    auto texture = system.content().resolve(mloader::Database::PurePath("textures/shared.txt"));
+    const auto* raw = static_cast<const char*>(texture->data());
+    fassert(str(raw, raw + texture->size()) == "balance", "the last frontier should override shared files");
+}
+
+MTL_TEST(extension_system, reports_every_conflict) {
+    directory temp_dir;
+    const Path root = temp_dir.path();
+    write_mod(root, "a", "dependencies: [missing]\nincompatible: [b]\n", "a");
+    write_mod(root, "b", "incompatible: [a]\n", "b");
+
+    ExtensionSystem conflicts(root);
+    const str message = load_error(conflicts);
+    fassert(message.find("'a' requires 'missing'") != str::npos, "missing dependencies should be named", message);
+    fassert(message.find("'a' is incompatible with 'b'") != str::npos, "incompatible pairs should be named", message);
+    fassert(message.find("incompatible with 'a'") == str::npos, "each pair should be reported once", message);
+
+    directory cycle_dir;
+    write_mod(cycle_dir.path(), "x", "dependencies: [y]\n", "x");
+    write_mod(cycle_dir.path(), "y", "dependencies: [z]\n", "y");
+    write_mod(cycle_dir.path(), "z", "dependencies: [x]\n", "z");
+    write_mod(cycle_dir.path(), "w", "dependencies: [x]\n", "w");
+
+    ExtensionSystem cycle(cycle_dir.path());
+    const str cycle_message = load_error(cycle);
+    fassert(cycle_message.find("Dependency cycle: ") != str::npos, "cycles should be reported", cycle_message);
+    fassert(cycle_message.find("x -> y -> z -> x") != str::npos || cycle_message.find("y -> z -> x -> y") != str::npos ||
+                cycle_message.find("z -> x -> y -> z") != str::npos,
+            "the cycle should be spelled out", cycle_message);
+}
+
+MTL_TEST(extension_system, serves_scans_from_the_metadata_cache) {
+    directory temp_dir;
+    const Path root = temp_dir.path();
+    const Path archive = root / "big.mlda";
+
+    ArchiveEncoder header{};
+    header.extension.name = "big";
+    header.extension.dependencies = {"core"};
+    {
+        ArchiveWriter writer(archive, header);
+        const str payload(1 << 20, 'x');
+        writer.add_file("payload.bin", reinterpret_cast<const byte*>(payload.data()), payload.size(),
+                        mloader::hash64(payload.data(), payload.size()));
+        writer.finish();
+    }
+    write_mod(root, "core", "", "core");
+
+    mloader::extension::ArchiveDecoder probe;
+    probe.probe_header(archive);
+    fassert(probe.extension.name == "big" && probe.extension.dependencies.front() == "core", "probe should decode the header");
+
+    ExtensionSystem system(root);
+    system.scan();
+    fassert(system.cache().size() == 2, "every scanned extension should be cached", system.cache().size());
+
+    // Reloaded caches serve the scan without touching the files.
+    const Path cache_file = root / "extensions.cache";
+    system.cache().save(cache_file);
+    ExtensionSystem reloaded(root);
+    fassert(reloaded.cache().load(cache_file) && reloaded.cache().size() == 2, "the cache should round-trip");
+
+    const std::filesystem::path native(archive.string());
+    const u64 size = std::filesystem::file_size(native);
+    const i64 mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::filesystem::last_write_time(native).time_since_epoch()).count();
+    mloader::extension::Extension stale{};
+    stale.name = "cached";
+    reloaded.cache().store(archive.string(), size, mtime, stale);
+    reloaded.scan();
+    fassert(reloaded.find("cached") && !reloaded.find("big"), "fresh entries should not be probed again");
+
+    // A touched file is probed again and its entry replaced.
+    std::filesystem::last_write_time(native, std::filesystem::last_write_time(native) + std::chrono::seconds(5));
+    reloaded.scan();
+    fassert(reloaded.find("big") && !reloaded.find("cached"), "changed files should be probed again");
+
+    std::filesystem::remove_all(std::filesystem::path((root / "core").string()));
+    reloaded.scan();
+    fassert(reloaded.cache().size() == 1, "removed extensions should leave the cache", reloaded.cache().size());
+}
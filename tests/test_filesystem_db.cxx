@@ -98,6 +98,67 @@ MTL_TEST(filesystem_db, resolves_files_to_resources) {
     fassert(resolved == data, "resource payload mismatch", resolved);
 }
 
+MTL_TEST(filesystem_db, live_resources_are_shared_until_released) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    const Path file = write_text_file(root / "data" / "shared.txt", "first");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    const FilesystemDatabase::PurePath rel("./data/shared.txt");
+    {
+        auto first = db.resolve(rel);
+        auto second = db.resolve(FilesystemDatabase::PurePath("data/shared.txt"));
+        fassert(&*first == &*second, "live resource should be reused");
+        fassert(first->refcount() == 2, "both handles should reference it", first->refcount());
+
+        auto batch = db.resolve(vec<FilesystemDatabase::PurePath>{rel});
+        fassert(&*batch.front() == &*first, "batch resolve should reuse the live resource");
+    }
+
+    write_text_file(file, "second");
+    auto reread = db.resolve(rel);
+    auto* raw = static_cast<const char*>(reread->data());
+    fassert(str(raw, raw + reread->size()) == "second", "released resource should be read again");
+
+    db.unload();
+    reread = ResourceHandle();
+}
+
+MTL_TEST(filesystem_db, batch_resolve_keeps_input_order) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    vec<FilesystemDatabase::PurePath> rels;
+    for (int i = 0; i < 32; ++i) {
+        const str name = "defs/" + std::to_string((i * 7) % 32) + ".yml";
+        write_text_file(root / name, name);
+        rels.emplace_back(name);
+    }
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    auto handles = db.resolve(rels);
+    fassert(handles.size() == rels.size(), "expected one handle per path", handles.size());
+    for (usize i = 0; i < rels.size(); ++i) {
+        auto* raw = static_cast<const char*>(handles[i]->data());
+        const str contents(raw, raw + handles[i]->size());
+        fassert(contents == rels[i].as_posix(), "handle out of order at", i, contents);
+    }
+
+    rels.emplace_back("defs/missing.yml");
+    bool threw = false;
+    try {
+        (void)db.resolve(rels);
+    } catch (const RuntimeError&) {
+        threw = true;
+    }
+    fassert(threw, "a missing path should fail the whole batch");
+}
+
 MTL_TEST(filesystem_db, reports_missing_entries) {
     directory temp_dir;
     Path root = temp_dir.path();
@@ -118,3 +179,176 @@ MTL_TEST(filesystem_db, reports_missing_entries) {
     }
     fassert(threw, "resolving missing path should throw");
 }
+
+MTL_TEST(filesystem_db, lookups_use_normalised_index) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "config" / "items" / "sword.yml", "id: sword");
+    write_text_file(root / "config" / "items.yml", "[]");
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    fassert(db.exists(FilesystemDatabase::PurePath("./config/items/sword.yml")), "dot-prefixed path should resolve");
+    fassert(db.exists(FilesystemDatabase::PurePath("config/items/")), "trailing separator should resolve");
+    fassert(db.is_file(FilesystemDatabase::PurePath("config/items.yml")), "sibling file should be a file");
+    fassert(db.is_dir(FilesystemDatabase::PurePath("config/items")), "items should be a directory");
+    fassert(!db.exists(FilesystemDatabase::PurePath("config/items/shield.yml")), "unknown file should not exist");
+    fassert(!db.is_dir(FilesystemDatabase::PurePath("config/item")), "prefix of a name must not match");
+}
+
+MTL_TEST(filesystem_db, path_index_maps_keys_to_slots) {
+    mloader::PathIndex index;
+    vec<std::string_view> keys{"a", "a-b", "a.txt", "a/b", "a/b/c.txt", "a/d", "z"};
+    index.build(keys);
+
+    fassert(index.size() == keys.size(), "index size mismatch", index.size());
+    for (u32 slot = 0; slot < keys.size(); ++slot) {
+        fassert(index.find(keys[slot]) == slot, "slot mismatch for", keys[slot]);
+        fassert(index.key(slot) == keys[slot], "stored key mismatch for", keys[slot]);
+    }
+    fassert(index.find("a/b/c") == mloader::PathIndex::npos, "missing key should return npos");
+
+    auto below = index.descendants("a");
+    fassert(below.first == 3 && below.last == 6, "descendants of 'a' should skip its siblings", below.first, below.last);
+
+    auto roots = index.children(mloader::PathIndex::npos);
+    fassert(roots.size() == 4, "unexpected root child count", roots.size());
+    auto under_a = index.children(index.find("a"));
+    fassert(under_a.size() == 2 && under_a[0] == 3 && under_a[1] == 5, "unexpected children of 'a'");
+
+    index.clear();
+    fassert(index.empty(), "cleared index should be empty");
+    fassert(index.find("a") == mloader::PathIndex::npos, "cleared index should not find keys");
+}
+
+MTL_TEST(filesystem_db, visits_subtrees_and_children_in_place) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "assets" / "levels" / "intro.txt", "intro level");
+    write_text_file(root / "assets" / "levels" / "boss.txt", "boss level");
+    write_text_file(root / "assets.txt", "sibling");
+    (root / "assets" / "textures").mkdir(true, true);
+
+    FilesystemDatabase db(root);
+    db.load();
+
+    vec<str> subtree;
+    db.each(FilesystemDatabase::PurePath("assets"), [&](const FilesystemDatabase::Entry& entry) {
+        subtree.emplace_back(entry.path.as_posix());
+    });
+    vec<str> expected_subtree{
+        "assets",
+        "assets/levels",
+        "assets/levels/boss.txt",
+        "assets/levels/intro.txt",
+        "assets/textures"
+    };
+    fassert(subtree == expected_subtree, "unexpected subtree visit order");
+
+    auto listed = db.list(FilesystemDatabase::PurePath("assets"));
+    fassert(listed.size() == subtree.size(), "list should match each", listed.size());
+
+    vec<str> children;
+    db.children(FilesystemDatabase::PurePath("assets"), [&](const FilesystemDatabase::Entry& entry) {
+        children.emplace_back(entry.path.as_posix());
+    });
+    vec<str> expected_children{"assets/levels", "assets/textures"};
+    fassert(children == expected_children, "unexpected direct children");
+
+    vec<str> top;
+    db.children(FilesystemDatabase::PurePath(), [&](const FilesystemDatabase::Entry& entry) {
+        top.emplace_back(entry.path.as_posix());
+    });
+    vec<str> expected_top{"assets", "assets.txt"};
+    fassert(top == expected_top, "unexpected root children");
+}
+
+MTL_TEST(filesystem_db, refresh_patches_index_and_invalidates_resources) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "a.txt", "alpha");
+    write_text_file(root / "gone" / "d.txt", "delta");
+    write_text_file(root / "z.txt", "zulu");
+
+    FilesystemDatabase db(root);
+    db.load();
+    auto old_a = db.resolve(FilesystemDatabase::PurePath("a.txt"));
+    auto old_z = db.resolve(FilesystemDatabase::PurePath("z.txt"));
+
+    vec<FilesystemDatabase::Change> seen;
+    const u64 token = db.subscribe([&](const vec<FilesystemDatabase::Change>& changes) {
+        seen = changes;
+    });
+
+    write_text_file(root / "a.txt", "alpha, edited");
+    write_text_file(root / "b" / "c.txt", "charlie");
+    std::filesystem::remove_all(std::filesystem::path((root / "gone").string()));
+
+    using Kind = FilesystemDatabase::Change::Kind;
+    const auto changes = db.refresh({FilesystemDatabase::PurePath("a.txt"), FilesystemDatabase::PurePath("b"),
+                                     FilesystemDatabase::PurePath("gone")});
+    const vec<std::pair<str, Kind>> expected{
+        {"a.txt", Kind::modified}, {"b", Kind::added}, {"b/c.txt", Kind::added},
+        {"gone", Kind::removed}, {"gone/d.txt", Kind::removed},
+    };
+    fassert(changes.size() == expected.size(), "unexpected change count", changes.size());
+    for (usize i = 0; i < expected.size(); ++i) {
+        fassert(changes[i].path.as_posix() == expected[i].first && changes[i].kind == expected[i].second,
+                "unexpected change", changes[i].path.as_posix());
+    }
+    fassert(seen.size() == changes.size(), "subscriber should see the same changes");
+
+    fassert(old_a->stale(), "resource of a modified file should be stale");
+    fassert(!old_z->stale(), "untouched resources stay valid");
+    fassert(db.resolve(FilesystemDatabase::PurePath("z.txt")).operator->() == old_z.operator->(),
+            "untouched live resources survive the re-index");
+
+    auto new_a = db.resolve(FilesystemDatabase::PurePath("a.txt"));
+    fassert(new_a->size() == 13, "modified file should be read again", new_a->size());
+    fassert(db.is_file(FilesystemDatabase::PurePath("b/c.txt")), "added file should be indexed");
+    fassert(!db.exists(FilesystemDatabase::PurePath("gone/d.txt")), "removed file should leave the index");
+
+    vec<str> children;
+    db.children(FilesystemDatabase::PurePath(), [&](const auto& entry) {
+        children.emplace_back(entry.path.as_posix());
+    });
+    fassert((children == vec<str>{"a.txt", "b", "z.txt"}), "root children should follow the patched tree");
+
+    db.unsubscribe(token);
+    seen.clear();
+    std::filesystem::remove(std::filesystem::path((root / "z.txt").string()));
+    fassert(db.refresh({FilesystemDatabase::PurePath()}).size() == 1, "a full refresh should find the removal");
+    fassert(seen.empty(), "unsubscribed callbacks should not run");
+    fassert(old_z->stale(), "removed files should be stale");
+}
+
+#ifdef __linux__
+MTL_TEST(filesystem_db, watch_applies_inotify_events_on_poll) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+    write_text_file(root / "a.txt", "alpha");
+
+    FilesystemDatabase db(root);
+    db.watch();
+    fassert(db.watching(), "database should be watching");
+    fassert(db.poll() == 0, "nothing changed yet");
+
+    write_text_file(root / "a.txt", "alpha, edited");
+    write_text_file(root / "nested" / "deeper" / "n.txt", "november");
+    fassert(db.poll() > 0, "poll should apply queued events");
+    fassert(db.list(FilesystemDatabase::PurePath("a.txt")).front().size == 13, "metadata should be refreshed");
+    fassert(db.is_file(FilesystemDatabase::PurePath("nested/deeper/n.txt")), "new subtree should be indexed");
+
+    // New directories get their own watches.
+    write_text_file(root / "nested" / "deeper" / "o.txt", "oscar");
+    db.poll();
+    fassert(db.is_file(FilesystemDatabase::PurePath("nested/deeper/o.txt")), "files in new directories should be seen");
+
+    db.unwatch();
+    fassert(!db.watching() && db.poll() == 0, "unwatched database should not poll");
+}
+#endif
@@ -0,0 +1,140 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/database/file.hxx"
+#include "mloader/database/joined.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+
+#include <filesystem>
+#include <fstream>
+
+using mloader::FilesystemDatabase;
+using mloader::JoinedDatabase;
+using mloader::ResourceHandle;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+using PurePath = mloader::Database::PurePath;
+
+namespace {
+
+    void write_text_file(const Path& target, const str& contents) {
+        std::filesystem::create_directories(std::filesystem::path(target.string()).parent_path());
+        std::ofstream stream(target.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+        fassert(stream.is_open(), "failed to open file for writing:", target.string());
+        stream << contents;
+    }
+
+    str read_text(const ResourceHandle& handle) {
+        const auto* raw = static_cast<const char*>(handle->data());
+        return str(raw, raw + handle->size());
+    }
+
+} // namespace
+
+MTL_TEST(joined_db, mods_override_base_by_priority_and_mount_order) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "base" / "textures" / "grass.txt", "base grass");
+    write_text_file(root / "base" / "textures" / "stone.txt", "base stone");
+    write_text_file(root / "base" / "config.txt", "base config");
+    write_text_file(root / "early" / "textures" / "grass.txt", "early grass");
+    write_text_file(root / "late" / "textures" / "grass.txt", "late grass");
+    write_text_file(root / "strong" / "config.txt", "strong config");
+
+    FilesystemDatabase base(root / "base");
+    FilesystemDatabase early(root / "early");
+    FilesystemDatabase late(root / "late");
+    FilesystemDatabase strong(root / "strong");
+
+    JoinedDatabase joined;
+    joined.mount(strong, PurePath(), 10).mount(base).mount(early).mount(late);
+    joined.load();
+
+    fassert(read_text(joined.resolve(PurePath("textures/grass.txt"))) == "late grass", "later mount should win ties");
+    fassert(read_text(joined.resolve(PurePath("textures/stone.txt"))) == "base stone", "unshadowed files fall through");
+    fassert(read_text(joined.resolve(PurePath("config.txt"))) == "strong config", "higher priority should win");
+    fassert(joined.owner(PurePath("textures/stone.txt")) == &base, "owner should report the serving database");
+
+    const auto handles = joined.resolve(vec<PurePath>{PurePath("config.txt"), PurePath("textures/stone.txt"),
+                                                      PurePath("textures/grass.txt")});
+    fassert(read_text(handles[0]) == "strong config" && read_text(handles[1]) == "base stone" &&
+            read_text(handles[2]) == "late grass", "batch resolve should keep input order");
+
+    fassert(joined.list().size() == 4, "merged tree should hold each path once", joined.list().size());
+    joined.unmount(late);
+    fassert(read_text(joined.resolve(PurePath("textures/grass.txt"))) == "early grass", "unmount should rebuild routing");
+}
+
+MTL_TEST(joined_db, mount_points_route_into_sub_databases) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "base" / "readme.txt", "base");
+    write_text_file(root / "mod" / "items" / "sword.yml", "sword");
+    write_text_file(root / "shadow" / "items", "not a directory");
+
+    FilesystemDatabase base(root / "base");
+    FilesystemDatabase mod(root / "mod");
+    FilesystemDatabase shadow(root / "shadow");
+
+    JoinedDatabase joined;
+    joined.mount(base).mount(mod, PurePath("mods/blades"));
+    joined.load();
+
+    fassert(joined.is_dir(PurePath("mods")), "mount point ancestors should be directories");
+    fassert(joined.is_file(PurePath("mods/blades/items/sword.yml")), "mounted files should be routed");
+    fassert(read_text(joined.resolve(PurePath("./mods/blades/items/sword.yml"))) == "sword", "paths should be normalised");
+    fassert(!joined.exists(PurePath("items/sword.yml")), "mounted files stay under their mount point");
+
+    vec<str> names;
+    joined.children(PurePath("mods/blades"), [&](const auto& entry) {
+        names.emplace_back(entry.path.as_posix());
+    });
+    fassert((names == vec<str>{"mods/blades/items"}), "children should be listed with joined paths");
+
+    // A stronger file hides a weaker directory and everything below it.
+    joined.mount(shadow, PurePath("mods/blades"), 1);
+    fassert(joined.is_file(PurePath("mods/blades/items")), "stronger file should shadow the directory");
+    fassert(!joined.exists(PurePath("mods/blades/items/sword.yml")), "shadowed contents should disappear");
+
+    bool rejected = false;
+    try {
+        (void)joined.resolve(PurePath("mods"));
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected, "directories should not resolve");
+}
+
+MTL_TEST(joined_db, mount_cycles_are_rejected) {
+    directory temp_dir;
+    write_text_file(temp_dir.path() / "base" / "readme.txt", "base");
+    FilesystemDatabase base(temp_dir.path() / "base");
+
+    JoinedDatabase a;
+    JoinedDatabase b;
+    JoinedDatabase c;
+    a.mount(base);
+    b.mount(a, PurePath("a"));
+    c.mount(b, PurePath("b"));
+
+    auto throws = [](const auto& body) {
+        try {
+            body();
+        } catch (const RuntimeError&) {
+            return true;
+        }
+        return false;
+    };
+    fassert(throws([&] { a.mount(a); }), "a database cannot mount itself");
+    fassert(throws([&] { a.mount(b); }), "mounting B into A after A into B should be rejected");
+    fassert(throws([&] { a.mount(c); }), "indirect cycles should be rejected");
+    fassert(a.mounts().size() == 1, "rejected mounts should not be recorded", a.mounts().size());
+
+    fassert(c.mounts_database(base) && !a.mounts_database(c), "nested mounts should be found");
+    c.load();
+    fassert(c.is_file(PurePath("b/a/readme.txt")), "nested joins should still route", c.list().size());
+}
@@ -0,0 +1,139 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/lz.hxx"
+
+#include "mtl/error.hxx"
+
+#include <cstring>
+
+using mloader::compress_lz;
+using mloader::decompress_lz;
+
+namespace {
+
+    vec<byte> bytes_of(std::string_view text) {
+        return vec<byte>(reinterpret_cast<const byte*>(text.data()), reinterpret_cast<const byte*>(text.data()) + text.size());
+    }
+
+    /// Incompressible filler: xorshift bytes.
+    vec<byte> noise(usize size, u32 seed) {
+        vec<byte> out(size);
+        for (auto& value : out) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            value = static_cast<byte>(seed);
+        }
+        return out;
+    }
+
+    bool round_trips(const vec<byte>& input, const vec<byte>& packed) {
+        vec<byte> output(input.size());
+        decompress_lz(packed, output);
+        return output == input;
+    }
+
+    bool throws(const auto& body) {
+        try {
+            body();
+        } catch (const RuntimeError&) {
+            return true;
+        }
+        return false;
+    }
+
+} // namespace
+
+MTL_TEST(lz, empty_and_tiny_inputs) {
+    fassert(compress_lz({}).empty(), "empty input should not be compressed");
+    fassert(compress_lz(bytes_of("0123456789ab")).empty(), "inputs below the match limit are stored");
+
+    byte unused = 0;
+    const std::span<byte> none(&unused, 0);
+    const vec<byte> final_only{0x00};
+    decompress_lz(final_only, none);
+    fassert(throws([&] { decompress_lz({}, none); }), "an empty block lacks the final sequence");
+}
+
+MTL_TEST(lz, overlapping_short_distance_matches) {
+    // "ab", then a ten byte match at distance two that copies its own output, then "Z".
+    const vec<byte> block{0x26, 'a', 'b', 0x02, 0x00, 0x10, 'Z'};
+    vec<byte> output(13);
+    decompress_lz(block, output);
+    fassert(output == bytes_of("abababababab" "Z"), "distance two should repeat the pair");
+
+    for (usize period : {1, 2, 3, 5, 7, 8, 9}) {
+        vec<byte> input;
+        for (usize i = 0; i < 4096; ++i) {
+            input.emplace_back(static_cast<byte>('a' + i % period));
+        }
+        const auto packed = compress_lz(input);
+        fassert(!packed.empty() && packed.size() < 64, "runs should collapse to a few sequences", period, packed.size());
+        fassert(round_trips(input, packed), "runs should survive the round trip", period);
+    }
+}
+
+MTL_TEST(lz, long_literal_and_match_lengths_use_extension_bytes) {
+    // Literal runs and matches of 15 + 255 * n bytes need one length byte more than their neighbours.
+    for (usize literals : {14, 15, 16, 269, 270, 271, 600}) {
+        for (usize match : {18, 19, 20, 273, 274, 275, 5000}) {
+            vec<byte> input = noise(literals, static_cast<u32>(literals * 31 + match));
+            input.insert(input.end(), match, byte{'x'});
+            const auto tail = noise(32, static_cast<u32>(match));
+            input.insert(input.end(), tail.begin(), tail.end());
+
+            const auto packed = compress_lz(input);
+            if (!packed.empty()) {
+                fassert(round_trips(input, packed), "long runs should survive the round trip", literals, match);
+            }
+        }
+    }
+
+    // Fifteen literals and a nineteen byte match are exactly the first extended lengths.
+    vec<byte> block{0xFF, 0x00};
+    const auto literals = bytes_of("0123456789abcde");
+    block.insert(block.end(), literals.begin(), literals.end());
+    block.insert(block.end(), {0x0F, 0x00, 0x00, 0x10, '!'});
+    vec<byte> output(15 + 19 + 1);
+    decompress_lz(block, output);
+    fassert(std::memcmp(output.data() + 15, "0123456789abcde0123", 19) == 0 && output.back() == '!', "extended lengths should decode");
+}
+
+MTL_TEST(lz, corrupt_and_truncated_blocks_throw) {
+    vec<byte> input = bytes_of("header: value\n");
+    for (usize i = 0; i < 400; ++i) {
+        const auto line = bytes_of("entry_" + std::to_string(i % 37) + ": { parent: base, value: " + std::to_string(i % 11) + " }\n");
+        input.insert(input.end(), line.begin(), line.end());
+    }
+    const auto packed = compress_lz(input);
+    fassert(!packed.empty() && round_trips(input, packed), "sample should compress");
+
+    vec<byte> output(input.size());
+    for (usize size = 0; size < packed.size(); ++size) {
+        const vec<byte> truncated(packed.begin(), packed.begin() + static_cast<std::ptrdiff_t>(size));
+        fassert(throws([&] { decompress_lz(truncated, output); }), "truncated block should throw", size);
+    }
+
+    vec<byte> longer(input.size() + 1);
+    vec<byte> shorter(input.size() - 1);
+    fassert(throws([&] { decompress_lz(packed, longer); }), "a short block should not satisfy a larger output");
+    fassert(throws([&] { decompress_lz(packed, shorter); }), "output must not overflow its declared size");
+
+    const vec<byte> before_start{0x10, 'a', 0x02, 0x00, 0x00};
+    vec<byte> small(8);
+    fassert(throws([&] { decompress_lz(before_start, small); }), "distances must stay inside the output");
+    const vec<byte> zero_distance{0x10, 'a', 0x00, 0x00, 0x00};
+    fassert(throws([&] { decompress_lz(zero_distance, small); }), "a zero distance is invalid");
+    const vec<byte> open_length{0xF0, 0xFF, 0xFF};
+    fassert(throws([&] { decompress_lz(open_length, small); }), "lengths must not run off the input");
+
+    // Flipped bytes either decode to something or throw; they never read or write out of bounds.
+    for (usize i = 0; i < packed.size(); i += 7) {
+        vec<byte> damaged = packed;
+        damaged[i] ^= 0x5A;
+        try {
+            decompress_lz(damaged, output);
+        } catch (const RuntimeError&) {
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/database/joined.hxx"
+#include "mloader/database/memory.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+
+#include <atomic>
+#include <thread>
+
+using mloader::InMemoryDatabase;
+using mloader::JoinedDatabase;
+using mloader::ResourceHandle;
+using PurePath = InMemoryDatabase::PurePath;
+
+namespace {
+
+    str read_text(const ResourceHandle& handle) {
+        const auto* raw = static_cast<const char*>(handle->data());
+        return str(raw, raw + handle->size());
+    }
+
+    std::span<const byte> bytes_of(std::string_view text) {
+        return {reinterpret_cast<const byte*>(text.data()), text.size()};
+    }
+
+    bool throws(const auto& body) {
+        try {
+            body();
+        } catch (const RuntimeError&) {
+            return true;
+        }
+        return false;
+    }
+
+} // namespace
+
+MTL_TEST(memory_db, stores_files_and_resolves_without_copies) {
+    InMemoryDatabase db;
+    db.insert(PurePath("levels/intro.txt"), "intro level")
+        .insert(PurePath("levels/boss.txt"), "boss level")
+        .add_dir(PurePath("textures"));
+
+    fassert(db.list().size() == 4, "expected levels dir, two files and textures", db.list().size());
+    fassert(db.is_dir(PurePath("levels")) && db.is_dir(PurePath("textures")), "directories should be implied or added");
+    fassert(db.list(PurePath("levels")).front().size == 0, "directories have no size");
+
+    auto first = db.resolve(PurePath("levels/intro.txt"));
+    auto second = db.resolve(PurePath("./levels/intro.txt"));
+    fassert(read_text(first) == "intro level", "resolved bytes should match");
+    fassert(first->data() == second->data(), "resolves should share the stored bytes");
+    fassert(reinterpret_cast<uintptr_t>(first->data()) % 16 == 0, "files should be aligned in the arena");
+
+    vec<str> names;
+    db.children(PurePath("levels"), [&](const auto& entry) {
+        names.emplace_back(entry.path.as_posix());
+    });
+    fassert((names == vec<str>{"levels/boss.txt", "levels/intro.txt"}), "children should be sorted");
+
+    fassert(throws([&] { db.insert(PurePath("levels"), "file over dir"); }), "files must not replace directories");
+    fassert(throws([&] { db.insert(PurePath("levels/boss.txt/x"), "below a file"); }), "paths must not run through files");
+    fassert(throws([&] { (void)db.resolve(PurePath("levels")); }), "directories should not resolve");
+}
+
+MTL_TEST(memory_db, replaced_and_removed_files_stay_valid_until_released) {
+    InMemoryDatabase db(64);
+    db.insert(vec<std::pair<PurePath, std::span<const byte>>>{
+        {PurePath("a/one.txt"), bytes_of("one")},
+        {PurePath("a/two.txt"), bytes_of("two")},
+        {PurePath("b.txt"), bytes_of("bee")},
+    });
+
+    auto old_one = db.resolve(PurePath("a/one.txt"));
+    db.insert(PurePath("a/one.txt"), "one, again");
+    fassert(old_one->stale() && read_text(old_one) == "one", "old handle keeps its bytes and reports stale");
+    fassert(read_text(db.resolve(PurePath("a/one.txt"))) == "one, again", "new resolves see the replacement");
+
+    fassert(throws([&] { db.compact(); }), "compact must wait for outstanding handles");
+    old_one = ResourceHandle();
+
+    fassert(db.remove(PurePath("a")) == 3, "removing a directory removes its subtree");
+    fassert(!db.exists(PurePath("a/two.txt")) && db.is_file(PurePath("b.txt")), "only the subtree should go");
+    fassert(db.live_bytes() == 3, "live bytes should track stored files", db.live_bytes());
+
+    const usize before = db.arena_capacity();
+    db.compact();
+    fassert(db.arena_capacity() == 64, "compact should keep one chunk for the surviving file", before, db.arena_capacity());
+    fassert(read_text(db.resolve(PurePath("b.txt"))) == "bee", "files survive compaction");
+
+    db.clear();
+    fassert(db.list().empty() && db.live_bytes() == 0, "clear should empty the database");
+}
+
+MTL_TEST(memory_db, concurrent_queries_after_an_edit_share_one_rebuild) {
+    InMemoryDatabase db;
+    for (usize i = 0; i < 256; ++i) {
+        db.insert(PurePath("files/" + std::to_string(i) + ".txt"), std::to_string(i));
+    }
+
+    for (usize round = 0; round < 8; ++round) {
+        db.insert(PurePath("round/" + std::to_string(round) + ".txt"), "edit");
+        std::atomic<usize> found{0};
+        vec<std::thread> threads;
+        for (usize t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (usize i = t; i < 256; i += 4) {
+                    const PurePath rel("files/" + std::to_string(i) + ".txt");
+                    if (db.is_file(rel) && read_text(db.resolve(rel)) == std::to_string(i)) {
+                        found.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        fassert(found.load() == 256, "every query should see the rebuilt index", round, found.load());
+        fassert(db.is_file(PurePath("round/" + std::to_string(round) + ".txt")), "the edit should be indexed");
+    }
+}
+
+MTL_TEST(memory_db, mounts_into_joined_databases) {
+    InMemoryDatabase base;
+    InMemoryDatabase mod;
+    base.insert(PurePath("textures/grass.txt"), "base grass").insert(PurePath("config.txt"), "base config");
+    mod.insert(PurePath("textures/grass.txt"), "mod grass");
+
+    JoinedDatabase joined;
+    joined.mount(base).mount(mod);
+    fassert(read_text(joined.resolve(PurePath("textures/grass.txt"))) == "mod grass", "later mounts should override");
+    fassert(read_text(joined.resolve(PurePath("config.txt"))) == "base config", "unshadowed files should fall through");
+    fassert(joined.list(PurePath("textures")).size() == 2, "expected the dir and one merged file", joined.list(PurePath("textures")).size());
+}
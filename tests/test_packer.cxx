@@ -0,0 +1,101 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/database/binary.hxx"
+#include "mloader/extension/archive/encoder.hxx"
+#include "mloader/extension/archive/packer.hxx"
+#include "mloader/extension/archive/writer.hxx"
+#include "mloader/resource.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+
+#include <filesystem>
+#include <fstream>
+
+using mloader::BinaryDatabase;
+using mloader::ResourceHandle;
+using mloader::extension::ArchiveEncoder;
+using mloader::extension::ArchiveWriter;
+using mloader::extension::PackOptions;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+using PurePath = BinaryDatabase::PurePath;
+
+namespace {
+
+    void write_text(const Path& target, const str& contents) {
+        std::filesystem::create_directories(std::filesystem::path(target.string()).parent_path());
+        std::ofstream(target.string(), std::ios::binary) << contents;
+    }
+
+    str read_text(const ResourceHandle& handle) {
+        const auto* raw = static_cast<const char*>(handle->data());
+        return str(raw, raw + handle->size());
+    }
+
+    bool exists(const Path& path) {
+        return std::filesystem::exists(path.string());
+    }
+
+} // namespace
+
+MTL_TEST(packer, packs_a_tree_that_binary_database_reads_back) {
+    directory temp_dir;
+    const Path source = temp_dir.path() / "content";
+    str units;
+    for (int i = 0; i < 200; ++i) {
+        units += "unit_" + std::to_string(i % 13) + ": { health: 100, armour: 20 }\n";
+    }
+    write_text(source / "index.yml", "name: test.pack\nversion: 1.2.0\n");
+    write_text(source / "defs" / "units.yml", units);
+    write_text(source / "textures" / "grass.txt", "grass");
+    std::filesystem::create_directories((source / "empty").string());
+
+    PackOptions options;
+    options.source = source;
+    options.output = temp_dir.path() / "content.mlda";
+    options.jobs = 2;
+    options.compress = true;
+    const auto summary = mloader::extension::pack_directory(options);
+    fassert(summary.files == 3 && summary.compressed == 1, "expected three files, one compressed", summary.files, summary.compressed);
+    fassert(!exists(temp_dir.path() / "content.mlda.partial"), "the partial file should be renamed into place");
+
+    BinaryDatabase db(options.output, BinaryDatabase::Verification::eager);
+    db.load();
+    fassert(db.extension().name == "test.pack", "the config should land in the header", db.extension().name);
+    fassert(db.list().size() == summary.entries, "every packed entry should be listed", db.list().size(), summary.entries);
+    fassert(db.is_dir(PurePath("empty")) && db.is_dir(PurePath("defs")), "directories should be packed");
+    fassert(read_text(db.resolve(PurePath("defs/units.yml"))) == units, "compressed file should read back");
+    fassert(read_text(db.resolve(PurePath("textures/grass.txt"))) == "grass", "stored file should read back");
+    fassert(read_text(db.resolve(PurePath("index.yml"))).starts_with("name: test.pack"), "the config is packed too");
+}
+
+MTL_TEST(packer, failed_pack_leaves_the_previous_archive) {
+    directory temp_dir;
+    const Path target = temp_dir.path() / "out.mlda";
+    write_text(target, "previous archive");
+
+    {
+        ArchiveWriter writer(target, ArchiveEncoder{});
+        const str data = "abandoned";
+        writer.add_file("data.txt", reinterpret_cast<const byte*>(data.data()), data.size(), 0);
+        fassert(exists(temp_dir.path() / "out.mlda.partial"), "bytes should go to the partial file");
+    }
+    fassert(!exists(temp_dir.path() / "out.mlda.partial"), "an unfinished writer should remove its partial file");
+
+    write_text(temp_dir.path() / "content" / "file.txt", "no config");
+    PackOptions options;
+    options.source = temp_dir.path() / "content";
+    options.output = target;
+    bool threw = false;
+    try {
+        (void)mloader::extension::pack_directory(options);
+    } catch (const RuntimeError&) {
+        threw = true;
+    }
+    fassert(threw, "a pack without an extension name should fail");
+
+    std::ifstream stream(target.string(), std::ios::binary);
+    const str contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    fassert(contents == "previous archive", "a failed pack must not touch the existing archive", contents);
+}
@@ -0,0 +1,447 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/database/file.hxx"
+#include "mloader/defs/registry.hxx"
+#include "mloader/worker.hxx"
+
+#include "mtl/error.hxx"
+#include "mtl/fs/tmp.hxx"
+#include "mtl/serial.hxx"
+
+#include <filesystem>
+#include <fstream>
+
+using mloader::DefinitionRegistry;
+using mloader::FilesystemDatabase;
+using mloader::ResourceHandle;
+using mloader::WorkerPool;
+using mtl::fs::Path;
+using mtl::fs::tmp::directory;
+
+namespace {
+
+    struct Item : mloader::Definition {
+        str id;
+        int value = 0;
+
+        VISIT() override {
+            VIEW(id);
+            VIEW(value);
+        }
+
+        use const str& identifier() cx override {
+            return id;
+        }
+    };
+
+    void write_text_file(const Path& target, const str& contents) {
+        std::filesystem::create_directories(std::filesystem::path(target.string()).parent_path());
+        std::ofstream stream(target.string(), std::ios::binary | std::ios::trunc | std::ios::out);
+        fassert(stream.is_open(), "failed to open file for writing:", target.string());
+        stream << contents;
+    }
+
+    void register_items(DefinitionRegistry& registry) {
+        registry.register_type("Item", [] {
+            return make_uptr<Item>();
+        });
+    }
+
+    /// Writes `count` files with three items each and resolves them in file order.
+    vec<ResourceHandle> make_sources(FilesystemDatabase& db, const Path& root, usize count) {
+        vec<FilesystemDatabase::PurePath> rels;
+        for (usize i = 0; i < count; ++i) {
+            str yaml;
+            for (usize j = 0; j < 3; ++j) {
+                const usize n = i * 3 + j;
+                yaml += "- type: Item\n  id: item" + std::to_string(n) + "\n  value: " + std::to_string(n) + "\n";
+            }
+            const str rel = "defs/" + std::to_string(i) + ".yml";
+            write_text_file(root / rel, yaml);
+            rels.emplace_back(rel);
+        }
+        db.load();
+        return db.resolve(rels);
+    }
+
+    str ingest_error(DefinitionRegistry& registry, const vec<ResourceHandle>& sources, WorkerPool* pool) {
+        try {
+            if (pool) {
+                registry.ingest(sources, *pool);
+            } else {
+                registry.ingest(sources);
+            }
+        } catch (const RuntimeError& ex) {
+            return ex.what();
+        }
+        return {};
+    }
+
+} // namespace
+
+MTL_TEST(registry, parallel_ingest_matches_serial) {
+    directory temp_dir;
+    FilesystemDatabase db(temp_dir.path());
+    auto sources = make_sources(db, temp_dir.path(), 40);
+
+    DefinitionRegistry serial;
+    register_items(serial);
+    serial.ingest(sources);
+
+    for (usize threads : {1, 3, 8}) {
+        WorkerPool pool(threads);
+        DefinitionRegistry parallel;
+        register_items(parallel);
+        parallel.ingest(sources, pool);
+
+        fassert(parallel.definitions("Item").size() == 120, "unexpected definition count", threads);
+        for (usize n = 0; n < 120; ++n) {
+            const auto* item = dynamic_cast<const Item*>(parallel.find("Item", "item" + std::to_string(n)));
+            fassert(item && item->value == static_cast<int>(n), "missing or wrong item", n, threads);
+        }
+    }
+}
+
+MTL_TEST(registry, parallel_ingest_reports_first_error_in_input_order) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+    write_text_file(root / "defs" / "3a.yml", "type: Item\nid: item1\n");
+    write_text_file(root / "defs" / "3b.yml", "- type: Item\n  id: [broken\n");
+
+    FilesystemDatabase db(root);
+    auto sources = make_sources(db, root, 3);
+    sources.emplace_back(db.resolve(FilesystemDatabase::PurePath("defs/3a.yml")));
+    sources.emplace_back(db.resolve(FilesystemDatabase::PurePath("defs/3b.yml")));
+
+    DefinitionRegistry serial;
+    register_items(serial);
+    const str expected = ingest_error(serial, sources, nullptr);
+    fassert(expected.find("Duplicate definition 'item1'") != str::npos, "unexpected serial error:", expected);
+
+    WorkerPool pool(4);
+    DefinitionRegistry parallel;
+    register_items(parallel);
+    const str actual = ingest_error(parallel, sources, &pool);
+    fassert(actual == expected, "parallel error differs:", actual);
+}
+
+MTL_TEST(registry, binary_cache_round_trips_and_rejects_stale_sources) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+    FilesystemDatabase db(root / "content");
+    std::filesystem::create_directories((root / "content").string());
+    auto sources = make_sources(db, root / "content", 4);
+
+    DefinitionRegistry source;
+    register_items(source);
+    source.ingest(sources);
+
+    const u64 fingerprint = DefinitionRegistry::fingerprint(sources);
+    const Path cache = root / "defs.cache";
+    source.save_cache(cache, fingerprint);
+    fassert(source.save_cache(fingerprint) == source.save_cache(fingerprint), "cache blob should be deterministic");
+
+    DefinitionRegistry warm;
+    register_items(warm);
+    fassert(warm.load_cache(cache, fingerprint), "cache should load for matching sources");
+    fassert(warm.definitions("Item").size() == 12, "unexpected cached definition count");
+    for (usize n = 0; n < 12; ++n) {
+        const auto* item = dynamic_cast<const Item*>(warm.find("Item", "item" + std::to_string(n)));
+        fassert(item && item->value == static_cast<int>(n), "cached item mismatch", n);
+    }
+    const auto cold_order = source.definitions("Item");
+    const auto warm_order = warm.definitions("Item");
+    for (usize i = 0; i < cold_order.size(); ++i) {
+        fassert(warm_order[i]->identifier() == cold_order[i]->identifier(), "a warm start should keep ingest order", i);
+    }
+
+    sources.pop_back();
+    DefinitionRegistry stale;
+    register_items(stale);
+    fassert(!stale.load_cache(cache, DefinitionRegistry::fingerprint(sources)), "stale cache should be rejected");
+    fassert(stale.types().empty(), "rejected cache should not add definitions");
+    fassert(!stale.load_cache(root / "missing.cache", fingerprint), "missing cache should be rejected");
+
+    // A cache that clashes with ingested definitions is rejected as a whole.
+    DefinitionRegistry clashing;
+    register_items(clashing);
+    clashing.ingest(sources.back());
+    bool rejected = false;
+    try {
+        (void)clashing.load_cache(cache, fingerprint);
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected && clashing.definitions("Item").size() == 3, "a clashing cache should not be half loaded");
+
+    // The stat fingerprint follows size and mtime without reading the files.
+    const auto entries = db.list(FilesystemDatabase::PurePath("defs"));
+    const u64 stat_key = DefinitionRegistry::fingerprint(entries);
+    fassert(stat_key == DefinitionRegistry::fingerprint(db.list(FilesystemDatabase::PurePath("defs"))), "stat fingerprint should be stable");
+    write_text_file(root / "content" / "defs" / "0.yml", "- type: Item\n  id: changed\n  value: 1\n");
+    db.refresh({FilesystemDatabase::PurePath("defs/0.yml")});
+    fassert(stat_key != DefinitionRegistry::fingerprint(db.list(FilesystemDatabase::PurePath("defs"))), "a changed file should change the key");
+}
+
+MTL_TEST(registry, keyed_definitions_inherit_parent_data) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    // Children come first and live in another file than their ancestors.
+    write_text_file(root / "defs" / "a.yml",
+                    "leaf:\n  type: Item\n  parent: middle\n  data:\n    value: 3\n"
+                    "sibling:\n  type: Item\n  parent: middle\n");
+    write_text_file(root / "defs" / "b.yml",
+                    "base:\n  type: Item\n  data:\n    value: 1\n"
+                    "middle:\n  type: Item\n  parent: base\n  data:\n    value: 2\n");
+
+    DefinitionRegistry registry;
+    register_items(registry);
+    registry.ingest(vec<Path>{root / "defs" / "a.yml", root / "defs" / "b.yml"});
+
+    const auto value_of = [&](const str& id) {
+        const auto* item = dynamic_cast<const Item*>(registry.find("Item", id));
+        fassert(item != nullptr, "missing item", id);
+        fassert(item->id == id, "identifier should come from the key", item->id);
+        return item->value;
+    };
+    fassert(value_of("base") == 1, "root keeps its own data");
+    fassert(value_of("middle") == 2, "child overrides parent data");
+    fassert(value_of("leaf") == 3, "grandchild overrides inherited data");
+    fassert(value_of("sibling") == 2, "child without data inherits everything");
+
+    // Parents from an earlier ingest call remain available.
+    write_text_file(root / "defs" / "c.yml", "late:\n  type: Item\n  parent: leaf\n");
+    registry.ingest(root / "defs" / "c.yml");
+    fassert(value_of("late") == 3, "late child should inherit from an earlier ingest");
+}
+
+MTL_TEST(registry, cached_keyed_definitions_stay_inheritable) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "base.yml",
+                    "base:\n  type: Item\n  data:\n    value: 1\n"
+                    "middle:\n  type: Item\n  parent: base\n  data:\n    value: 2\n");
+    write_text_file(root / "late.yml", "late:\n  type: Item\n  parent: middle\n");
+
+    DefinitionRegistry cold;
+    register_items(cold);
+    cold.ingest(root / "base.yml");
+    const auto blob = cold.save_cache(7);
+
+    DefinitionRegistry warm;
+    register_items(warm);
+    fassert(warm.load_cache(blob.data(), blob.size(), 7), "cache should load");
+    warm.ingest(root / "late.yml");
+    const auto* late = dynamic_cast<const Item*>(warm.find("Item", "late"));
+    fassert(late && late->value == 2, "a file ingested after a warm start should inherit from cached parents");
+
+    write_text_file(root / "again.yml", "middle:\n  type: Item\n");
+    bool rejected = false;
+    try {
+        warm.ingest(root / "again.yml");
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected, "cached keyed ids should stay taken");
+}
+
+MTL_TEST(registry, keyed_definitions_reject_cycles_and_unknown_parents) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+
+    write_text_file(root / "cycle.yml",
+                    "a:\n  type: Item\n  parent: c\n"
+                    "b:\n  type: Item\n  parent: a\n"
+                    "c:\n  type: Item\n  parent: b\n");
+    write_text_file(root / "orphan.yml", "orphan:\n  type: Item\n  parent: nobody\n");
+
+    const auto error_of = [&](const Path& file) {
+        DefinitionRegistry registry;
+        register_items(registry);
+        try {
+            registry.ingest(file);
+        } catch (const RuntimeError& ex) {
+            return str(ex.what());
+        }
+        return str();
+    };
+
+    const str cycle = error_of(root / "cycle.yml");
+    fassert(cycle.find("inheritance cycle") != str::npos, "cycle should be reported:", cycle);
+    const str orphan = error_of(root / "orphan.yml");
+    fassert(orphan.find("unknown parent 'nobody'") != str::npos, "unknown parent should be reported:", orphan);
+}
+
+MTL_TEST(registry, failed_link_does_not_block_a_corrected_ingest) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+    write_text_file(root / "broken.yml",
+                    "base:\n  type: Item\n  data:\n    value: 4\n"
+                    "child:\n  type: Item\n  parent: missing\n");
+    write_text_file(root / "fixed.yml",
+                    "base:\n  type: Item\n  data:\n    value: 4\n"
+                    "child:\n  type: Item\n  parent: base\n");
+
+    DefinitionRegistry registry;
+    register_items(registry);
+    bool rejected = false;
+    try {
+        registry.ingest(root / "broken.yml");
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected && registry.find("Item", "base") == nullptr, "a failed link should build nothing");
+
+    registry.ingest(root / "fixed.yml");
+    const auto* child = dynamic_cast<const Item*>(registry.find("Item", "child"));
+    fassert(child && child->value == 4, "the corrected entries should link");
+    fassert(registry.definitions("Item").size() == 2, "unexpected definition count", registry.definitions("Item").size());
+}
+
+MTL_TEST(registry, find_accepts_views_and_interned_symbols) {
+    directory temp_dir;
+    FilesystemDatabase db(temp_dir.path());
+    auto sources = make_sources(db, temp_dir.path(), 2);
+
+    DefinitionRegistry registry;
+    register_items(registry);
+    registry.ingest(sources);
+
+    const std::string_view id = "item4";
+    const auto* by_view = registry.find("Item", id);
+    fassert(by_view && by_view->identifier() == "item4", "string_view lookup failed");
+
+    const auto type = registry.type_symbol("Item");
+    const auto symbol = registry.id_symbol(id);
+    fassert(type != mloader::SymbolTable::npos && symbol != mloader::SymbolTable::npos, "symbols should be interned");
+    fassert(registry.find(type, symbol) == by_view, "symbol lookup should match the view lookup");
+
+    fassert(registry.find("Item", "missing") == nullptr, "unknown identifier should not resolve");
+    fassert(registry.find("Missing", id) == nullptr, "unknown type should not resolve");
+    fassert(registry.id_symbol("missing") == mloader::SymbolTable::npos, "lookups must not intern");
+
+    registry.clear();
+    fassert(registry.find(type, symbol) == nullptr, "cleared registry should be empty");
+    registry.ingest(sources);
+    fassert(registry.type_symbol("Item") == type && registry.id_symbol(id) == symbol, "handles should survive clear()");
+    fassert(registry.find(type, symbol) != nullptr, "handles should resolve after re-ingest");
+}
+
+MTL_TEST(registry, each_walks_typed_storage_in_ingest_order) {
+    directory temp_dir;
+    FilesystemDatabase db(temp_dir.path());
+    auto sources = make_sources(db, temp_dir.path(), 3);
+
+    DefinitionRegistry registry;
+    bool rejected = false;
+    try {
+        (void)registry.each<Item>();
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected, "each<T>() should reject types without a typed registration");
+
+    registry.register_type<Item>("Item");
+    registry.ingest(sources, WorkerPool::shared());
+
+    const auto items = registry.each<Item>();
+    fassert(items.size() == 9, "expected nine items, got", items.size());
+    int expected = 0;
+    for (const Item& item : items) {
+        fassert(item.value == expected, "items should be stored in ingest order");
+        fassert(registry.find("Item", item.id) == &item, "find() should return the arena entry");
+        ++expected;
+    }
+    fassert(registry.find<Item>("item4") && registry.find<Item>("item4")->value == 4, "find<T>() should look up by key");
+    fassert(registry.find<Item>("missing") == nullptr, "find<T>() should return null for unknown ids");
+
+    fassert(ingest_error(registry, sources, nullptr).find("Duplicate definition 'item0'") != str::npos,
+            "duplicates should still be rejected");
+
+    registry.clear();
+    fassert(registry.each<Item>().empty(), "clear() should empty the arena");
+    registry.ingest(sources);
+    fassert(registry.each<Item>().size() == 9, "typed registration should survive clear()");
+}
+
+MTL_TEST(registry, reingest_replaces_changed_files_and_relinks_children) {
+    directory temp_dir;
+    Path root = temp_dir.path();
+    write_text_file(root / "base.yml", "base:\n  type: Item\n  data:\n    value: 1\n");
+    write_text_file(root / "child.yml", "child:\n  type: Item\n  parent: base\n");
+    write_text_file(root / "plain.yml", "- type: Item\n  id: plain\n  value: 7\n");
+
+    FilesystemDatabase db(root);
+    db.load();
+    const vec<FilesystemDatabase::PurePath> files{
+        FilesystemDatabase::PurePath("base.yml"), FilesystemDatabase::PurePath("child.yml"),
+        FilesystemDatabase::PurePath("plain.yml"),
+    };
+
+    DefinitionRegistry registry;
+    registry.register_type<Item>("Item");
+    registry.ingest(db, files);
+
+    const auto value_of = [&](const str& id) {
+        const auto* item = static_cast<const Item*>(registry.find("Item", id));
+        return item ? item->value : -1;
+    };
+    fassert(value_of("child") == 1, "child should inherit the base value");
+
+    db.subscribe([&](const vec<FilesystemDatabase::Change>& changes) {
+        vec<FilesystemDatabase::PurePath> changed;
+        for (const auto& change : changes) {
+            if (change.entry == mloader::Database::Entry::Kind::file) {
+                changed.emplace_back(change.path);
+            }
+        }
+        registry.reingest(db, changed);
+    });
+
+    write_text_file(root / "base.yml", "base:\n  type: Item\n  data:\n    value: 5\nextra:\n  type: Item\n");
+    db.refresh({FilesystemDatabase::PurePath("base.yml")});
+    fassert(value_of("base") == 5 && value_of("child") == 5, "children should follow a changed parent");
+    fassert(value_of("extra") == 0 && value_of("plain") == 7, "new entries appear, others stay");
+    fassert(registry.each<Item>().size() == 4, "reingest should not duplicate definitions");
+
+    write_text_file(root / "plain.yml", "- type: Item\n  id: plain\n  value: [broken\n");
+    bool rejected = false;
+    try {
+        db.refresh({FilesystemDatabase::PurePath("plain.yml")});
+    } catch (const RuntimeError&) {
+        rejected = true;
+    }
+    fassert(rejected && value_of("plain") == 7, "a broken file should leave its definitions in place");
+
+    // Link and duplicate errors are caught before anything is dropped, too.
+    write_text_file(root / "base.yml", "base:\n  type: Item\n  data:\n    value: 9\nplain:\n  type: Item\n");
+    rejected = false;
+    try {
+        db.refresh({FilesystemDatabase::PurePath("base.yml")});
+    } catch (const RuntimeError& ex) {
+        rejected = str(ex.what()).find("Duplicate definition 'plain'") != str::npos;
+    }
+    fassert(rejected, "a duplicate id should be rejected");
+    fassert(value_of("base") == 5 && value_of("child") == 5 && value_of("extra") == 0,
+            "a rejected reingest should keep the old definitions");
+    fassert(registry.each<Item>().size() == 4, "a rejected reingest should not add definitions");
+
+    write_text_file(root / "base.yml", "base:\n  type: Item\n  parent: child\n");
+    rejected = false;
+    try {
+        db.refresh({FilesystemDatabase::PurePath("base.yml")});
+    } catch (const RuntimeError& ex) {
+        rejected = str(ex.what()).find("inheritance cycle") != str::npos;
+    }
+    fassert(rejected && value_of("base") == 5 && value_of("child") == 5, "a cycle should leave the registry unchanged");
+
+    write_text_file(root / "base.yml", "base:\n  type: Item\n  data:\n    value: 5\nextra:\n  type: Item\n");
+    db.refresh({FilesystemDatabase::PurePath("base.yml")});
+    fassert(value_of("base") == 5 && value_of("child") == 5, "a later valid reingest should still apply");
+
+    std::filesystem::remove(std::filesystem::path((root / "plain.yml").string()));
+    db.refresh({FilesystemDatabase::PurePath("plain.yml")});
+    fassert(value_of("plain") == -1 && registry.each<Item>().size() == 3, "removed files should drop their definitions");
+}
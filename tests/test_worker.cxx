@@ -0,0 +1,60 @@
+#include "mtl/testing.hxx"
+
+#include "mloader/worker.hxx"
+
+#include "mtl/error.hxx"
+
+#include <atomic>
+
+using mloader::WorkerPool;
+
+MTL_TEST(worker, submit_returns_results) {
+    WorkerPool pool(2);
+
+    auto first = pool.submit([] { return 21 * 2; });
+    auto second = pool.submit([] { return str("done"); });
+
+    fassert(first.get() == 42, "unexpected task result");
+    fassert(second.get() == "done", "unexpected task result");
+}
+
+MTL_TEST(worker, parallel_visits_every_index_once) {
+    WorkerPool pool(4);
+
+    vec<std::atomic<int>> visits(1000);
+    pool.parallel(visits.size(), [&](usize i) {
+        ++visits[i];
+    });
+
+    for (usize i = 0; i < visits.size(); ++i) {
+        fassert(visits[i].load() == 1, "index visited unexpected number of times:", i, visits[i].load());
+    }
+}
+
+MTL_TEST(worker, parallel_rethrows_failures) {
+    WorkerPool pool(2);
+
+    bool threw = false;
+    try {
+        pool.parallel(64, [](usize i) {
+            if (i == 17) {
+                throw RuntimeError("boom");
+            }
+        });
+    } catch (const RuntimeError&) {
+        threw = true;
+    }
+    fassert(threw, "parallel should rethrow task failures");
+}
+
+MTL_TEST(worker, nested_parallel_does_not_deadlock) {
+    WorkerPool pool(1);
+
+    std::atomic<int> total{0};
+    pool.parallel(4, [&](usize) {
+        pool.parallel(4, [&](usize) {
+            ++total;
+        });
+    });
+    fassert(total.load() == 16, "nested parallel lost work", total.load());
+}